@@ -26,7 +26,9 @@
 #define PSID64_H
 
 #include <iostream>
+#include <map>
 #include <string>
+#include <vector>
 
 #include <sidplay/utils/SidDatabase.h>
 #include <sidplay/utils/SidTuneMod.h>
@@ -36,15 +38,305 @@
 //                   F O R W A R D   D E C L A R A T O R S
 //////////////////////////////////////////////////////////////////////////////
 
+class Mutex;
+class OnceFlag;
+class PageMap;
 class Screen;
 class SidId;
 class STIL;
+struct exomizer_ctx;
 
 
 //////////////////////////////////////////////////////////////////////////////
 //                           D E F I N I T I O N S
 //////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Read-only lookup resources that can be shared by any number of Psid64
+ * converters: the STIL database, the song length database and the SID ID
+ * player identification patterns. The set functions only check that the
+ * files exist, each resource is loaded on its first lookup or by load(). The
+ * set functions must not be called while converters are using the object.
+ * The lookup functions may be called from several threads at the same time.
+ */
+class Psid64Resources
+{
+public:
+    /**
+     * Constructor.
+     */
+    Psid64Resources();
+
+    /**
+     * Destructor.
+     */
+    ~Psid64Resources();
+
+    /**
+     * Set the path to the HVSC, which holds the STIL database.
+     */
+    bool setHvscRoot(const std::string &hvscRoot);
+
+    /**
+     * Get the path to the HVSC.
+     */
+    inline const std::string& getHvscRoot() const
+    {
+        return m_hvscRoot;
+    }
+
+    /**
+     * Set the path to the HVSC song length database.
+     */
+    bool setDatabaseFileName(const std::string &databaseFileName);
+
+    /**
+     * Get the path to the HVSC song length database.
+     */
+    inline const std::string getDatabaseFileName() const
+    {
+        return m_databaseFileName;
+    }
+
+    /**
+     * Set the path to the SID ID player identification configuration file.
+     */
+    bool setSidIdConfigFileName(const std::string &sidIdConfigFileName);
+
+    /**
+     * Get the path to the SID ID player identification configuration file.
+     */
+    inline const std::string getSidIdConfigFileName() const
+    {
+        return m_sidIdConfigFileName;
+    }
+
+    /**
+     * Load the resources that have not been loaded yet, e.g. from a
+     * background thread before the first lookups. A resource that cannot
+     * be loaded is disabled, its error is returned by getStilError(),
+     * getDatabaseError() or getSidIdError() and the first error is set as
+     * the status string.
+     */
+    bool load();
+
+    /**
+     * Get the error of the STIL database if it could not be loaded, NULL
+     * otherwise. The result is only meaningful after load() or after a
+     * lookup that needed the resource.
+     */
+    inline const char* getStilError() const
+    {
+        return m_stilError;
+    }
+
+    /**
+     * Get the error of the song length database if it could not be loaded,
+     * NULL otherwise. The result is only meaningful after load() or after
+     * a lookup that needed the resource.
+     */
+    inline const char* getDatabaseError() const
+    {
+        return m_databaseError;
+    }
+
+    /**
+     * Get the error of the SID ID configuration file if it could not be
+     * loaded, NULL otherwise. The result is only meaningful after load() or
+     * after a lookup that needed the resource.
+     */
+    inline const char* getSidIdError() const
+    {
+        return m_sidIdError;
+    }
+
+    /**
+     * Get the status string. After one of the set functions or load() has
+     * failed, the status string contains a description of the error.
+     */
+    inline const char* getStatus() const
+    {
+        return m_statusString;
+    }
+
+    /**
+     * Append the STIL global comment (optional), the STIL entry and the bug
+     * entry of a file to text. The file name is relative to the HVSC root.
+     * On a critical STIL error false is returned and errorString is set.
+     */
+    bool getStilText(const std::string &hvscFileName, bool useGlobalComment,
+                     std::string &text, const char* &errorString) const;
+
+    /**
+     * Get the lengths in seconds of songs 1 to songs from the song length
+     * database. A length smaller than 1 means that it is not known.
+     */
+    void getSongLengths(const char* md5, int_least32_t* lengths,
+                        uint_least16_t songs) const;
+
+    /**
+     * Identify the player routine of the bufferSize bytes of music data in
+     * buffer. The work vector is scratch memory of the caller, which is
+     * reused by the following calls. It must not be shared by threads.
+     */
+    const std::string& identifyPlayer(const uint_least8_t* buffer,
+                                      size_t bufferSize,
+                                      std::vector<size_t>& work) const;
+
+private:
+    Psid64Resources(const Psid64Resources&);
+    Psid64Resources operator=(const Psid64Resources&);
+
+    // error and status message strings
+    static const char* txt_stilNotFound;
+    static const char* txt_databaseNotFound;
+    static const char* txt_sidIdConfigError;
+
+    std::string m_hvscRoot;
+    std::string m_databaseFileName;
+    std::string m_sidIdConfigFileName;
+    const char* m_statusString;
+
+    // The mutex guards the loading of the resources. Once a resource has
+    // been loaded, its flag is set and it is looked up without locking, as
+    // the lookups do not change it.
+    Mutex* m_mutex;
+    mutable SidDatabase m_database;
+    STIL *m_stil;
+    SidId *m_sidId;
+
+    // set when a resource has to be loaded before its first lookup
+    bool m_stilPending;
+    bool m_databasePending;
+    bool m_sidIdPending;
+
+    // set when a pending resource has been loaded, or failed to load
+    OnceFlag* m_stilLoaded;
+    OnceFlag* m_databaseLoaded;
+    OnceFlag* m_sidIdLoaded;
+    mutable const char* m_stilError;
+    mutable const char* m_databaseError;
+    mutable const char* m_sidIdError;
+
+    const char* loadStil() const;
+    const char* loadDatabase() const;
+    const char* loadSidId() const;
+};
+
+
+/**
+ * On-disk cache of compressed C64 executables that is kept across runs.
+ * Every entry is a file named after the hexadecimal MD5 key of the data
+ * that was compressed, stored in a subdirectory named after the first two
+ * characters of the key. When the total size of the entries exceeds the
+ * size limit, the least recently used entries are removed. The cache may
+ * be used from several threads at the same time, and several processes
+ * may share a cache directory.
+ */
+class Psid64Cache
+{
+public:
+    static const unsigned int KEY_LENGTH = 32;  // hexadecimal MD5 digest
+
+    /**
+     * Constructor. The cache is disabled until it is opened.
+     */
+    Psid64Cache();
+
+    /**
+     * Destructor.
+     */
+    ~Psid64Cache();
+
+    /**
+     * Open the cache in directory, which is created when it does not exist
+     * yet, and limit the total size of the entries to maxSize bytes. The
+     * entries that are already in the directory are indexed, the oldest
+     * ones are removed when they exceed the size limit.
+     */
+    bool open(const std::string& directory, uint_least64_t maxSize);
+
+    /**
+     * Check whether the cache has been opened.
+     */
+    inline bool isOpen() const
+    {
+        return !m_directory.empty();
+    }
+
+    /**
+     * Get the cache directory.
+     */
+    inline const std::string& getDirectory() const
+    {
+        return m_directory;
+    }
+
+    /**
+     * Get the size limit of the cache in bytes.
+     */
+    inline uint_least64_t getMaxSize() const
+    {
+        return m_maxSize;
+    }
+
+    /**
+     * Get the status string. After open has failed, the status string
+     * contains a description of the error.
+     */
+    inline const char* getStatus() const
+    {
+        return m_statusString;
+    }
+
+    /**
+     * Read the entry with the given key into buffer. Returns false when
+     * there is no such entry or when it does not fit in bufferSize bytes.
+     * On success the size of the entry is returned in size.
+     */
+    bool lookup(const char* key, uint_least8_t* buffer, size_t bufferSize,
+                size_t& size);
+
+    /**
+     * Store size bytes of data under the given key. Failures to write the
+     * entry are ignored, the data is just not cached.
+     */
+    void store(const char* key, const uint_least8_t* data, size_t size);
+
+private:
+    Psid64Cache(const Psid64Cache&);
+    Psid64Cache operator=(const Psid64Cache&);
+
+    struct Entry
+    {
+        unsigned long size;
+        unsigned long lastUse;  // key in m_lru
+    };
+
+    typedef std::map<std::string, Entry> EntryMap;
+    typedef std::map<unsigned long, std::string> UseMap;
+
+    // error and status message strings
+    static const char* txt_cannotCreateDirectory;
+
+    std::string m_directory;
+    uint_least64_t m_maxSize;
+    const char* m_statusString;
+
+    // index of the entries on disk, guarded by the mutex
+    Mutex* m_mutex;
+    EntryMap m_entries;
+    UseMap m_lru;  // entries in the order of their last use
+    uint_least64_t m_size;  // total size of the entries
+    unsigned long m_useCount;
+    unsigned long m_tempCount;  // for unique names of partial entries
+
+    std::string entryPath(const char* key) const;
+    void index(const std::string& key, unsigned long size);
+    void evict();
+};
+
+
 /**
  * Class to generate a C64 self extracting executable from a PSID file.
  */
@@ -65,32 +357,90 @@ public:
         THEME_RAINBOW
     };
 
+    enum CompressEffort {
+        EFFORT_FAST,
+        EFFORT_NORMAL,
+        EFFORT_MAX
+    };
+
+    enum Layout {
+        LAYOUT_FIRST_FIT,
+        LAYOUT_COMPLETE,
+        LAYOUT_SMALL,
+        LAYOUT_FAST_BOOT
+    };
+
+    enum Phase {
+        PHASE_LOAD,           // reading the SID file
+        PHASE_STIL,           // STIL lookup and formatting
+        PHASE_SONG_LENGTHS,   // MD5 and song length lookup
+        PHASE_LAYOUT,         // memory layout
+        PHASE_DRIVER,         // relocation of the driver
+        PHASE_PLAYER_ID,      // player identification
+        PHASE_BUILD,          // assembling the C64 executable
+        PHASE_COMPRESS,       // Exomizer or cache lookup
+        PHASE_WRITE,          // writing the C64 executable
+        NUM_PHASES
+    };
+
     /**
-     * Constructor.
+     * Statistics of the most recent load, conversion and write. Times are
+     * in microseconds, a phase that did not run has a start time of 0.
+     */
+    struct Stats
+    {
+        uint_least64_t phaseStart[NUM_PHASES];
+        unsigned long phaseTime[NUM_PHASES];
+        size_t stilBytes;         // size of the formatted STIL text
+        int compressPasses;       // Exomizer search passes
+        unsigned long matchesEvaluated;  // by the Exomizer searches
+        bool compressCached;      // compressed file taken from the cache
+    };
+
+    /**
+     * Constructor. The converter owns its lookup resources, which are loaded
+     * by the set functions below, so that these fail for a file that cannot
+     * be loaded.
      */
     Psid64();
 
+    /**
+     * Constructor. The converter borrows the lookup resources, which must
+     * remain valid for the lifetime of the converter. Converters that share
+     * resources can be used from different threads at the same time.
+     */
+    explicit Psid64(const Psid64Resources& resources);
+
     /**
      * Destructor.
      */
     ~Psid64();
 
+    /**
+     * Get the lookup resources used by this converter.
+     */
+    inline const Psid64Resources& getResources() const
+    {
+        return *m_resources;
+    }
+
     /**
      * Set the path to the HVSC. This path is e.g. used to retrieve the STIL
-     * information for a PSID file.
+     * information for a PSID file. Fails when the resources are borrowed.
      */
     bool setHvscRoot(const std::string &hvscRoot);
 
     /**
      * Get the path to the HVSC.
      */
-    inline const std::string getHvscRoot() const
+    inline const std::string& getHvscRoot() const
     {
-        return m_hvscRoot;
+        return m_resources->getHvscRoot();
     }
 
     /**
-     * Set the path to the HVSC song length database.
+     * Set the path to the HVSC song length database. Fails when the
+     * resources are borrowed.
      */
     bool setDatabaseFileName(const std::string &databaseFileName);
 
@@ -99,11 +449,12 @@ public:
      */
     inline const std::string getDatabaseFileName() const
     {
-        return m_databaseFileName;
+        return m_resources->getDatabaseFileName();
     }
 
     /**
      * Set the path to the SID ID player identification configuration file.
+     * Fails when the resources are borrowed.
      */
     bool setSidIdConfigFileName(const std::string &sidIdConfigFileName);
 
@@ -112,7 +463,7 @@ public:
      */
     inline const std::string getSidIdConfigFileName() const
     {
-        return m_sidIdConfigFileName;
+        return m_resources->getSidIdConfigFileName();
     }
 
     /**
@@ -169,6 +520,82 @@ public:
         return m_compress;
     }
 
+    /**
+     * Set the compression effort. EFFORT_FAST compresses considerably
+     * faster at the cost of a slightly larger output file, EFFORT_MAX tries
+     * harder than the default EFFORT_NORMAL to find a smaller output file.
+     */
+    inline void setCompressEffort(CompressEffort compressEffort)
+    {
+        m_compressEffort = compressEffort;
+    }
+
+    /**
+     * Get the compression effort.
+     */
+    inline CompressEffort getCompressEffort() const
+    {
+        return m_compressEffort;
+    }
+
+    /**
+     * Set the memory layout objective. LAYOUT_FIRST_FIT takes the first
+     * screen position with room for the driver in a fixed order. The other
+     * objectives compare all feasible layouts of the screen, character set,
+     * driver, STIL text and song lengths. They all keep as many of the STIL
+     * text and song lengths as fit: of those layouts LAYOUT_COMPLETE takes
+     * the first one found, LAYOUT_SMALL the smallest C64 executable and
+     * LAYOUT_FAST_BOOT the one that copies the fewest bytes at boot time.
+     */
+    inline void setLayout(Layout layout)
+    {
+        m_layout = layout;
+    }
+
+    /**
+     * Get the memory layout objective.
+     */
+    inline Layout getLayout() const
+    {
+        return m_layout;
+    }
+
+    /**
+     * Allow LAYOUT_SMALL and LAYOUT_FAST_BOOT to leave out the STIL text and
+     * song lengths when that makes the C64 executable smaller or faster to
+     * boot.
+     */
+    inline void setLeaveOutBlocks(bool leaveOutBlocks)
+    {
+        m_leaveOutBlocks = leaveOutBlocks;
+    }
+
+    /**
+     * Check whether the STIL text and song lengths may be left out.
+     */
+    inline bool getLeaveOutBlocks() const
+    {
+        return m_leaveOutBlocks;
+    }
+
+    /**
+     * Set the cache of compressed C64 executables, NULL to disable it. The
+     * cache is borrowed and must remain valid for as long as it is in use
+     * by this object. It may be shared by converters in different threads.
+     */
+    inline void setCache(Psid64Cache* cache)
+    {
+        m_cache = cache;
+    }
+
+    /**
+     * Get the cache of compressed C64 executables, NULL if none.
+     */
+    inline Psid64Cache* getCache() const
+    {
+        return m_cache;
+    }
+
     /**
      * Set the initial song number. When 0 or larger than the total number of
      * songs, the initial song as specified in the SID file header is used.
@@ -181,7 +608,7 @@ public:
     /**
      * Get the initial song.
      */
-    inline int getInitialSong()
+    inline int getInitialSong() const
     {
         return m_initialSong;
     }
@@ -220,6 +647,24 @@ public:
         return m_verbose;
     }
 
+    /**
+     * Set the stream to which verbose output and warnings are written. By
+     * default this is the standard error stream. The stream must remain
+     * valid for as long as it is in use by this object.
+     */
+    inline void setLogStream(std::ostream& logStream)
+    {
+        m_logStream = &logStream;
+    }
+
+    /**
+     * Get the stream to which verbose output and warnings are written.
+     */
+    inline std::ostream& getLogStream() const
+    {
+        return *m_logStream;
+    }
+
     /**
      * Set the theme.
      */
@@ -231,7 +676,7 @@ public:
     /**
      * Get the theme.
      */
-    inline Theme getTheme()
+    inline Theme getTheme() const
     {
         return m_theme;
     }
@@ -245,11 +690,60 @@ public:
         return m_statusString;
     }
 
+    /**
+     * Get the number of bytes of memory used for compression. The memory is
+     * allocated by the first compression and reused by the following ones,
+     * so this is also the peak memory usage of the compressor.
+     */
+    size_t getCompressionMemory() const;
+
+    /**
+     * Get the number of bytes copied by the most recent conversion. The
+     * music data is read where it is in the loaded file and is copied only
+     * once, into the C64 executable. The other bytes are the relocated
+     * driver and boot code and the data placed next to the music.
+     */
+    inline size_t getBytesCopied() const
+    {
+        return m_bytesCopied;
+    }
+
+    /**
+     * Get the statistics of the most recent load, conversion and write. A
+     * load resets all statistics, a conversion all but those of the load.
+     */
+    inline const Stats& getStats() const
+    {
+        return m_stats;
+    }
+
+    /**
+     * Get the name of a phase, e.g. "compress".
+     */
+    static const char* getPhaseName(Phase phase);
+
+    /**
+     * Get the current time in microseconds, as used for the statistics.
+     * The time is taken from a monotonic clock where the system has one.
+     * Only the difference between two times is meaningful.
+     */
+    static uint_least64_t getMicroseconds();
+
     /**
      * Load a PSID file.
      */
     bool load(const char* fileName);
 
+    /**
+     * Load a PSID file from a memory buffer. The data is copied, so the
+     * buffer may be reused as soon as this function returns. The optional
+     * hvscFileName is the path of the file relative to the HVSC root, e.g.
+     * "/MUSICIANS/H/Hubbard_Rob/Commando.sid", and is used to look up its
+     * STIL entry. Without it the STIL entry is left out.
+     */
+    bool load(const uint_least8_t* data, uint_least32_t dataLen,
+              const char* hvscFileName = NULL);
+
     /**
      * Convert the currently loaded PSID file.
      */
@@ -265,6 +759,32 @@ public:
      */
     bool write(std::ostream& out = std::cout);
 
+    /**
+     * Copy the C64 executable to a caller supplied buffer of bufferSize
+     * bytes. The size of the C64 executable is returned in programSize,
+     * also when the buffer is too small, so that the call can be repeated
+     * with a larger buffer.
+     */
+    bool write(uint_least8_t* buffer, size_t bufferSize, size_t& programSize);
+
+    /**
+     * Get the most recently generated C64 executable, NULL if none. The
+     * data remains valid until the next conversion or until this object is
+     * destroyed.
+     */
+    inline const uint_least8_t* getProgramData() const
+    {
+        return m_programData;
+    }
+
+    /**
+     * Get the size of the most recently generated C64 executable.
+     */
+    inline size_t getProgramSize() const
+    {
+        return m_programData ? m_programSize : 0;
+    }
+
 private:
     Psid64(const Psid64&);
     Psid64 operator=(const Psid64&);
@@ -275,30 +795,39 @@ private:
     static const unsigned int NUM_EXTDRV_PAGES = 5;  // driver with screen display
     static const unsigned int NUM_SCREEN_PAGES = 4;  // size of screen in pages
     static const unsigned int NUM_CHAR_PAGES = 4;  // size of charset in pages
+    static const unsigned int MAX_SCREEN_PLACES = 4 * 16 * 8;  // banks, screens, charsets
     static const unsigned int STIL_EOT_SPACES = 10;  // number of spaces before EOT
     static const unsigned int BAR_X = 15;
     static const unsigned int BAR_WIDTH = 19;
     static const unsigned int BAR_SPRITE_SCREEN_OFFSET = 0x300;
+    static const unsigned int PROGRAM_BUFFER_SIZE = 2 + 0x10000;  // load address and C64 memory
+    static const unsigned int COMPRESS_BUFFER_SIZE = 0x10000;
 
     // error and status message strings
     static const char* txt_relocOverlapsImage;
     static const char* txt_notEnoughC64Memory;
     static const char* txt_fileIoError;
+    static const char* txt_bufferTooSmall;
     static const char* txt_noSidTuneLoaded;
     static const char* txt_noSidTuneConverted;
-    static const char* txt_sidIdConfigError;
+    static const char* txt_sharedResources;
+    static const char* txt_outOfMemory;
+    static const char* txt_compressOutOfMemory;
+    static const char* txt_compressLoadAddress;
 
     // configuration options
     bool m_noDriver;
     bool m_blankScreen;
     bool m_compress;
+    CompressEffort m_compressEffort;
+    Layout m_layout;
+    bool m_leaveOutBlocks;
     int m_initialSong;
     bool m_useGlobalComment;
     bool m_verbose;
-    std::string m_hvscRoot;
-    std::string m_databaseFileName;
-    std::string m_sidIdConfigFileName;
+    std::ostream* m_logStream;
     Theme m_theme;
+    Psid64Cache* m_cache;
 
     // state data
     bool m_status;
@@ -306,15 +835,17 @@ private:
 
     // other internal data
     std::string m_fileName;
+    std::string m_hvscFileName;  // path relative to the HVSC root, if known
     SidTuneMod m_tune;
     SidTuneInfo m_tuneInfo;
-    SidDatabase m_database;
-    STIL *m_stil;
-    SidId *m_sidId;
+    Psid64Resources* m_ownResources;  // NULL when the resources are borrowed
+    const Psid64Resources* m_resources;
 
     // conversion data
     Screen *m_screen;
     std::string m_stilText;
+    std::string m_stilPath;  // path of the STIL entry relative to the HVSC root
+    std::string m_stilEntries;  // STIL text before formatting
     uint_least8_t m_songlengthsData[4 * SIDTUNE_MAX_SONGS];
     size_t m_songlengthsSize;
     uint_least8_t m_driverPage;  // startpage of driver, 0 means no driver
@@ -323,38 +854,49 @@ private:
     uint_least8_t m_stilPage;  // startpage of stil, 0 means no stil
     uint_least8_t m_songlengthsPage;  // startpage of song length data, 0 means no song lengths
     std::string m_playerId;
-
-    // converted file
-    uint_least8_t *m_programData;
+    std::vector<size_t> m_sidIdWork;  // player identification state
+    std::vector<uint_least8_t> m_driverCode;  // driver being relocated
+    std::vector<int> m_globals;  // label values for the relocation
+    Theme m_globalsTheme;  // theme of the colors in m_globals
+
+    // converted file, the buffers are allocated by the first conversion and
+    // reused by the following ones
+    uint_least8_t *m_programBuffer;
+    uint_least8_t *m_compressBuffer;
+    uint_least8_t *m_programData;  // m_programBuffer or m_compressBuffer
     unsigned int m_programSize;
+    size_t m_bytesCopied;
+    Stats m_stats;
+
+    // Exomizer working state, allocated on first use
+    exomizer_ctx *m_exomizer;
 
     // member functions
     int_least32_t roundDiv(int_least32_t dividend, int_least32_t divisor);
+    unsigned int getC64DataLen() const;
+    void copyBytes(uint_least8_t* dest, const uint_least8_t* src, size_t size);
+    void initProgramData(unsigned int size);
+    void resetStats(bool keepLoad);
+    void recordPhase(Phase phase, uint_least64_t start);
+    int* initGlobals();
     bool convertNoDriver();
     bool convertBASIC();
     bool formatStilText();
     bool getSongLengths();
-    uint_least8_t findSonglengthsSpace(const bool* pages, uint_least8_t scr,
-                                       uint_least8_t chars,
-                                       uint_least8_t driver,
-                                       uint_least8_t stil,
-                                       uint_least8_t stil_pages,
-                                       uint_least8_t size) const;
-    uint_least8_t findStilSpace(const bool* pages, uint_least8_t scr,
-                                uint_least8_t chars,
-                                uint_least8_t driver,
-                                uint_least8_t size) const;
-    uint_least8_t findDriverSpace(const bool* pages, uint_least8_t scr,
-                                  uint_least8_t chars,
-                                  uint_least8_t size) const;
     void findFreeSpace();
+    static unsigned int findScreenPlaces(const PageMap& pages,
+                                         uint_least8_t* screens,
+                                         uint_least8_t* chars);
+    void placeDriver(PageMap& pages, uint_least8_t driver,
+                     uint_least8_t stilSize, uint_least8_t songlengthsSize);
+    bool planLayout(const PageMap& pages, uint_least8_t stilSize,
+                    uint_least8_t songlengthsSize);
     uint8_t iomap(uint_least16_t addr);
-    void initDriver(uint_least8_t** mem, uint_least8_t** ptr, int* n);
-    void addFlag(bool &hasFlags, const std::string &flagName);
+    void initDriver(uint_least8_t** ptr, int* n);
+    void addFlag(bool &hasFlags, const char* flagName);
     std::string toHexWord(uint_least16_t value) const;
-    std::string toNumStr(int value) const;
     void drawScreen();
-    bool compress();
+    bool compress(uint_least16_t loadAddr, uint_least16_t startAddr);
 };
 
 
@@ -216,6 +216,12 @@ class SID_EXTERN SidTune
     // Copy sidtune into C64 memory (64 KB).
     bool placeSidTuneInC64mem(uint_least8_t* c64buf);
 
+    // Read-only view of the C64 data in the cached file, i.e. the
+    // ``info.c64dataLen'' bytes that placeSidTuneInC64mem() copies to
+    // ``info.loadAddr''. The MUS player is not included.
+    // Returns 0, if no sidtune is loaded.
+    const uint_least8_t* getC64Data() const;
+
     // --- file save & format conversion ---
 
     // These functions work for any successfully created object.
@@ -20,8 +20,13 @@
 #define _siddatabase_h_
 
 #include "SidTuneMod.h"
-#include "libini.h"
 
+// The song length database is looked up through a binary index that is
+// stored next to the database file (Songlengths.md5.idx). The index is an
+// open addressing hash table keyed on the binary MD5 fingerprint, followed
+// by the packed song lengths in seconds. It is rebuilt when the size or the
+// modification time of the database does not match and is memory mapped
+// where possible.
 class SID_EXTERN SidDatabase
 {
 private:
@@ -31,20 +36,36 @@ private:
     static const char *ERR_MEM_ALLOC;
     static const char *ERR_UNABLE_TO_LOAD_DATABASE;
 
-    ini_fd_t    database;
+    uint8_t    *index;        // index file contents
+    size_t      indexSize;
+    bool        indexMapped;  // index is memory mapped, otherwise new[]
     const char *errorString;
 
-    int_least32_t parseTimeStamp (const char* arg);
-    uint_least8_t timesFound     (char *str);
+    static int_least32_t parseTimeStamp (const char* arg);
+    static uint_least8_t timesFound     (char *str);
+
+    bool loadIndex  (const char *indexName, uint_least64_t dbSize,
+                     int_least64_t dbTime);
+    bool buildIndex (const char *filename, uint_least64_t dbSize,
+                     int_least64_t dbTime);
+    void saveIndex  (const char *indexName);
+    const uint16_t *findEntry (const char *md5, uint32_t &count) const;
 
 public:
-    SidDatabase  () : database (0), errorString(NULL) {;}
+    SidDatabase  () : index (0), indexSize (0), indexMapped (false),
+                      errorString(NULL) {;}
     ~SidDatabase ();
 
     int           open   (const char *filename);
     void          close  ();
     int_least32_t length (SidTuneMod &tune);
     int_least32_t length (const char *md5, uint_least16_t song);
+    // Get the lengths of songs 1 to songs in one lookup. Each entry is set
+    // to the value length (md5, song) would return. Returns -1 when no
+    // database is loaded. Unlike length () it does not set the error
+    // string, so that several threads may look up lengths at once.
+    int           lengths (const char *md5, int_least32_t *lengths,
+                           uint_least16_t songs) const;
     const char *  error  (void) { return errorString; }
 };
 
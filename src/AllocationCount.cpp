@@ -0,0 +1,158 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+    psid64 - create a C64 executable from a PSID file
+    Copyright (C) 2001-2023  Roland Hermans <rolandh@users.sourceforge.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+//////////////////////////////////////////////////////////////////////////////
+//                             I N C L U D E S
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "AllocationCount.h"
+
+#ifdef COUNT_ALLOCATIONS
+#include <cstdlib>
+#include <new>
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                     L O C A L   D E F I N I T I O N S
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef COUNT_ALLOCATIONS
+
+#if __cplusplus >= 201103L
+#define THROW_BAD_ALLOC
+#define THROW_NOTHING noexcept
+#else
+#define THROW_BAD_ALLOC throw(std::bad_alloc)
+#define THROW_NOTHING throw()
+#endif
+
+// Every thread converts its own files, so the allocations are counted per
+// thread.
+static __thread unsigned long s_allocationCount = 0;
+
+static void* countedAlloc(std::size_t size);
+
+#endif // COUNT_ALLOCATIONS
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                       L O C A L   F U N C T I O N S
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef COUNT_ALLOCATIONS
+
+static void*
+countedAlloc(std::size_t size)
+{
+    ++s_allocationCount;
+    return std::malloc(size ? size : 1);
+}
+
+#endif // COUNT_ALLOCATIONS
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                      G L O B A L   F U N C T I O N S
+//////////////////////////////////////////////////////////////////////////////
+
+unsigned long
+getAllocationCount()
+{
+#ifdef COUNT_ALLOCATIONS
+    return s_allocationCount;
+#else
+    return 0;
+#endif
+}
+
+
+#ifdef COUNT_ALLOCATIONS
+
+void*
+operator new(std::size_t size) THROW_BAD_ALLOC
+{
+    void* p = countedAlloc(size);
+    if (p == NULL)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+
+void*
+operator new[](std::size_t size) THROW_BAD_ALLOC
+{
+    void* p = countedAlloc(size);
+    if (p == NULL)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+
+void*
+operator new(std::size_t size, const std::nothrow_t&) THROW_NOTHING
+{
+    return countedAlloc(size);
+}
+
+
+void*
+operator new[](std::size_t size, const std::nothrow_t&) THROW_NOTHING
+{
+    return countedAlloc(size);
+}
+
+
+void
+operator delete(void* p) THROW_NOTHING
+{
+    std::free(p);
+}
+
+
+void
+operator delete[](void* p) THROW_NOTHING
+{
+    std::free(p);
+}
+
+
+void
+operator delete(void* p, const std::nothrow_t&) THROW_NOTHING
+{
+    std::free(p);
+}
+
+
+void
+operator delete[](void* p, const std::nothrow_t&) THROW_NOTHING
+{
+    std::free(p);
+}
+
+#endif // COUNT_ALLOCATIONS
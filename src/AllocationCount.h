@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+    psid64 - create a C64 executable from a PSID file
+    Copyright (C) 2001-2023  Roland Hermans <rolandh@users.sourceforge.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef ALLOCATIONCOUNT_H
+#define ALLOCATIONCOUNT_H
+
+//////////////////////////////////////////////////////////////////////////////
+//                  F U N C T I O N   D E C L A R A T O R S
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Get the number of heap allocations made with operator new by the calling
+ * thread. The allocations are only counted when psid64 is configured with
+ * --enable-allocation-count, otherwise 0 is returned.
+ */
+extern unsigned long getAllocationCount();
+
+#endif // ALLOCATIONCOUNT_H
@@ -0,0 +1,346 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+    psid64 - create a C64 executable from a PSID file
+    Copyright (C) 2001-2023  Roland Hermans <rolandh@users.sourceforge.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+//////////////////////////////////////////////////////////////////////////////
+//                             I N C L U D E S
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "BatchStats.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+
+using std::endl;
+using std::ofstream;
+using std::ostream;
+using std::setw;
+using std::string;
+using std::vector;
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                     L O C A L   F U N C T I O N S
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Format a time in microseconds as milliseconds.
+ */
+static string
+formatMs(unsigned long time)
+{
+    char str[32];
+    sprintf(str, "%.3f", time / 1000.0);
+    return str;
+}
+
+
+/**
+ * Get the value at percentile p of sorted values, by the nearest rank.
+ */
+static unsigned long
+percentile(const vector<unsigned long>& values, unsigned int p)
+{
+    size_t rank = (values.size() * p + 99) / 100;
+    return values[(rank > 0) ? (rank - 1) : 0];
+}
+
+
+static string
+quoteCsv(const string& text)
+{
+    if (text.find_first_of(",\"\n") == string::npos)
+    {
+        return text;
+    }
+    string quoted("\"");
+    for (string::const_iterator it = text.begin(); it != text.end(); ++it)
+    {
+        if (*it == '"')
+        {
+            quoted += '"';
+        }
+        quoted += *it;
+    }
+    quoted += '"';
+    return quoted;
+}
+
+
+static string
+quoteJson(const string& text)
+{
+    string quoted("\"");
+    for (string::const_iterator it = text.begin(); it != text.end(); ++it)
+    {
+        const unsigned char c = *it;
+        if ((c == '"') || (c == '\\'))
+        {
+            quoted += '\\';
+            quoted += c;
+        }
+        else if (c < 0x20)
+        {
+            char str[8];
+            sprintf(str, "\\u%04x", c);
+            quoted += str;
+        }
+        else
+        {
+            quoted += c;
+        }
+    }
+    quoted += '"';
+    return quoted;
+}
+
+
+static bool
+hasPhase(const Psid64::Stats& stats, int phase)
+{
+    return stats.phaseStart[phase] != 0;
+}
+
+
+static bool
+endsWith(const string& text, const string& suffix)
+{
+    return (text.length() >= suffix.length())
+           && (text.compare(text.length() - suffix.length(), string::npos,
+                            suffix) == 0);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//               P U B L I C   M E M B E R   F U N C T I O N S
+//////////////////////////////////////////////////////////////////////////////
+
+// constructor
+
+BatchStats::BatchStats() :
+    m_records()
+{
+}
+
+// destructor
+
+BatchStats::~BatchStats()
+{
+}
+
+
+BatchStats::Record
+BatchStats::makeRecord(const string& fileName, bool ok, unsigned long time,
+                       const Psid64& psid64)
+{
+    Record record;
+    record.fileName = fileName;
+    record.ok = ok;
+    record.time = time;
+    record.bytesCopied = psid64.getBytesCopied();
+    record.stats = psid64.getStats();
+    return record;
+}
+
+
+void
+BatchStats::printRecord(ostream& out, const Record& record)
+{
+    const Psid64::Stats& stats = record.stats;
+    out << "Statistics of `" << record.fileName << "':";
+    for (int phase = 0; phase < Psid64::NUM_PHASES; ++phase)
+    {
+        if (hasPhase(stats, phase))
+        {
+            out << " " << Psid64::getPhaseName(static_cast<Psid64::Phase>(phase))
+                << " " << formatMs(stats.phaseTime[phase]) << " ms,";
+        }
+    }
+    out << " total " << formatMs(record.time) << " ms, "
+        << record.bytesCopied << " bytes copied, "
+        << stats.stilBytes << " STIL bytes";
+    if (hasPhase(stats, Psid64::PHASE_COMPRESS))
+    {
+        if (stats.compressCached)
+        {
+            out << ", compressed file from cache";
+        }
+        else
+        {
+            out << ", " << stats.compressPasses << " compression passes, "
+                << stats.matchesEvaluated << " matches evaluated";
+        }
+    }
+    if (!record.ok)
+    {
+        out << ", failed";
+    }
+    out << endl;
+}
+
+
+void
+BatchStats::add(const Record& record)
+{
+    m_records.push_back(record);
+}
+
+
+void
+BatchStats::printSummary(ostream& out) const
+{
+    out << "phase          count    total ms      p50 ms      p90 ms      p99 ms      max ms"
+        << endl;
+    for (int phase = 0; phase <= Psid64::NUM_PHASES; ++phase)
+    {
+        // the last row holds the total conversion times
+        vector<unsigned long> times;
+        for (vector<Record>::const_iterator it = m_records.begin();
+             it != m_records.end(); ++it)
+        {
+            if (phase == Psid64::NUM_PHASES)
+            {
+                times.push_back(it->time);
+            }
+            else if (hasPhase(it->stats, phase))
+            {
+                times.push_back(it->stats.phaseTime[phase]);
+            }
+        }
+        if (times.empty())
+        {
+            continue;
+        }
+        std::sort(times.begin(), times.end());
+        unsigned long total = 0;
+        for (vector<unsigned long>::const_iterator it = times.begin();
+             it != times.end(); ++it)
+        {
+            total += *it;
+        }
+
+        const char* name = (phase == Psid64::NUM_PHASES)
+            ? "total" : Psid64::getPhaseName(static_cast<Psid64::Phase>(phase));
+        out << std::left << setw(12) << name << std::right
+            << setw(8) << times.size()
+            << setw(12) << formatMs(total)
+            << setw(12) << formatMs(percentile(times, 50))
+            << setw(12) << formatMs(percentile(times, 90))
+            << setw(12) << formatMs(percentile(times, 99))
+            << setw(12) << formatMs(times.back()) << endl;
+    }
+}
+
+
+bool
+BatchStats::write(const string& fileName) const
+{
+    ofstream out(fileName.c_str());
+    if (endsWith(fileName, ".json"))
+    {
+        writeJson(out);
+    }
+    else
+    {
+        writeCsv(out);
+    }
+    out.close();
+    return !out.fail();
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//              P R I V A T E   M E M B E R   F U N C T I O N S
+//////////////////////////////////////////////////////////////////////////////
+
+void
+BatchStats::writeCsv(ostream& out) const
+{
+    // times are in microseconds, a phase that did not run is left empty
+    out << "file,ok";
+    for (int phase = 0; phase < Psid64::NUM_PHASES; ++phase)
+    {
+        out << "," << Psid64::getPhaseName(static_cast<Psid64::Phase>(phase));
+    }
+    out << ",total,bytes_copied,stil_bytes,compress_passes,matches_evaluated,"
+        << "compress_cached\n";
+
+    for (vector<Record>::const_iterator it = m_records.begin();
+         it != m_records.end(); ++it)
+    {
+        const Psid64::Stats& stats = it->stats;
+        out << quoteCsv(it->fileName) << "," << (it->ok ? 1 : 0);
+        for (int phase = 0; phase < Psid64::NUM_PHASES; ++phase)
+        {
+            out << ",";
+            if (hasPhase(stats, phase))
+            {
+                out << stats.phaseTime[phase];
+            }
+        }
+        out << "," << it->time
+            << "," << it->bytesCopied
+            << "," << stats.stilBytes
+            << "," << stats.compressPasses
+            << "," << stats.matchesEvaluated
+            << "," << (stats.compressCached ? 1 : 0) << "\n";
+    }
+}
+
+
+void
+BatchStats::writeJson(ostream& out) const
+{
+    // times are in microseconds, a phase that did not run is left out
+    out << "[";
+    for (vector<Record>::const_iterator it = m_records.begin();
+         it != m_records.end(); ++it)
+    {
+        const Psid64::Stats& stats = it->stats;
+        out << ((it == m_records.begin()) ? "\n" : ",\n")
+            << "  {\"file\": " << quoteJson(it->fileName)
+            << ", \"ok\": " << (it->ok ? "true" : "false")
+            << ", \"phases\": {";
+        bool first = true;
+        for (int phase = 0; phase < Psid64::NUM_PHASES; ++phase)
+        {
+            if (hasPhase(stats, phase))
+            {
+                out << (first ? "" : ", ") << "\""
+                    << Psid64::getPhaseName(static_cast<Psid64::Phase>(phase))
+                    << "\": " << stats.phaseTime[phase];
+                first = false;
+            }
+        }
+        out << "}, \"total\": " << it->time
+            << ", \"bytes_copied\": " << it->bytesCopied
+            << ", \"stil_bytes\": " << stats.stilBytes
+            << ", \"compress_passes\": " << stats.compressPasses
+            << ", \"matches_evaluated\": " << stats.matchesEvaluated
+            << ", \"compress_cached\": "
+            << (stats.compressCached ? "true" : "false") << "}";
+    }
+    out << "\n]\n";
+}
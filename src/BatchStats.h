@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+    psid64 - create a C64 executable from a PSID file
+    Copyright (C) 2001-2023  Roland Hermans <rolandh@users.sourceforge.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef BATCHSTATS_H
+#define BATCHSTATS_H
+
+//////////////////////////////////////////////////////////////////////////////
+//                             I N C L U D E S
+//////////////////////////////////////////////////////////////////////////////
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <psid64/psid64.h>
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                           D E F I N I T I O N S
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Statistics of the conversions of a run, one record per converted file.
+ * Records are added by the thread that reports the conversions, in the
+ * order of the files.
+ */
+class BatchStats
+{
+public:
+    struct Record
+    {
+        std::string fileName;
+        bool ok;
+        unsigned long time;        // total conversion time in microseconds
+        size_t bytesCopied;
+        Psid64::Stats stats;
+    };
+
+    BatchStats();
+    ~BatchStats();
+
+    /**
+     * Take the statistics of the most recent conversion by psid64, which
+     * took time microseconds.
+     */
+    static Record makeRecord(const std::string& fileName, bool ok,
+                             unsigned long time, const Psid64& psid64);
+
+    /**
+     * Print the statistics of a single file on one line.
+     */
+    static void printRecord(std::ostream& out, const Record& record);
+
+    void add(const Record& record);
+
+    /**
+     * Print a table with the count, total time and time percentiles of
+     * every phase.
+     */
+    void printSummary(std::ostream& out) const;
+
+    /**
+     * Write all records to a file, in JSON format when the name of the
+     * file ends in ".json" and as comma separated values otherwise.
+     */
+    bool write(const std::string& fileName) const;
+
+private:
+    std::vector<Record> m_records;
+
+    void writeCsv(std::ostream& out) const;
+    void writeJson(std::ostream& out) const;
+};
+
+#endif // BATCHSTATS_H
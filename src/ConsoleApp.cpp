@@ -23,6 +23,9 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include "ConsoleApp.h"
+#include "AllocationCount.h"
+#include "Manifest.h"
+#include "TraceLog.h"
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -44,13 +47,44 @@
 #include <unistd.h>
 #endif
 
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+
+#ifdef HAVE_SIGNAL_H
+#include <signal.h>
+#endif
+
+#ifdef HAVE_SYS_SOCKET_H
+#include <sys/socket.h>
+#endif
+
+#ifdef HAVE_SYS_UN_H
+#include <sys/un.h>
+#endif
+
+#ifdef HAVE_POLL_H
+#include <poll.h>
+#endif
+
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+
 #include <dirent.h>
 #include <errno.h>
 
 #include <algorithm>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <map>
 #include <sstream>
+#include <utility>
 #include <vector>
 
 using std::cerr;
@@ -58,12 +92,20 @@ using std::cout;
 using std::endl;
 using std::istringstream;
 using std::map;
+using std::ostream;
+using std::ostringstream;
 using std::sort;
 using std::string;
 using std::vector;
 
-#define STR_GETOPT_OPTIONS              ":bcghi:no:p:r:s:t:vV"
+#define STR_GETOPT_OPTIONS              ":bcC:D:e:F:ghIi:j:Ll:m:no:p:r:Ss:T:t:vV"
 #define ACCEPTED_PATH_SEPARATORS        "/\\"
+#define MANIFEST_FILE_NAME              ".psid64-manifest"
+#define MAX_REQUEST_LINE                4096
+#define MAX_REQUEST_DATA                (1024 * 1024)
+#define MAX_CONNECTIONS                 64
+#define MAX_CACHE_SIZE                  (~static_cast<uint_least64_t>(0))
+#define CONNECTION_TIMEOUT              60      // seconds
 
 #ifdef _WIN32
 #define PATH_SEPARATOR                  "\\"
@@ -91,7 +133,214 @@ using std::vector;
 #endif
 #endif
 
-typedef map<string, Psid64::Theme> ThemesMap;
+#if defined(HAVE_DIRFD) && defined(HAVE_FDOPENDIR) && defined(HAVE_FSTATAT) \
+    && defined(HAVE_OPENAT)
+#define HAVE_DIRECTORY_FDS
+#endif
+
+#if defined(HAVE_PTHREAD_H) && defined(HAVE_SIGNAL_H) \
+    && defined(HAVE_SYS_SOCKET_H) && defined(HAVE_SYS_UN_H) \
+    && defined(HAVE_SYS_TIME_H) && defined(HAVE_POLL_H) && defined(HAVE_FCNTL_H)
+#define HAVE_CONVERSION_SERVER
+#endif
+
+#ifdef HAVE_PTHREAD_H
+/**
+ * State of a directory conversion that is shared by the worker threads.
+ * Workers take the jobs in order, the main thread reports the results in
+ * that same order.
+ */
+struct ConsoleApp::Batch
+{
+    struct Result
+    {
+        bool done;
+        bool ok;
+        unsigned long time;
+        BatchStats::Record stats;
+        string log;
+    };
+
+    ConsoleApp* app;
+    const vector<ConvertJob>* jobs;
+    OutputDirs* outputDirs;
+    vector<size_t> order;  // indices of the jobs in the order they are started
+    vector<Result> results;
+    size_t nextJob;
+    bool abort;
+    pthread_mutex_t mutex;
+    pthread_cond_t jobDone;
+};
+
+
+/**
+ * Worker thread with its own converter.
+ */
+struct ConsoleApp::Worker
+{
+    explicit Worker(const Psid64Resources& resources) :
+        batch(NULL),
+        id(0),
+        psid64(resources)
+    {
+    }
+
+    Batch* batch;
+    int id;  // thread number in the trace
+    Psid64 psid64;
+    pthread_t thread;
+};
+#endif
+
+
+#ifdef HAVE_CONVERSION_SERVER
+/**
+ * Connections of the conversion server. A connection thread that has
+ * finished moves its connection to the finished list and wakes up the main
+ * thread, which joins it. The mutex also keeps the verbose logs of the
+ * connections apart.
+ */
+struct ConsoleApp::Server
+{
+    vector<Connection*> live;
+    vector<Connection*> finished;
+    pthread_mutex_t mutex;
+};
+
+
+/**
+ * Client connection of the conversion server, served by its own thread
+ * and converter. The input is buffered, so that pipelined requests take
+ * only a few reads.
+ */
+struct ConsoleApp::Connection
+{
+    explicit Connection(const Psid64Resources& resources) :
+        app(NULL),
+        server(NULL),
+        fd(-1),
+        length(0),
+        position(0),
+        psid64(resources),
+        data()
+    {
+    }
+
+    ~Connection()
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+
+    /**
+     * Read a line without its line end, false at the end of the input and
+     * for lines that are too long.
+     */
+    bool readLine(string& line)
+    {
+        line.clear();
+        for (;;)
+        {
+            if ((position == length) && !fill())
+            {
+                return false;
+            }
+            const char* begin = buffer + position;
+            const char* end = static_cast<const char*>(
+                memchr(begin, '\n', length - position));
+            if (end != NULL)
+            {
+                line.append(begin, end);
+                position = end - buffer + 1;
+                if (!line.empty() && (line[line.length() - 1] == '\r'))
+                {
+                    line.erase(line.length() - 1);
+                }
+                return true;
+            }
+            line.append(begin, length - position);
+            position = length;
+            if (line.length() > MAX_REQUEST_LINE)
+            {
+                return false;
+            }
+        }
+    }
+
+    bool read(uint_least8_t* dest, size_t size)
+    {
+        while (size > 0)
+        {
+            if ((position == length) && !fill())
+            {
+                return false;
+            }
+            const size_t n = std::min(size, length - position);
+            memcpy(dest, buffer + position, n);
+            position += n;
+            dest += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    bool write(const void* src, size_t size)
+    {
+        const char* p = static_cast<const char*>(src);
+        while (size > 0)
+        {
+            const ssize_t n = ::write(fd, p, size);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return false;
+            }
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    ConsoleApp* app;
+    Server* server;
+    pthread_t thread;
+    int fd;
+    char buffer[MAX_REQUEST_LINE];
+    size_t length;
+    size_t position;
+    Psid64 psid64;
+    vector<uint_least8_t> data;
+
+private:
+    bool fill()
+    {
+        ssize_t n;
+        do
+        {
+            n = ::read(fd, buffer, sizeof(buffer));
+        } while ((n < 0) && (errno == EINTR));
+        if (n <= 0)
+        {
+            return false;
+        }
+        length = n;
+        position = 0;
+        return true;
+    }
+};
+
+
+// set by SIGINT and SIGTERM to stop the conversion server
+static volatile sig_atomic_t stopServer = 0;
+
+// write end of the pipe that wakes up the conversion server
+static int serverWakeFd = -1;
+#endif
 
 
 // constructor
@@ -100,14 +349,46 @@ ConsoleApp::ConsoleApp() :
     m_sidPostfix(".sid"),
     m_prgPostfix(".prg"),
     m_verbose(false),
-    m_outputPathName()
+    m_jobs(1),
+    m_incremental(false),
+    m_printStats(false),
+    m_statsFileName(),
+    m_outputPathName(),
+    m_themes(),
+    m_efforts(),
+    m_layouts(),
+    m_resources(),
+    m_reportedResourceErrors(0),
+    m_cache(),
+    m_psid64(m_resources),
+    m_batchStats(),
+    m_trace(NULL)
 {
+    m_themes["blue"] = Psid64::THEME_BLUE;
+    m_themes["c1541_ultimate"] = Psid64::THEME_C1541_ULTIMATE;
+    m_themes["coal"] = Psid64::THEME_COAL;
+    m_themes["default"] = Psid64::THEME_DEFAULT;
+    m_themes["dutch"] = Psid64::THEME_DUTCH;
+    m_themes["kernal"] = Psid64::THEME_KERNAL;
+    m_themes["light"] = Psid64::THEME_LIGHT;
+    m_themes["mondriaan"] = Psid64::THEME_MONDRIAAN;
+    m_themes["ocean"] = Psid64::THEME_OCEAN;
+    m_themes["pencil"] = Psid64::THEME_PENCIL;
+    m_themes["rainbow"] = Psid64::THEME_RAINBOW;
+    m_efforts["fast"] = Psid64::EFFORT_FAST;
+    m_efforts["normal"] = Psid64::EFFORT_NORMAL;
+    m_efforts["max"] = Psid64::EFFORT_MAX;
+    m_layouts["complete"] = Psid64::LAYOUT_COMPLETE;
+    m_layouts["fast-boot"] = Psid64::LAYOUT_FAST_BOOT;
+    m_layouts["first"] = Psid64::LAYOUT_FIRST_FIT;
+    m_layouts["small"] = Psid64::LAYOUT_SMALL;
 }
 
 // destructor
 
 ConsoleApp::~ConsoleApp()
 {
+    delete m_trace;
 }
 
 
@@ -124,30 +405,65 @@ void ConsoleApp::printHelp()
 #ifdef HAVE_GETOPT_LONG
     cout << "  -b, --blank-screen     use a minimal driver that blanks the screen" << endl;
     cout << "  -c, --compress         compress output file with Exomizer" << endl;
+    cout << "  -C, --cache=DIR        keep compressed files in DIR for reuse by later runs" << endl;
+    cout << "  -D, --serve=SOCKET     keep running and convert the files requested through" << endl;
+    cout << "                         the local socket SOCKET" << endl;
+    cout << "  -e, --compress-effort=LEVEL" << endl;
+    cout << "                         set compression effort: fast, normal (default) or max" << endl;
+    cout << "  -F, --stats-file=FILE  write the statistics of every file to FILE, as JSON" << endl;
+    cout << "                         when FILE ends in .json and as CSV otherwise" << endl;
     cout << "  -g, --global-comment   include the global comment STIL text" << endl;
     cout << "  -i, --initial-song=NUM override the initial song to play" << endl;
+    cout << "  -I, --incremental      only convert the files of a directory that have changed" << endl;
+    cout << "                         since the previous run" << endl;
+    cout << "  -j, --jobs=NUM         convert up to NUM files of a directory in parallel" << endl;
+    cout << "  -l, --layout=OBJECTIVE choose the memory layout: first (default), complete," << endl;
+    cout << "                         small or fast-boot" << endl;
+    cout << "  -L, --leave-out        let the small and fast-boot layouts leave out the STIL" << endl;
+    cout << "                         text and song lengths" << endl;
+    cout << "  -m, --cache-size=MIB   limit the cache to MIB mebibytes (default 1024)" << endl;
     cout << "  -n, --no-driver        convert SID to C64 program file without driver code" << endl;
     cout << "  -o, --output=PATH      specify output file or directory" << endl;
     cout << "  -p, --player-id=FILE   specify SID ID config file for player identification" << endl;
     cout << "  -r, --root=PATH        specify HVSC root directory" << endl;
     cout << "  -s, --songlengths=FILE specify HVSC song length database" << endl;
+    cout << "  -S, --stats            print the time spent in every conversion phase" << endl;
     cout << "  -t, --theme=THEME      specify a visual theme for the driver" << endl;
     cout << "                         use `help' to show the list of available themes" << endl;
+    cout << "  -T, --trace=FILE       write a timeline of the run to FILE in the Chrome" << endl;
+    cout << "                         trace event format" << endl;
     cout << "  -v, --verbose          explain what is being done" << endl;
     cout << "  -h, --help             display this help and exit" << endl;
     cout << "  -V, --version          output version information and exit" << endl;
 #else
     cout << "  -b                     use a minimal driver that blanks the screen" << endl;
     cout << "  -c                     compress output file with Exomizer" << endl;
+    cout << "  -C DIR                 keep compressed files in DIR for reuse by later runs" << endl;
+    cout << "  -D SOCKET              keep running and convert the files requested through" << endl;
+    cout << "                         the local socket SOCKET" << endl;
+    cout << "  -e LEVEL               set compression effort: fast, normal (default) or max" << endl;
+    cout << "  -F FILE                write the statistics of every file to FILE, as JSON" << endl;
+    cout << "                         when FILE ends in .json and as CSV otherwise" << endl;
     cout << "  -g                     include the global comment STIL text" << endl;
     cout << "  -i NUM                 override the initial song to play" << endl;
+    cout << "  -I                     only convert the files of a directory that have changed" << endl;
+    cout << "                         since the previous run" << endl;
+    cout << "  -j NUM                 convert up to NUM files of a directory in parallel" << endl;
+    cout << "  -l OBJECTIVE           choose the memory layout: first (default), complete," << endl;
+    cout << "                         small or fast-boot" << endl;
+    cout << "  -L                     let the small and fast-boot layouts leave out the STIL" << endl;
+    cout << "                         text and song lengths" << endl;
+    cout << "  -m MIB                 limit the cache to MIB mebibytes (default 1024)" << endl;
     cout << "  -n                     convert SID to C64 program file without driver code" << endl;
     cout << "  -o PATH                specify output file or directory" << endl;
     cout << "  -p FILE                specify SID ID config file for player identification" << endl;
     cout << "  -r PATH                specify HVSC root directory" << endl;
     cout << "  -s FILE                specify HVSC song length database" << endl;
+    cout << "  -S                     print the time spent in every conversion phase" << endl;
     cout << "  -t THEME               specify a visual theme for the driver" << endl;
     cout << "                         use `help' to show the list of available themes" << endl;
+    cout << "  -T FILE                write a timeline of the run to FILE in the Chrome" << endl;
+    cout << "                         trace event format" << endl;
     cout << "  -v                     explain what is being done" << endl;
     cout << "  -h                     display this help and exit" << endl;
     cout << "  -V                     output version information and exit" << endl;
@@ -156,6 +472,140 @@ void ConsoleApp::printHelp()
 }
 
 
+#ifdef HAVE_PTHREAD_H
+/**
+ * Name under which a worker saves an output file until the main thread
+ * reports it, so that the file of an earlier run survives an aborted batch.
+ */
+static string
+tempFileName(const string& outputFileName)
+{
+    ostringstream name;
+    name << outputFileName << ".tmp" << getpid();
+    return name.str();
+}
+#endif
+
+
+#ifdef HAVE_CONVERSION_SERVER
+/**
+ * Wake up the conversion server, also from a signal handler. The pipe does
+ * not block, and a full pipe wakes up the server just as well.
+ */
+static void
+wakeServer()
+{
+    const int savedErrno = errno;
+    const char c = 0;
+    if (write(serverWakeFd, &c, 1) < 0)
+    {
+        // the server is already awake or stopping
+    }
+    errno = savedErrno;
+}
+
+
+static void
+stopServing(int)
+{
+    stopServer = 1;
+    wakeServer();
+}
+
+
+static bool
+setNonBlocking(int fd, bool nonBlocking)
+{
+    const int flags = fcntl(fd, F_GETFL);
+    return (flags >= 0)
+           && (fcntl(fd, F_SETFL, nonBlocking ? (flags | O_NONBLOCK)
+                                              : (flags & ~O_NONBLOCK)) == 0);
+}
+#endif
+
+
+/**
+ * Get the file descriptor of an open directory, -1 when directories are not
+ * accessed through file descriptors.
+ */
+static int
+directoryFd(DIR* dp)
+{
+#ifdef HAVE_DIRECTORY_FDS
+    return dirfd(dp);
+#else
+    (void) dp;
+    return -1;
+#endif
+}
+
+
+/**
+ * Open the directory name in the directory parentFd, or at path when
+ * parentFd is -1. Opening relative to the parent saves resolving the whole
+ * path again. The number of file system calls is added to calls.
+ */
+static DIR*
+openDir(int parentFd, const string& name, const string& path,
+        unsigned long& calls)
+{
+#ifdef HAVE_DIRECTORY_FDS
+    if (parentFd >= 0)
+    {
+        ++calls;
+        int fd = openat(parentFd, name.c_str(), O_RDONLY | O_DIRECTORY);
+        if (fd < 0)
+        {
+            return NULL;
+        }
+        DIR* dp = fdopendir(fd);
+        if (dp == NULL)
+        {
+            const int error = errno;
+            close(fd);
+            errno = error;
+        }
+        return dp;
+    }
+#else
+    (void) parentFd;
+    (void) name;
+#endif
+    ++calls;
+    return opendir(path.c_str());
+}
+
+
+/**
+ * Check whether the entry dirp of the directory dp at path is a directory.
+ * Symbolic links are not followed. The type of the entry is used when the
+ * file system provides it, otherwise the entry is looked up relative to the
+ * directory. The number of file system calls is added to calls.
+ */
+static bool
+isDirEntry(DIR* dp, const string& path, const struct dirent* dirp,
+           unsigned long& calls)
+{
+#ifdef HAVE_STRUCT_DIRENT_D_TYPE
+    if (dirp->d_type != DT_UNKNOWN)
+    {
+        return dirp->d_type == DT_DIR;
+    }
+#endif
+    struct stat s;
+    ++calls;
+#ifdef HAVE_DIRECTORY_FDS
+    (void) path;
+    return (fstatat(dirfd(dp), dirp->d_name, &s, AT_SYMLINK_NOFOLLOW) == 0)
+           && S_ISDIR(s.st_mode);
+#else
+    (void) dp;
+    const string entryPath = path + PATH_SEPARATOR + dirp->d_name;
+    return (lstat(entryPath.c_str(), &s) == 0) && S_ISDIR(s.st_mode);
+#endif
+}
+
+
 bool
 ConsoleApp::isdir(const string& path)
 {
@@ -203,185 +653,1246 @@ ConsoleApp::buildOutputFileName(const string& sidFileName, const string& outputP
 
     if (replaceSuffix)
     {
-        // replace the .sid extension by .prg extension
-        int index = prgFileName.length() - m_sidPostfix.length();
-        if ((index >= 0) && (prgFileName.substr(index) == m_sidPostfix))
+        prgFileName = replaceSidPostfix(prgFileName);
+    }
+
+    return prgFileName;
+}
+
+
+string
+ConsoleApp::replaceSidPostfix(const string& sidFileName) const
+{
+    // replace the .sid extension by .prg extension
+    string prgFileName(sidFileName);
+    int index = prgFileName.length() - m_sidPostfix.length();
+    if ((index >= 0) && (prgFileName.substr(index) == m_sidPostfix))
+    {
+        prgFileName.erase(index);
+    }
+    prgFileName += m_prgPostfix;
+    return prgFileName;
+}
+
+
+bool ConsoleApp::convertFile(Psid64& psid64, const string& inputFileName,
+                             const string& outputFileName, ostream& log,
+                             const string& saveFileName) const
+{
+    // the file may be saved under another name, e.g. a temporary one, but
+    // the messages always name the output file
+    // read the PSID file
+    if (m_verbose)
+    {
+        log << "Reading file `" << inputFileName << "'" << endl;
+    }
+    if (!psid64.load(inputFileName.c_str()))
+    {
+        log << "Error loading '" << inputFileName << "': "
+            << psid64.getStatus() << endl;
+        return false;
+    }
+
+    // convert the PSID file
+#ifdef COUNT_ALLOCATIONS
+    const unsigned long allocationCount = getAllocationCount();
+#endif
+    if (!psid64.convert())
+    {
+        log << "Error converting '" << inputFileName << "': "
+            << psid64.getStatus() << endl;
+        return false;
+    }
+#ifdef COUNT_ALLOCATIONS
+    log << "Heap allocations: " << getAllocationCount() - allocationCount
+        << endl;
+#endif
+    if (m_verbose)
+    {
+        log << "Bytes copied: " << psid64.getBytesCopied() << endl;
+    }
+
+    // write the C64 program file
+    if (outputFileName == "-")
+    {
+        if (m_verbose)
+        {
+            log << "Writing C64 executable to standard output" << endl;
+        }
+        if (!psid64.write())
+        {
+            log << "Error writing to standard output: "
+                << psid64.getStatus() << endl;
+            return false;
+        }
+    }
+    else
+    {
+        if (m_verbose)
+        {
+            log << "Writing C64 executable `" << outputFileName << "'" << endl;
+        }
+        const string& fileName = saveFileName.empty() ? outputFileName
+                                                      : saveFileName;
+        if (!psid64.save(fileName.c_str()))
+        {
+            log << "Error writing '" << outputFileName << "': "
+                << psid64.getStatus() << endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+bool ConsoleApp::scanDir(const string& inputDirName, const string& outputDirName,
+                         vector<ConvertJob>& jobs, OutputDirs& outputDirs,
+                         ostream& log) const
+{
+    ScanCounts counts = { 0, 0, 0 };
+    const uint_least64_t start = Psid64::getMicroseconds();
+    const bool retval = scanDir(-1, inputDirName, inputDirName, outputDirName,
+                                jobs, outputDirs, log, counts);
+    if (m_trace != NULL)
+    {
+        m_trace->addSpan("scan", 0, start, Psid64::getMicroseconds() - start,
+                         inputDirName);
+    }
+    if (m_verbose)
+    {
+        cerr << "Scanned " << counts.dirs << " directories with " << counts.files
+             << " files using " << counts.calls << " file system calls" << endl;
+    }
+    return retval;
+}
+
+
+bool ConsoleApp::scanDir(int parentFd, const string& name,
+                         const string& inputDirName, const string& outputDirName,
+                         vector<ConvertJob>& jobs, OutputDirs& outputDirs,
+                         ostream& log, ScanCounts& counts) const
+{
+    bool retval = true;
+    const bool recursive = true;
+
+    // the output directory is checked once, after which the names of its
+    // files can be built without looking at it again; a missing one is
+    // created when the conversion gets to it
+    ++counts.calls;
+    if (!isdir(outputDirName))
+    {
+        outputDirs.names.push_back(outputDirName);
+    }
+
+    DIR *dp = openDir(parentFd, name, inputDirName, counts.calls);
+    if (dp == NULL)
+    {
+        log << PACKAGE << ": Cannot access `" << inputDirName << "': " << strerror(errno) << "\n";
+        retval = false;
+    }
+    else
+    {
+        ++counts.dirs;
+        vector<string> dirs;
+        vector<string> files;
+        struct dirent *dirp;
+        while ((dirp = readdir(dp)) != NULL)
+        {
+            if ((strcmp(dirp->d_name, ".") != 0)
+                && (strcmp(dirp->d_name, "..") != 0))
+            {
+                if (isDirEntry(dp, inputDirName, dirp, counts.calls))
+                {
+                    if (recursive)
+                    {
+                        dirs.push_back(dirp->d_name);
+                    }
+                }
+                else
+                {
+                    // ignore files with an unknown extension
+                    const size_t length = strlen(dirp->d_name);
+                    if ((length >= m_sidPostfix.length())
+                        && (m_sidPostfix.compare(0, string::npos,
+                                                 dirp->d_name + length - m_sidPostfix.length()) == 0))
+                    {
+                        files.push_back(dirp->d_name);
+                    }
+                }
+            }
+        }
+
+        // process the subdirectories, which are opened relative to this one
+        sort(dirs.begin(), dirs.end());
+        for (vector<string>::const_iterator it = dirs.begin();
+             (it != dirs.end()) && retval; ++it)
+        {
+            string newInputDirName = inputDirName + PATH_SEPARATOR + *it;
+            string newOutputDirName = outputDirName + PATH_SEPARATOR + *it;
+            retval = retval && scanDir(directoryFd(dp), *it, newInputDirName,
+                                       newOutputDirName, jobs, outputDirs, log,
+                                       counts);
+        }
+        closedir(dp);
+
+        // process files
+        sort(files.begin(), files.end());
+        for (vector<string>::const_iterator it = files.begin();
+             (it != files.end()) && retval; ++it)
+        {
+            ++counts.files;
+            ConvertJob job;
+            job.inputFileName = inputDirName + PATH_SEPARATOR + *it;
+            job.outputFileName = outputDirName + PATH_SEPARATOR + replaceSidPostfix(*it);
+            job.size = 0;
+            job.mtime = 0;
+            job.outputDirs = outputDirs.names.size();
+            jobs.push_back(job);
+        }
+    }
+
+    return retval;
+}
+
+
+bool ConsoleApp::createOutputDirs(OutputDirs& outputDirs, size_t count,
+                                  int thread, ostream& log) const
+{
+    // a directory that cannot be created is tried again by the next job
+    // that needs it
+    for (; outputDirs.created < count; ++outputDirs.created)
+    {
+        const string& dirName = outputDirs.names[outputDirs.created];
+        const uint_least64_t start = Psid64::getMicroseconds();
+        const int status = mkdir(dirName.c_str(), ACCESSPERMS);
+        if (m_trace != NULL)
+        {
+            m_trace->addSpan("mkdir", thread, start,
+                             Psid64::getMicroseconds() - start, dirName);
+        }
+        if ((status != 0) && (errno != EEXIST))
+        {
+            log << PACKAGE << ": Cannot create directory `" << dirName
+                << "': " << strerror(errno) << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+
+void ConsoleApp::initWorker(Psid64& psid64)
+{
+    psid64.setVerbose(m_psid64.getVerbose());
+    psid64.setUseGlobalComment(m_psid64.getUseGlobalComment());
+    psid64.setBlankScreen(m_psid64.getBlankScreen());
+    psid64.setNoDriver(m_psid64.getNoDriver());
+    psid64.setCompress(m_psid64.getCompress());
+    psid64.setCompressEffort(m_psid64.getCompressEffort());
+    psid64.setLayout(m_psid64.getLayout());
+    psid64.setLeaveOutBlocks(m_psid64.getLeaveOutBlocks());
+    psid64.setInitialSong(m_psid64.getInitialSong());
+    psid64.setTheme(m_psid64.getTheme());
+    psid64.setCache(m_psid64.getCache());
+}
+
+
+void* ConsoleApp::runWorker(void* arg)
+{
+#ifdef HAVE_PTHREAD_H
+    Worker* worker = static_cast<Worker*>(arg);
+    Batch& batch = *worker->batch;
+
+    pthread_mutex_lock(&batch.mutex);
+    while (!batch.abort && (batch.nextJob < batch.jobs->size()))
+    {
+        const size_t index = batch.order[batch.nextJob++];
+        const ConvertJob& job = (*batch.jobs)[index];
+        ostringstream log;
+        const bool dirsCreated = batch.app->createOutputDirs(
+            *batch.outputDirs, job.outputDirs, worker->id, log);
+        pthread_mutex_unlock(&batch.mutex);
+
+        // the main thread renames the file when it reports the job
+        worker->psid64.setLogStream(log);
+        const string saveFileName = tempFileName(job.outputFileName);
+        const uint_least64_t start = Psid64::getMicroseconds();
+        const bool ok = batch.app->convertFile(worker->psid64, job.inputFileName,
+                                               job.outputFileName, log,
+                                               saveFileName)
+                        && dirsCreated;
+        const unsigned long time = Psid64::getMicroseconds() - start;
+        if (!ok)
+        {
+            remove(saveFileName.c_str());
+        }
+        BatchStats::Record stats;
+        if (batch.app->collectsStats())
+        {
+            stats = BatchStats::makeRecord(job.inputFileName, ok, time,
+                                           worker->psid64);
+        }
+        if (batch.app->m_trace != NULL)
+        {
+            batch.app->m_trace->addConversion(worker->id, job.inputFileName,
+                                              start, time, worker->psid64);
+        }
+
+        pthread_mutex_lock(&batch.mutex);
+        Batch::Result& result = batch.results[index];
+        result.done = true;
+        result.ok = ok;
+        result.time = time;
+        result.stats = stats;
+        result.log = log.str();
+        pthread_cond_broadcast(&batch.jobDone);
+    }
+    pthread_mutex_unlock(&batch.mutex);
+#endif
+
+    return arg;
+}
+
+
+void* ConsoleApp::runLoader(void* arg)
+{
+    // shown below the worker threads
+    ConsoleApp* app = static_cast<ConsoleApp*>(arg);
+    const int thread = app->m_jobs + 1;
+    if (app->m_trace != NULL)
+    {
+        app->m_trace->setThreadName(thread, "resources");
+    }
+    app->loadResources(thread);
+
+    return arg;
+}
+
+
+void ConsoleApp::loadResources(int thread)
+{
+    const uint_least64_t start = Psid64::getMicroseconds();
+    m_resources.load();
+    if (m_trace != NULL)
+    {
+        m_trace->addSpan("load-resources", thread, start,
+                         Psid64::getMicroseconds() - start);
+    }
+}
+
+
+void ConsoleApp::reportResourceErrors()
+{
+    // called by the main thread when the resources may have been loaded,
+    // either before the conversions that use them are reported or after a
+    // single conversion that has loaded them on first use; every error is
+    // reported once
+    const char* errors[] = {
+        m_resources.getStilError(),
+        m_resources.getDatabaseError(),
+        m_resources.getSidIdError()
+    };
+    static const char* const consequences[] = {
+        "STILView will be disabled",
+        "song lengths will be disabled",
+        "player identification will be disabled"
+    };
+    for (unsigned int i = 0; i < sizeof(errors) / sizeof(errors[0]); ++i)
+    {
+        if ((errors[i] != NULL) && ((m_reportedResourceErrors & (1 << i)) == 0))
+        {
+            cerr << errors[i] << ": " << consequences[i] << endl;
+            m_reportedResourceErrors |= 1 << i;
+        }
+    }
+}
+
+
+bool ConsoleApp::convertJobs(const vector<ConvertJob>& jobs,
+                             OutputDirs& outputDirs, Manifest* manifest)
+{
+    // an incremental conversion converts as many files as possible, the
+    // failed ones are retried by the next run
+    const bool keepGoing = (manifest != NULL);
+
+#ifdef HAVE_PTHREAD_H
+    size_t numWorkers = std::min(static_cast<size_t>(m_jobs), jobs.size());
+    if (numWorkers > 1)
+    {
+        Batch batch;
+        Batch::Result initialResult = { false, false, 0, BatchStats::Record(),
+                                        string() };
+        batch.app = this;
+        batch.jobs = &jobs;
+        batch.outputDirs = &outputDirs;
+        orderJobs(jobs, manifest, batch.order);
+        batch.results.assign(jobs.size(), initialResult);
+        batch.nextJob = 0;
+        batch.abort = false;
+        pthread_mutex_init(&batch.mutex, NULL);
+        pthread_cond_init(&batch.jobDone, NULL);
+
+        vector<Worker*> workers;
+        for (size_t i = 0; i < numWorkers; ++i)
+        {
+            Worker* worker = new Worker(m_resources);
+            worker->batch = &batch;
+            worker->id = static_cast<int>(i + 1);
+            if (m_trace != NULL)
+            {
+                ostringstream name;
+                name << "worker " << worker->id;
+                m_trace->setThreadName(worker->id, name.str());
+            }
+            initWorker(worker->psid64);
+            if (pthread_create(&worker->thread, NULL, runWorker, worker) != 0)
+            {
+                delete worker;
+                break;
+            }
+            workers.push_back(worker);
+        }
+
+        // report the results in the order of the jobs and stop at the first
+        // error, just like a sequential conversion would do
+        bool retval = true;
+        size_t i = 0;
+        for (; (i < jobs.size()) && (retval || keepGoing) && !workers.empty(); ++i)
+        {
+            string log;
+            pthread_mutex_lock(&batch.mutex);
+            while (!batch.results[i].done)
+            {
+                pthread_cond_wait(&batch.jobDone, &batch.mutex);
+            }
+            log.swap(batch.results[i].log);
+            bool ok = batch.results[i].ok;
+            pthread_mutex_unlock(&batch.mutex);
+            if (ok && (rename(tempFileName(jobs[i].outputFileName).c_str(),
+                              jobs[i].outputFileName.c_str()) != 0))
+            {
+                log += string(PACKAGE) + ": Cannot write `"
+                       + jobs[i].outputFileName + "': " + strerror(errno) + "\n";
+                remove(tempFileName(jobs[i].outputFileName).c_str());
+                ok = false;
+            }
+            if (!ok && !keepGoing)
+            {
+                pthread_mutex_lock(&batch.mutex);
+                batch.abort = true;
+                pthread_mutex_unlock(&batch.mutex);
+            }
+            cerr << log;
+            reportStats(batch.results[i].stats);
+            if (ok)
+            {
+                recordJob(jobs[i], manifest, batch.results[i].time);
+            }
+            retval = retval && ok;
+        }
+
+        for (vector<Worker*>::iterator it = workers.begin();
+             it != workers.end(); ++it)
+        {
+            pthread_join((*it)->thread, NULL);
+            delete *it;
+        }
+
+        // remove the files that other workers have converted after the
+        // failed job, and the directories they have created for them, to
+        // leave the same output as a sequential conversion
+        if (!workers.empty() && (i < jobs.size()))
+        {
+            for (size_t j = i; j < jobs.size(); ++j)
+            {
+                if (batch.results[j].ok)
+                {
+                    remove(tempFileName(jobs[j].outputFileName).c_str());
+                }
+            }
+            while (outputDirs.created > jobs[i - 1].outputDirs)
+            {
+                --outputDirs.created;
+                rmdir(outputDirs.names[outputDirs.created].c_str());
+            }
+        }
+
+        pthread_cond_destroy(&batch.jobDone);
+        pthread_mutex_destroy(&batch.mutex);
+
+        if (!workers.empty())
+        {
+            return retval;
+        }
+        // no worker thread could be started, fall back to a sequential
+        // conversion
+    }
+#endif
+
+    bool retval = true;
+    for (vector<ConvertJob>::const_iterator it = jobs.begin();
+         it != jobs.end(); ++it)
+    {
+        const bool dirsCreated = createOutputDirs(outputDirs, it->outputDirs,
+                                                  0, cerr);
+        const uint_least64_t start = Psid64::getMicroseconds();
+        const bool ok = convertFile(m_psid64, it->inputFileName,
+                                    it->outputFileName, cerr) && dirsCreated;
+        const unsigned long time = Psid64::getMicroseconds() - start;
+        if (m_trace != NULL)
+        {
+            m_trace->addConversion(0, it->inputFileName, start, time, m_psid64);
+        }
+        reportStats(BatchStats::makeRecord(it->inputFileName, ok, time, m_psid64));
+        if (ok)
+        {
+            recordJob(*it, manifest, time);
+        }
+        else
+        {
+            retval = false;
+            if (!keepGoing)
+            {
+                break;
+            }
+        }
+    }
+
+    return retval;
+}
+
+
+bool ConsoleApp::convertDir(const string& inputDirName, const string& outputDirName)
+{
+    // errors found while scanning the directory are reported after the
+    // conversion of the files found before the error
+    vector<ConvertJob> jobs;
+    OutputDirs outputDirs;
+    outputDirs.created = 0;
+    ostringstream log;
+    const bool needResources = !m_psid64.getNoDriver();
+    bool loaded = false;
+#ifdef HAVE_PTHREAD_H
+    // load the resources while the directory is scanned, unless the files
+    // that are up to date are skipped, which may leave nothing to convert
+    pthread_t loader;
+    const bool loading = needResources && !m_incremental
+        && (pthread_create(&loader, NULL, runLoader, this) == 0);
+#endif
+    const bool scanned = scanDir(inputDirName, outputDirName, jobs, outputDirs,
+                                 log);
+#ifdef HAVE_PTHREAD_H
+    if (loading)
+    {
+        pthread_join(loader, NULL);
+        loaded = true;
+    }
+#endif
+
+    Manifest manifest;
+    if (m_incremental)
+    {
+        // the manifest is kept in the output directory
+        const string manifestFileName = outputDirName + PATH_SEPARATOR
+                                        + MANIFEST_FILE_NAME;
+        if (!outputDirs.names.empty() && (outputDirs.names[0] == outputDirName)
+            && !createOutputDirs(outputDirs, 1, 0, cerr))
+        {
+            return false;
+        }
+        if (!manifest.open(manifestFileName, optionsFingerprint()))
+        {
+            cerr << PACKAGE << ": Cannot write manifest `" << manifestFileName
+                 << "'" << endl;
+            return false;
+        }
+        const uint_least64_t start = Psid64::getMicroseconds();
+        skipUpToDateJobs(inputDirName, manifest, jobs);
+        if (m_trace != NULL)
+        {
+            m_trace->addSpan("check-manifest", 0, start,
+                             Psid64::getMicroseconds() - start, manifestFileName);
+        }
+    }
+
+    if (needResources && !loaded && !jobs.empty())
+    {
+        loadResources(0);
+        loaded = true;
+    }
+    if (loaded)
+    {
+        reportResourceErrors();
+    }
+
+    if (!convertJobs(jobs, outputDirs, m_incremental ? &manifest : NULL)
+        || !createOutputDirs(outputDirs, outputDirs.names.size(), 0, cerr))
+    {
+        return false;
+    }
+    cerr << log.str();
+
+    return scanned;
+}
+
+
+string ConsoleApp::optionsFingerprint() const
+{
+    // everything that affects the output files, including the identity of
+    // the databases that are looked up
+    ostringstream options;
+    options << VERSION
+            << " " << m_psid64.getNoDriver()
+            << " " << m_psid64.getBlankScreen()
+            << " " << m_psid64.getCompress()
+            << " " << m_psid64.getCompressEffort()
+            << " " << m_psid64.getLayout()
+            << " " << m_psid64.getLeaveOutBlocks()
+            << " " << m_psid64.getInitialSong()
+            << " " << m_psid64.getUseGlobalComment()
+            << " " << m_psid64.getTheme();
+
+    vector<string> fileNames;
+    const string& hvscRoot = m_resources.getHvscRoot();
+    if (!hvscRoot.empty())
+    {
+        const string documents = hvscRoot + PATH_SEPARATOR + "DOCUMENTS"
+                                 + PATH_SEPARATOR;
+        fileNames.push_back(documents + "STIL.txt");
+        fileNames.push_back(documents + "BUGlist.txt");
+    }
+    fileNames.push_back(m_resources.getDatabaseFileName());
+    fileNames.push_back(m_resources.getSidIdConfigFileName());
+    for (vector<string>::const_iterator it = fileNames.begin();
+         it != fileNames.end(); ++it)
+    {
+        struct stat s;
+        options << "\n" << *it;
+        if (!it->empty() && (stat(it->c_str(), &s) == 0))
+        {
+            options << " " << s.st_size << " " << s.st_mtime;
+        }
+    }
+
+    return Manifest::hashString(options.str());
+}
+
+
+void ConsoleApp::skipUpToDateJobs(const string& inputDirName, Manifest& manifest,
+                                  vector<ConvertJob>& jobs) const
+{
+    size_t numSkipped = 0;
+    vector<ConvertJob>::iterator dest = jobs.begin();
+    for (vector<ConvertJob>::iterator it = jobs.begin(); it != jobs.end(); ++it)
+    {
+        struct stat s;
+        if (stat(it->inputFileName.c_str(), &s) != 0)
+        {
+            // let the conversion report the error
+            *dest++ = *it;
+            continue;
+        }
+        it->manifestPath = it->inputFileName.substr(inputDirName.length() + 1);
+        it->size = s.st_size;
+        it->mtime = s.st_mtime;
+
+        // an output file that was removed is written again
+        if ((stat(it->outputFileName.c_str(), &s) == 0)
+            && manifest.isUpToDate(it->manifestPath, it->inputFileName,
+                                   it->size, it->mtime))
+        {
+            ++numSkipped;
+        }
+        else
+        {
+            *dest++ = *it;
+        }
+    }
+    jobs.erase(dest, jobs.end());
+
+    if (m_verbose)
+    {
+        cerr << "Skipping " << numSkipped << " up-to-date file"
+             << ((numSkipped == 1) ? "" : "s") << endl;
+    }
+}
+
+
+void ConsoleApp::orderJobs(const vector<ConvertJob>& jobs, const Manifest* manifest,
+                           vector<size_t>& order) const
+{
+    // The conversion time varies by more than two orders of magnitude when
+    // compressing. Starting the most expensive conversions first keeps all
+    // workers busy until the end instead of leaving a few long ones running
+    // alone. The cost of a file is its conversion time in the previous run,
+    // or else estimated from its size.
+    vector<unsigned long> sizes(jobs.size());
+    vector<unsigned long> times(jobs.size());
+    double knownSize = 0;
+    double knownTime = 0;
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        const ConvertJob& job = jobs[i];
+        sizes[i] = job.size;
+        if (sizes[i] == 0)
+        {
+            struct stat s;
+            if (stat(job.inputFileName.c_str(), &s) == 0)
+            {
+                sizes[i] = s.st_size;
+            }
+        }
+        times[i] = ((manifest != NULL) && !job.manifestPath.empty())
+                   ? manifest->getTime(job.manifestPath) : 0;
+        if ((times[i] > 0) && (sizes[i] > 0))
+        {
+            knownSize += sizes[i];
+            knownTime += times[i];
+        }
+    }
+    const double timePerByte = (knownSize > 0) ? (knownTime / knownSize) : 1.0;
+
+    // sort by decreasing cost, and keep the order of the jobs otherwise
+    vector<std::pair<double, size_t> > costs(jobs.size());
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        const double cost = (times[i] > 0) ? times[i] : (sizes[i] * timePerByte);
+        costs[i] = std::make_pair(-cost, i);
+    }
+    sort(costs.begin(), costs.end());
+
+    order.resize(jobs.size());
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        order[i] = costs[i].second;
+    }
+}
+
+
+void ConsoleApp::recordJob(const ConvertJob& job, Manifest* manifest,
+                           unsigned long time) const
+{
+    if ((manifest != NULL) && !job.manifestPath.empty())
+    {
+        manifest->record(job.manifestPath, job.inputFileName, job.size,
+                         job.mtime, time);
+    }
+}
+
+
+bool ConsoleApp::collectsStats() const
+{
+    return m_printStats || !m_statsFileName.empty();
+}
+
+
+void ConsoleApp::reportStats(const BatchStats::Record& record)
+{
+    if (!collectsStats())
+    {
+        return;
+    }
+    m_batchStats.add(record);
+    if (m_printStats)
+    {
+        BatchStats::printRecord(cerr, record);
+    }
+}
+
+
+bool ConsoleApp::convert(const string& pathName)
+{
+    bool useBaseName = true;
+    string inputPathName(pathName);
+
+    // remove any trailing path separators
+    size_t index = inputPathName.find_last_not_of(ACCEPTED_PATH_SEPARATORS);
+    if ((index != string::npos) && ((index + 1) < inputPathName.length()))
+    {
+        inputPathName.erase(index + 1);
+        useBaseName = false;
+    }
+
+    if (isdir(inputPathName))
+    {
+        string outputDirName;
+        if (m_outputPathName.empty())
+        {
+            outputDirName = inputPathName;
+        }
+        else
+        {
+            outputDirName = m_outputPathName;
+            if (isdir(outputDirName) && useBaseName)
+            {
+                outputDirName += PATH_SEPARATOR + basename(inputPathName);
+            }
+        }
+        return convertDir(inputPathName, outputDirName);
+    }
+    else
+    {
+        // the resources are loaded on first use, so that e.g. a tune
+        // programmed in BASIC does not read them at all
+        string outputFileName = buildOutputFileName(inputPathName, m_outputPathName);
+        const uint_least64_t start = Psid64::getMicroseconds();
+        const bool ok = convertFile(m_psid64, inputPathName, outputFileName, cerr);
+        const unsigned long time = Psid64::getMicroseconds() - start;
+        reportResourceErrors();
+        if (m_trace != NULL)
         {
-            prgFileName.erase(index);
+            m_trace->addConversion(0, inputPathName, start, time, m_psid64);
         }
-        prgFileName += m_prgPostfix;
+        reportStats(BatchStats::makeRecord(inputPathName, ok, time, m_psid64));
+        return ok;
     }
-
-    return prgFileName;
 }
 
 
-bool ConsoleApp::convertFile(const string& inputFileName, const string& outputFileName)
+bool ConsoleApp::serve(const string& socketName)
 {
-    // read the PSID file
-    if (m_verbose)
+#ifdef HAVE_CONVERSION_SERVER
+    struct sockaddr_un address;
+    if (socketName.length() >= sizeof(address.sun_path))
     {
-        cerr << "Reading file `" << inputFileName << "'" << endl;
+        cerr << PACKAGE << ": socket name `" << socketName << "' is too long"
+             << endl;
+        return false;
     }
-    if (!m_psid64.load(inputFileName.c_str()))
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socketName.c_str());
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
     {
-        cerr << "Error loading '" << inputFileName << "': "
-             << m_psid64.getStatus() << endl;
+        cerr << PACKAGE << ": Cannot create socket: " << strerror(errno) << endl;
         return false;
     }
 
-    // convert the PSID file
-    if (!m_psid64.convert())
+    // a socket left behind by a server that has stopped is replaced, one
+    // that is still in use is not
+    struct stat s;
+    if (lstat(socketName.c_str(), &s) == 0)
+    {
+        if (!S_ISSOCK(s.st_mode)
+            || (connect(fd, (struct sockaddr*) &address, sizeof(address)) == 0))
+        {
+            cerr << PACKAGE << ": `" << socketName << "' is already in use"
+                 << endl;
+            close(fd);
+            return false;
+        }
+        unlink(socketName.c_str());
+    }
+    if ((bind(fd, (struct sockaddr*) &address, sizeof(address)) != 0)
+        || (listen(fd, SOMAXCONN) != 0) || !setNonBlocking(fd, true))
     {
-        cerr << "Error converting '" << inputFileName << "': "
-             << m_psid64.getStatus() << endl;
+        cerr << PACKAGE << ": Cannot listen on `" << socketName << "': "
+             << strerror(errno) << endl;
+        close(fd);
         return false;
     }
 
-    // write the C64 program file
-    if (outputFileName == "-")
+    // the server waits for a client or for a byte in this pipe, which is
+    // written by the signal handler and by connection threads that have
+    // finished, so that neither a stop signal that arrives just before the
+    // wait nor a finished connection has to wait for the next client
+    int wakeFds[2];
+    if (pipe(wakeFds) != 0)
     {
-        if (m_verbose)
+        cerr << PACKAGE << ": Cannot create pipe: " << strerror(errno) << endl;
+        close(fd);
+        unlink(socketName.c_str());
+        return false;
+    }
+    setNonBlocking(wakeFds[0], true);
+    setNonBlocking(wakeFds[1], true);
+    serverWakeFd = wakeFds[1];
+
+    // the signals must be delivered to this thread and not to the
+    // connection threads
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = stopServing;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+    sigset_t stopSignals;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+
+    loadResources(0);
+    reportResourceErrors();
+    if (m_verbose)
+    {
+        cerr << "Serving conversions on `" << socketName << "'" << endl;
+    }
+
+    Server server;
+    pthread_mutex_init(&server.mutex, NULL);
+
+    // a client that sends nothing for a while is dropped, and so is one
+    // that does not read its responses
+    struct timeval timeout;
+    timeout.tv_sec = CONNECTION_TIMEOUT;
+    timeout.tv_usec = 0;
+
+    bool retval = true;
+    while (!stopServer)
+    {
+        struct pollfd fds[2];
+        fds[0].fd = fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = wakeFds[0];
+        fds[1].events = POLLIN;
+        if (poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            cerr << PACKAGE << ": Cannot wait for connections: "
+                 << strerror(errno) << endl;
+            retval = false;
+            break;
+        }
+
+        if (fds[1].revents != 0)
         {
-            cerr << "Writing C64 executable to standard output" << endl;
+            // the connections that have finished free their converters
+            char buffer[64];
+            while (read(wakeFds[0], buffer, sizeof(buffer)) > 0)
+            {
+            }
+            vector<Connection*> finished;
+            pthread_mutex_lock(&server.mutex);
+            finished.swap(server.finished);
+            pthread_mutex_unlock(&server.mutex);
+            joinConnections(finished);
+            continue;
         }
-        if (!m_psid64.write())
+        if (fds[0].revents == 0)
         {
-            cerr << "Error writing to standard output: "
-                 << m_psid64.getStatus() << endl;
-            return false;
+            continue;
         }
-    }
-    else
-    {
-        if (m_verbose)
+
+        const int client = accept(fd, NULL, NULL);
+        if (client < 0)
         {
-            cerr << "Writing C64 executable `" << outputFileName << "'" << endl;
+            if ((errno == EINTR) || (errno == ECONNABORTED)
+                || (errno == EAGAIN) || (errno == EWOULDBLOCK))
+            {
+                continue;
+            }
+            cerr << PACKAGE << ": Cannot accept connection: " << strerror(errno)
+                 << endl;
+            retval = false;
+            break;
         }
-        if (!m_psid64.save(outputFileName.c_str()))
+        setNonBlocking(client, false);
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        pthread_mutex_lock(&server.mutex);
+        const bool full = server.live.size() >= MAX_CONNECTIONS;
+        pthread_mutex_unlock(&server.mutex);
+        if (full)
         {
-            cerr << "Error writing '" << outputFileName << "': "
-                 << m_psid64.getStatus() << endl;
-            return false;
+            const string response = "error too many connections\n";
+            send(client, response.data(), response.length(), 0);
+            close(client);
+            continue;
+        }
+
+        Connection* connection = new Connection(m_resources);
+        connection->app = this;
+        connection->server = &server;
+        connection->fd = client;
+        initWorker(connection->psid64);
+
+        // the connection is listed before its thread starts, so that it
+        // cannot finish before it is live
+        pthread_mutex_lock(&server.mutex);
+        server.live.push_back(connection);
+        sigset_t oldSignals;
+        pthread_sigmask(SIG_BLOCK, &stopSignals, &oldSignals);
+        const bool started = pthread_create(&connection->thread, NULL,
+                                            runConnection, connection) == 0;
+        pthread_sigmask(SIG_SETMASK, &oldSignals, NULL);
+        if (!started)
+        {
+            server.live.pop_back();
+        }
+        pthread_mutex_unlock(&server.mutex);
+        if (!started)
+        {
+            delete connection;
         }
     }
 
-    return true;
+    close(fd);
+    unlink(socketName.c_str());
+
+    // stop reading the requests of the remaining clients; the requests that
+    // were already read are answered before the threads finish
+    pthread_mutex_lock(&server.mutex);
+    for (vector<Connection*>::const_iterator it = server.live.begin();
+         it != server.live.end(); ++it)
+    {
+        shutdown((*it)->fd, SHUT_RD);
+    }
+    vector<Connection*> connections(server.live);
+    connections.insert(connections.end(), server.finished.begin(),
+                       server.finished.end());
+    server.live.clear();
+    server.finished.clear();
+    pthread_mutex_unlock(&server.mutex);
+    joinConnections(connections);
+    pthread_mutex_destroy(&server.mutex);
+    serverWakeFd = -1;
+    close(wakeFds[0]);
+    close(wakeFds[1]);
+
+    if (m_verbose)
+    {
+        cerr << "Stopped serving conversions" << endl;
+    }
+    return retval;
+#else
+    cerr << PACKAGE << ": Cannot serve `" << socketName
+         << "': not supported on this system" << endl;
+    return false;
+#endif
 }
 
 
-bool ConsoleApp::convertDir(const string& inputDirName, const string& outputDirName)
+void* ConsoleApp::runConnection(void* arg)
 {
-    bool retval = true;
-    const bool recursive = true;
+#ifdef HAVE_CONVERSION_SERVER
+    Connection* connection = static_cast<Connection*>(arg);
+    while (connection->app->handleRequest(*connection))
+    {
+    }
 
-    if (!isdir(outputDirName))
+    // the client sees the end of the connection now, but the main thread
+    // closes the socket only after joining this thread, so the descriptor
+    // cannot be reused while the server may still shut it down; a server
+    // that is stopping has already taken the connection
+    shutdown(connection->fd, SHUT_RDWR);
+    Server& server = *connection->server;
+    pthread_mutex_lock(&server.mutex);
+    vector<Connection*>::iterator it = std::find(server.live.begin(),
+                                                 server.live.end(), connection);
+    if (it != server.live.end())
     {
-        if (mkdir(outputDirName.c_str(), ACCESSPERMS) != 0)
-        {
-            cerr << PACKAGE << ": Cannot create directory `" << outputDirName
-                 << "': " << strerror(errno) << "\n";
-            retval = false;
-        }
+        server.live.erase(it);
+        server.finished.push_back(connection);
+        wakeServer();
     }
+    pthread_mutex_unlock(&server.mutex);
+#endif
+
+    return NULL;
+}
+
 
-    DIR *dp;
-    if ((dp = opendir(inputDirName.c_str())) == NULL)
+void ConsoleApp::joinConnections(vector<Connection*>& connections)
+{
+#ifdef HAVE_CONVERSION_SERVER
+    for (vector<Connection*>::iterator it = connections.begin();
+         it != connections.end(); ++it)
     {
-        cerr << PACKAGE << ": Cannot access `" << inputDirName << "': " << strerror(errno) << "\n";
-        retval = false;
+        pthread_join((*it)->thread, NULL);
+        delete *it;
     }
-    else
+    connections.clear();
+#endif
+}
+
+
+bool ConsoleApp::handleRequest(Connection& connection)
+{
+#ifdef HAVE_CONVERSION_SERVER
+    Psid64& psid64 = connection.psid64;
+    initWorker(psid64);
+
+    // a request is a block of "name value" lines that ends with an empty
+    // line, optionally followed by the contents of the PSID file
+    string line;
+    do
     {
-        vector<string> dirs;
-        vector<string> files;
-        struct dirent *dirp;
-        while ((dirp = readdir(dp)) != NULL)
+        if (!connection.readLine(line))
         {
-            if ((strcmp(dirp->d_name, ".") != 0)
-                && (strcmp(dirp->d_name, "..") != 0))
+            return false;
+        }
+    } while (line.empty());
+
+    string path;
+    string hvscPath;
+    unsigned long dataSize = 0;
+    bool haveData = false;
+    string error;
+    while (!line.empty())
+    {
+        const size_t separator = line.find(' ');
+        const string name = line.substr(0, separator);
+        const string value = (separator != string::npos)
+                             ? line.substr(separator + 1) : string();
+        if (name == "path")
+        {
+            path = value;
+        }
+        else if (name == "hvsc-path")
+        {
+            hvscPath = value;
+        }
+        else if (name == "data")
+        {
+            // the request cannot be skipped without a valid size
+            istringstream istr(value);
+            haveData = (istr >> dataSize) && istr.eof() && (dataSize > 0)
+                       && (dataSize <= MAX_REQUEST_DATA);
+            if (!haveData)
             {
-                string path = inputDirName + PATH_SEPARATOR + dirp->d_name;
-                if (isdir(path))
-                {
-                    if (recursive)
-                    {
-                        dirs.push_back(dirp->d_name);
-                    }
-                }
-                else
-                {
-                    // ignore files with an unknown extension
-                    int index = path.length() - m_sidPostfix.length();
-                    if ((index >= 0) && (path.substr(index) == m_sidPostfix))
-                    {
-                        files.push_back(dirp->d_name);
-                    }
-                }
+                const string response = "error invalid data size\n";
+                connection.write(response.data(), response.length());
+                return false;
             }
         }
-        closedir(dp);
-
-        // process the subdirectories
-        sort(dirs.begin(), dirs.end());
-        for (vector<string>::const_iterator it = dirs.begin();
-             (it != dirs.end()) && retval; ++it)
+        else if (!setRequestOption(psid64, name, value) && error.empty())
         {
-            string newInputDirName = inputDirName + PATH_SEPARATOR + *it;
-            string newOutputDirName = outputDirName + PATH_SEPARATOR + *it;
-            retval = retval && convertDir(newInputDirName, newOutputDirName);
+            error = "invalid field `" + line + "'";
+        }
+        if (!connection.readLine(line))
+        {
+            return false;
+        }
+    }
+    if (haveData)
+    {
+        connection.data.resize(dataSize);
+        if (!connection.read(&connection.data[0], dataSize))
+        {
+            return false;
         }
+    }
+    if (error.empty() && (path.empty() == !haveData))
+    {
+        error = "a request needs either a path or data";
+    }
 
-        // process files
-        sort(files.begin(), files.end());
-        for (vector<string>::const_iterator it = files.begin();
-             (it != files.end()) && retval; ++it)
+    if (error.empty())
+    {
+        ostringstream log;
+        psid64.setLogStream(log);
+        const bool loaded = haveData
+            ? psid64.load(&connection.data[0], dataSize,
+                          hvscPath.empty() ? NULL : hvscPath.c_str())
+            : psid64.load(path.c_str());
+        if (!loaded || !psid64.convert())
+        {
+            error = psid64.getStatus();
+        }
+        if (m_verbose)
         {
-            string inputFileName = inputDirName + PATH_SEPARATOR + *it;
-            string outputFileName = buildOutputFileName(*it, outputDirName);
-            retval = retval && convertFile(inputFileName, outputFileName);
+            // the logs of the connections must not interleave
+            pthread_mutex_lock(&connection.server->mutex);
+            cerr << log.str();
+            pthread_mutex_unlock(&connection.server->mutex);
         }
     }
 
-    return retval;
+    if (!error.empty())
+    {
+        std::replace(error.begin(), error.end(), '\n', ' ');
+        const string response = "error " + error + "\n";
+        return connection.write(response.data(), response.length());
+    }
+    ostringstream header;
+    header << "ok " << psid64.getProgramSize() << "\n";
+    return connection.write(header.str().data(), header.str().length())
+           && connection.write(psid64.getProgramData(),
+                               psid64.getProgramSize());
+#else
+    return false;
+#endif
 }
 
 
-bool ConsoleApp::convert(const string& pathName)
+bool ConsoleApp::setRequestOption(Psid64& psid64, const string& name,
+                                  const string& value) const
 {
-    bool useBaseName = true;
-    string inputPathName(pathName);
-
-    // remove any trailing path separators
-    size_t index = inputPathName.find_last_not_of(ACCEPTED_PATH_SEPARATORS);
-    if ((index != string::npos) && ((index + 1) < inputPathName.length()))
+    // the fields have the names of the long options, flags are set without
+    // a value or with 1 and cleared with 0
+    const bool isFlag = value.empty() || (value == "1") || (value == "0");
+    const bool flag = value != "0";
+    if ((name == "blank-screen") && isFlag)
     {
-        inputPathName.erase(index + 1);
-        useBaseName = false;
+        psid64.setBlankScreen(flag);
     }
-
-    if (isdir(inputPathName))
+    else if ((name == "compress") && isFlag)
     {
-        string outputDirName;
-        if (m_outputPathName.empty())
+        psid64.setCompress(flag);
+    }
+    else if (name == "compress-effort")
+    {
+        EffortsMap::const_iterator it = m_efforts.find(value);
+        if (it == m_efforts.end())
         {
-            outputDirName = inputPathName;
+            return false;
         }
-        else
+        psid64.setCompressEffort(it->second);
+    }
+    else if ((name == "global-comment") && isFlag)
+    {
+        psid64.setUseGlobalComment(flag);
+    }
+    else if (name == "initial-song")
+    {
+        istringstream istr(value);
+        int initialSong = 0;
+        istr >> initialSong;
+        if (!istr.eof() || (initialSong < 1) || (initialSong > 255))
         {
-            outputDirName = m_outputPathName;
-            if (isdir(outputDirName) && useBaseName)
-            {
-                outputDirName += PATH_SEPARATOR + basename(inputPathName);
-            }
+            return false;
         }
-        return convertDir(inputPathName, outputDirName);
+        psid64.setInitialSong(initialSong);
+    }
+    else if (name == "layout")
+    {
+        LayoutsMap::const_iterator it = m_layouts.find(value);
+        if (it == m_layouts.end())
+        {
+            return false;
+        }
+        psid64.setLayout(it->second);
+    }
+    else if ((name == "leave-out") && isFlag)
+    {
+        psid64.setLeaveOutBlocks(flag);
+    }
+    else if ((name == "no-driver") && isFlag)
+    {
+        psid64.setNoDriver(flag);
+    }
+    else if (name == "theme")
+    {
+        ThemesMap::const_iterator it = m_themes.find(value);
+        if (it == m_themes.end())
+        {
+            return false;
+        }
+        psid64.setTheme(it->second);
     }
     else
     {
-        string outputFileName = buildOutputFileName(inputPathName, m_outputPathName);
-        return convertFile(inputPathName, outputFileName);
+        return false;
     }
+    return true;
 }
 
 
@@ -393,36 +1904,39 @@ bool ConsoleApp::main(int argc, char **argv)
     int                     option_index = 0;
     static struct option    long_options[] = {
         {"blank-screen", 0, NULL, 'b'},
+        {"cache", 1, NULL, 'C'},
+        {"cache-size", 1, NULL, 'm'},
         {"compress", 0, NULL, 'c'},
+        {"compress-effort", 1, NULL, 'e'},
         {"global-comment", 0, NULL, 'g'},
         {"help", 0, NULL, 'h'},
+        {"incremental", 0, NULL, 'I'},
         {"initial-song", 1, NULL, 'i'},
+        {"jobs", 1, NULL, 'j'},
+        {"layout", 1, NULL, 'l'},
+        {"leave-out", 0, NULL, 'L'},
         {"no-driver", 0, NULL, 'n'},
         {"output", 1, NULL, 'o'},
         {"player-id", 1, NULL, 'p'},
         {"root", 1, NULL, 'r'},
+        {"serve", 1, NULL, 'D'},
         {"songlengths", 1, NULL, 's'},
+        {"stats", 0, NULL, 'S'},
+        {"stats-file", 1, NULL, 'F'},
         {"theme", 1, NULL, 't'},
+        {"trace", 1, NULL, 'T'},
         {"verbose", 0, NULL, 'v'},
         {"version", 0, NULL, 'V'},
         {NULL, 0, NULL, 0}
     };
 #endif
-    ThemesMap themes;
-    themes["blue"] = Psid64::THEME_BLUE;
-    themes["c1541_ultimate"] = Psid64::THEME_C1541_ULTIMATE;
-    themes["coal"] = Psid64::THEME_COAL;
-    themes["default"] = Psid64::THEME_DEFAULT;
-    themes["dutch"] = Psid64::THEME_DUTCH;
-    themes["kernal"] = Psid64::THEME_KERNAL;
-    themes["light"] = Psid64::THEME_LIGHT;
-    themes["mondriaan"] = Psid64::THEME_MONDRIAAN;
-    themes["ocean"] = Psid64::THEME_OCEAN;
-    themes["pencil"] = Psid64::THEME_PENCIL;
-    themes["rainbow"] = Psid64::THEME_RAINBOW;
     string hvscRoot;
     string databaseFileName;
     string sidIdConfigFileName;
+    string cacheDirName;
+    uint_least64_t cacheSize = 1024;  // in MiB
+    string traceFileName;
+    string socketName;
 
     // set default configuration
     m_psid64.setVerbose(false);
@@ -462,6 +1976,30 @@ bool ConsoleApp::main(int argc, char **argv)
         case 'c':
             m_psid64.setCompress(true);
             break;
+        case 'C':
+            cacheDirName = optarg;
+            break;
+        case 'D':
+            socketName = optarg;
+            break;
+        case 'e':
+            {
+                EffortsMap::const_iterator it = m_efforts.find(optarg);
+                if (it != m_efforts.end())
+                {
+                    m_psid64.setCompressEffort(it->second);
+                }
+                else
+                {
+                    cerr << PACKAGE << ": unknown compression effort `"
+                         << optarg << "'" << endl;
+                    ++errflg;
+                }
+            }
+            break;
+        case 'F':
+            m_statsFileName = optarg;
+            break;
         case 'g':
             m_psid64.setUseGlobalComment(true);
             break;
@@ -484,6 +2022,60 @@ bool ConsoleApp::main(int argc, char **argv)
                 }
             }
             break;
+        case 'I':
+            m_incremental = true;
+            break;
+        case 'j':
+            {
+                istringstream istr(optarg);
+                int jobs = 0;
+                istr >> jobs;
+                if (jobs >= 1)
+                {
+                    m_jobs = jobs;
+                }
+                else
+                {
+                    cerr << PACKAGE << ": number of jobs should be a positive integer number" << endl;
+                    ++errflg;
+                }
+            }
+            break;
+        case 'l':
+            {
+                LayoutsMap::const_iterator it = m_layouts.find(optarg);
+                if (it != m_layouts.end())
+                {
+                    m_psid64.setLayout(it->second);
+                }
+                else
+                {
+                    cerr << PACKAGE << ": unknown memory layout objective `"
+                         << optarg << "'" << endl;
+                    ++errflg;
+                }
+            }
+            break;
+        case 'L':
+            m_psid64.setLeaveOutBlocks(true);
+            break;
+        case 'm':
+            {
+                istringstream istr(optarg);
+                long size = 0;
+                istr >> size;
+                if ((size >= 1)
+                    && (static_cast<uint_least64_t>(size) <= (MAX_CACHE_SIZE >> 20)))
+                {
+                    cacheSize = size;
+                }
+                else
+                {
+                    cerr << PACKAGE << ": cache size should be a positive integer number" << endl;
+                    ++errflg;
+                }
+            }
+            break;
         case 'n':
             m_psid64.setNoDriver(true);
             break;
@@ -499,12 +2091,15 @@ bool ConsoleApp::main(int argc, char **argv)
         case 's':
             databaseFileName = optarg;
             break;
+        case 'S':
+            m_printStats = true;
+            break;
         case 't':
             {
                 if (strcmp(optarg, "help") == 0)
                 {
-                    for (ThemesMap::const_iterator it = themes.begin();
-                         it != themes.end(); ++it)
+                    for (ThemesMap::const_iterator it = m_themes.begin();
+                         it != m_themes.end(); ++it)
                     {
                         cout << it->first << "\n";
                     }
@@ -512,8 +2107,8 @@ bool ConsoleApp::main(int argc, char **argv)
                 }
                 else
                 {
-                    ThemesMap::const_iterator it = themes.find(optarg);
-                    if (it != themes.end())
+                    ThemesMap::const_iterator it = m_themes.find(optarg);
+                    if (it != m_themes.end())
                     {
                         m_psid64.setTheme(it->second);
                     }
@@ -526,6 +2121,9 @@ bool ConsoleApp::main(int argc, char **argv)
                 }
             }
             break;
+        case 'T':
+            traceFileName = optarg;
+            break;
         case 'v':
             m_verbose = true;
             m_psid64.setVerbose(true);
@@ -557,11 +2155,16 @@ bool ConsoleApp::main(int argc, char **argv)
 #endif
     }
 
-    if ((argc - optind) < 1)
+    if (socketName.empty() && ((argc - optind) < 1))
     {
         printUsage();
         ++errflg;
     }
+    else if (!socketName.empty() && (argc > optind))
+    {
+        cerr << PACKAGE << ": no PSID files can be given when serving" << endl;
+        ++errflg;
+    }
 
     if (errflg)
     {
@@ -582,11 +2185,19 @@ bool ConsoleApp::main(int argc, char **argv)
         return false;
     }
 
+    if (!traceFileName.empty())
+    {
+        m_trace = new TraceLog;
+        m_trace->setThreadName(0, "main");
+    }
+
+    // the resources are loaded before the first conversion that needs
+    // them, a conversion without driver does not
     if (!hvscRoot.empty())
     {
-        if (!m_psid64.setHvscRoot(hvscRoot))
+        if (!m_resources.setHvscRoot(hvscRoot))
         {
-            cerr << m_psid64.getStatus() << ": STILView will be disabled" << endl;
+            cerr << m_resources.getStatus() << ": STILView will be disabled" << endl;
         }
 
         if (databaseFileName.empty())
@@ -599,27 +2210,58 @@ bool ConsoleApp::main(int argc, char **argv)
 
     if (!databaseFileName.empty())
     {
-        if (!m_psid64.setDatabaseFileName(databaseFileName))
+        if (!m_resources.setDatabaseFileName(databaseFileName))
         {
-            cerr << m_psid64.getStatus() << ": song lengths will be disabled" << endl;
+            cerr << m_resources.getStatus() << ": song lengths will be disabled" << endl;
         }
     }
 
     if (!sidIdConfigFileName.empty())
     {
-        if (!m_psid64.setSidIdConfigFileName(sidIdConfigFileName))
+        if (!m_resources.setSidIdConfigFileName(sidIdConfigFileName))
         {
-            cerr << m_psid64.getStatus() << ": player identification will be disabled" << endl;
+            cerr << m_resources.getStatus() << ": player identification will be disabled" << endl;
         }
     }
 
-    while (optind < argc)
+    if (!cacheDirName.empty())
     {
-        if (!convert(argv[optind++]))
+        if (m_cache.open(cacheDirName, cacheSize << 20))
         {
-            return false;
+            m_psid64.setCache(&m_cache);
+        }
+        else
+        {
+            cerr << m_cache.getStatus() << ": caching will be disabled" << endl;
         }
     }
 
-    return true;
+    bool retval = true;
+    if (!socketName.empty())
+    {
+        retval = serve(socketName);
+    }
+    while (retval && (optind < argc))
+    {
+        retval = convert(argv[optind++]);
+    }
+
+    if (m_printStats)
+    {
+        m_batchStats.printSummary(cerr);
+    }
+    if (!m_statsFileName.empty() && !m_batchStats.write(m_statsFileName))
+    {
+        cerr << PACKAGE << ": Cannot write statistics `" << m_statsFileName
+             << "'" << endl;
+        retval = false;
+    }
+    if ((m_trace != NULL) && !m_trace->write(traceFileName))
+    {
+        cerr << PACKAGE << ": Cannot write trace `" << traceFileName << "'"
+             << endl;
+        retval = false;
+    }
+
+    return retval;
 }
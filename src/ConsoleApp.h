@@ -25,10 +25,18 @@
 #ifndef CONSOLEAPP_H
 #define CONSOLEAPP_H
 
+#include <map>
+#include <ostream>
 #include <string>
+#include <vector>
 
 #include <psid64/psid64.h>
 
+#include "BatchStats.h"
+
+class Manifest;
+class TraceLog;
+
 class ConsoleApp
 {
 public:
@@ -38,13 +46,72 @@ public:
     bool main(int argc, char **argv);
 
 private:
+    /**
+     * Conversion of a single file within a directory conversion.
+     */
+    struct ConvertJob
+    {
+        std::string inputFileName;
+        std::string outputFileName;
+
+        // incremental conversion only: the path relative to the input
+        // directory and the size and modification time of the input file
+        std::string manifestPath;
+        unsigned long size;
+        long mtime;
+
+        // number of output directories that must exist before this job
+        size_t outputDirs;
+    };
+
+    /**
+     * Output directories of a directory conversion that do not exist yet,
+     * in the order in which a sequential conversion creates them.
+     */
+    struct OutputDirs
+    {
+        std::vector<std::string> names;
+        size_t created;  // the number of names that were created
+    };
+
+    /**
+     * Statistics of a directory scan.
+     */
+    struct ScanCounts
+    {
+        unsigned long dirs;
+        unsigned long files;
+        unsigned long calls;  // file system calls for the directories
+    };
+
+    typedef std::map<std::string, Psid64::Theme> ThemesMap;
+    typedef std::map<std::string, Psid64::CompressEffort> EffortsMap;
+    typedef std::map<std::string, Psid64::Layout> LayoutsMap;
+
+    struct Batch;
+    struct Worker;
+    struct Server;
+    struct Connection;
+
     const std::string m_sidPostfix;
     const std::string m_prgPostfix;
 
     bool m_verbose;
+    int m_jobs;
+    bool m_incremental;
+    bool m_printStats;
+    std::string m_statsFileName;
     std::string m_outputPathName;
+    ThemesMap m_themes;
+    EffortsMap m_efforts;
+    LayoutsMap m_layouts;
 
+    Psid64Resources m_resources;
+    unsigned int m_reportedResourceErrors;  // bit mask, see reportResourceErrors()
+    Psid64Cache m_cache;
     Psid64 m_psid64;
+    BatchStats m_batchStats;
+    TraceLog* m_trace;  // NULL when not tracing
 
     static void printUsage();
     static void printHelp();
@@ -52,9 +119,43 @@ private:
     static bool isdir(const std::string& path);
     static std::string basename(const std::string& path);
     std::string buildOutputFileName(const std::string& sidFileName, const std::string& outputPathName) const;
-    bool convertFile(const std::string& inputFileName, const std::string& outputFileName);
+    std::string replaceSidPostfix(const std::string& sidFileName) const;
+    bool convertFile(Psid64& psid64, const std::string& inputFileName,
+                     const std::string& outputFileName, std::ostream& log,
+                     const std::string& saveFileName = "") const;
+    bool scanDir(const std::string& inputDirName, const std::string& outputDirName,
+                 std::vector<ConvertJob>& jobs, OutputDirs& outputDirs,
+                 std::ostream& log) const;
+    bool scanDir(int parentFd, const std::string& name,
+                 const std::string& inputDirName, const std::string& outputDirName,
+                 std::vector<ConvertJob>& jobs, OutputDirs& outputDirs,
+                 std::ostream& log, ScanCounts& counts) const;
+    bool createOutputDirs(OutputDirs& outputDirs, size_t count, int thread,
+                          std::ostream& log) const;
+    void initWorker(Psid64& psid64);
+    static void* runWorker(void* arg);
+    static void* runLoader(void* arg);
+    void loadResources(int thread);
+    void reportResourceErrors();
+    bool convertJobs(const std::vector<ConvertJob>& jobs, OutputDirs& outputDirs,
+                     Manifest* manifest);
+    std::string optionsFingerprint() const;
+    void skipUpToDateJobs(const std::string& inputDirName, Manifest& manifest,
+                          std::vector<ConvertJob>& jobs) const;
+    void orderJobs(const std::vector<ConvertJob>& jobs, const Manifest* manifest,
+                   std::vector<size_t>& order) const;
+    void recordJob(const ConvertJob& job, Manifest* manifest,
+                   unsigned long time) const;
+    bool collectsStats() const;
+    void reportStats(const BatchStats::Record& record);
     bool convertDir(const std::string& inputDirName, const std::string& outputDirName);
     bool convert(const std::string& pathName);
+    bool serve(const std::string& socketName);
+    static void* runConnection(void* arg);
+    static void joinConnections(std::vector<Connection*>& connections);
+    bool handleRequest(Connection& connection);
+    bool setRequestOption(Psid64& psid64, const std::string& name,
+                          const std::string& value) const;
 };
 
 #endif  // CONSOLEAPP_H
@@ -0,0 +1,277 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+    psid64 - create a C64 executable from a PSID file
+    Copyright (C) 2001-2023  Roland Hermans <rolandh@users.sourceforge.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+//////////////////////////////////////////////////////////////////////////////
+//                             I N C L U D E S
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "Manifest.h"
+
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+#include "sidutils/MD5/MD5.h"
+
+using std::endl;
+using std::ifstream;
+using std::ios;
+using std::istringstream;
+using std::string;
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                           G L O B A L   D A T A
+//////////////////////////////////////////////////////////////////////////////
+
+const char* const Manifest::HEADER = "psid64-manifest 2";
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                     L O C A L   F U N C T I O N S
+//////////////////////////////////////////////////////////////////////////////
+
+static string
+formatDigest(MD5& md5)
+{
+    static const char hexDigits[] = "0123456789abcdef";
+    md5.finish();
+    const md5_byte_t* digest = md5.getDigest();
+    string hash;
+    for (int i = 0; i < 16; ++i)
+    {
+        hash += hexDigits[digest[i] >> 4];
+        hash += hexDigits[digest[i] & 0x0f];
+    }
+    return hash;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//               P U B L I C   M E M B E R   F U N C T I O N S
+//////////////////////////////////////////////////////////////////////////////
+
+// constructor
+
+Manifest::Manifest() :
+    m_fileName(),
+    m_fingerprint(),
+    m_file(),
+    m_entries()
+{
+}
+
+// destructor
+
+Manifest::~Manifest()
+{
+    close();
+}
+
+
+bool
+Manifest::open(const string& fileName, const string& fingerprint)
+{
+    close();
+    m_fileName = fileName;
+    m_fingerprint = fingerprint;
+
+    // read the entries of an earlier conversion, the last entry of a file
+    // wins; with other options only the conversion times are of use
+    bool keep = false;
+    ifstream in(fileName.c_str());
+    string line;
+    if (getline(in, line) && (line.compare(0, strlen(HEADER), HEADER) == 0))
+    {
+        keep = (line == string(HEADER) + " " + fingerprint);
+        while (getline(in, line))
+        {
+            istringstream istr(line);
+            Entry entry;
+            string path;
+            if ((istr >> entry.size >> entry.mtime >> entry.hash >> entry.time)
+                && (istr.get() == ' ') && getline(istr, path)
+                && !path.empty())
+            {
+                if (keep)
+                {
+                    m_entries[path] = entry;
+                }
+                else
+                {
+                    m_previousTimes[path] = entry.time;
+                }
+            }
+        }
+    }
+    in.close();
+
+    if (keep)
+    {
+        m_file.open(fileName.c_str(), ios::out | ios::app);
+    }
+    else
+    {
+        m_file.open(fileName.c_str(), ios::out | ios::trunc);
+        m_file << HEADER << " " << fingerprint << endl;
+    }
+
+    return m_file.good();
+}
+
+
+void
+Manifest::close()
+{
+    if (!m_file.is_open())
+    {
+        return;
+    }
+    m_file.close();
+
+    // drop the entries that were replaced by later ones
+    const string tempFileName = m_fileName + ".tmp";
+    std::ofstream out(tempFileName.c_str(), ios::out | ios::trunc);
+    out << HEADER << " " << m_fingerprint << "\n";
+    for (EntryMap::const_iterator it = m_entries.begin();
+         it != m_entries.end(); ++it)
+    {
+        out << it->second.size << " " << it->second.mtime << " "
+            << it->second.hash << " " << it->second.time << " "
+            << it->first << "\n";
+    }
+    out.close();
+    if (!out || (rename(tempFileName.c_str(), m_fileName.c_str()) != 0))
+    {
+        remove(tempFileName.c_str());
+    }
+    m_entries.clear();
+    m_previousTimes.clear();
+}
+
+
+bool
+Manifest::isUpToDate(const string& path, const string& fileName,
+                     unsigned long size, long mtime)
+{
+    EntryMap::iterator it = m_entries.find(path);
+    if ((it == m_entries.end()) || (it->second.size != size))
+    {
+        return false;
+    }
+    if (it->second.mtime == mtime)
+    {
+        return true;
+    }
+
+    // e.g. a fresh copy of the same file
+    if (hashFile(fileName) != it->second.hash)
+    {
+        return false;
+    }
+    it->second.mtime = mtime;
+    append(path, it->second);
+    return true;
+}
+
+
+void
+Manifest::record(const string& path, const string& fileName,
+                 unsigned long size, long mtime, unsigned long time)
+{
+    Entry entry;
+    entry.size = size;
+    entry.mtime = mtime;
+    entry.hash = hashFile(fileName);
+    entry.time = time;
+    if (entry.hash.empty())
+    {
+        // the file is converted again by the next run
+        m_entries.erase(path);
+        return;
+    }
+    m_entries[path] = entry;
+    append(path, entry);
+}
+
+
+unsigned long
+Manifest::getTime(const string& path) const
+{
+    EntryMap::const_iterator it = m_entries.find(path);
+    if (it != m_entries.end())
+    {
+        return it->second.time;
+    }
+    TimeMap::const_iterator previous = m_previousTimes.find(path);
+    return (previous != m_previousTimes.end()) ? previous->second : 0;
+}
+
+
+string
+Manifest::hashFile(const string& fileName)
+{
+    std::FILE* fp = std::fopen(fileName.c_str(), "rb");
+    if (fp == NULL)
+    {
+        return string();
+    }
+    MD5 md5;
+    char buffer[4096];
+    size_t n;
+    while ((n = std::fread(buffer, 1, sizeof(buffer), fp)) > 0)
+    {
+        md5.append(buffer, n);
+    }
+    const bool ok = !std::ferror(fp);
+    std::fclose(fp);
+    if (!ok)
+    {
+        return string();
+    }
+    return formatDigest(md5);
+}
+
+
+string
+Manifest::hashString(const string& text)
+{
+    MD5 md5;
+    md5.append(text.data(), text.length());
+    return formatDigest(md5);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//              P R I V A T E   M E M B E R   F U N C T I O N S
+//////////////////////////////////////////////////////////////////////////////
+
+void
+Manifest::append(const string& path, const Entry& entry)
+{
+    // flush every entry, an interrupted conversion resumes after the last
+    // file that was written to the manifest
+    m_file << entry.size << " " << entry.mtime << " " << entry.hash << " "
+           << entry.time << " " << path << endl;
+}
@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+    psid64 - create a C64 executable from a PSID file
+    Copyright (C) 2001-2023  Roland Hermans <rolandh@users.sourceforge.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef MANIFEST_H
+#define MANIFEST_H
+
+//////////////////////////////////////////////////////////////////////////////
+//                             I N C L U D E S
+//////////////////////////////////////////////////////////////////////////////
+
+#include <fstream>
+#include <map>
+#include <string>
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                           D E F I N I T I O N S
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Record of the files converted by an incremental directory conversion. For
+ * every input file, identified by its path relative to the input directory,
+ * the size, modification time and MD5 hash of the file are kept, together
+ * with the time it took to convert the file. The manifest also holds a
+ * fingerprint of the conversion options, the entries of a manifest with
+ * another fingerprint are only kept for their conversion times. Entries are
+ * appended to the manifest file as soon as a file has been converted, so
+ * that an interrupted conversion can be resumed.
+ */
+class Manifest
+{
+public:
+    struct Entry
+    {
+        unsigned long size;
+        long mtime;
+        std::string hash;
+        unsigned long time;  // conversion time in microseconds
+    };
+
+    Manifest();
+    ~Manifest();
+
+    /**
+     * Read the manifest file, unless its fingerprint differs, and open it
+     * for recording new entries.
+     */
+    bool open(const std::string& fileName, const std::string& fingerprint);
+
+    /**
+     * Rewrite the manifest file with one entry per input file and close it.
+     */
+    void close();
+
+    /**
+     * Check whether the input file at path, with the given size and
+     * modification time, was converted with the current options. When only
+     * the modification time differs, the contents of the file are compared
+     * by their hash and the entry is updated.
+     */
+    bool isUpToDate(const std::string& path, const std::string& fileName,
+                    unsigned long size, long mtime);
+
+    /**
+     * Record the conversion of the input file at path, which took time
+     * microseconds.
+     */
+    void record(const std::string& path, const std::string& fileName,
+                unsigned long size, long mtime, unsigned long time);
+
+    /**
+     * Get the time in microseconds of the most recent conversion of the
+     * input file at path, also with other options, 0 if it is not known.
+     */
+    unsigned long getTime(const std::string& path) const;
+
+    /**
+     * Calculate the MD5 hash of a file, an empty string on errors.
+     */
+    static std::string hashFile(const std::string& fileName);
+
+    /**
+     * Calculate the MD5 hash of a string.
+     */
+    static std::string hashString(const std::string& text);
+
+private:
+    Manifest(const Manifest&);
+    Manifest& operator=(const Manifest&);
+
+    typedef std::map<std::string, Entry> EntryMap;
+    typedef std::map<std::string, unsigned long> TimeMap;
+
+    static const char* const HEADER;
+
+    std::string m_fileName;
+    std::string m_fingerprint;
+    std::ofstream m_file;
+    EntryMap m_entries;
+    TimeMap m_previousTimes;  // of a manifest with another fingerprint
+
+    void append(const std::string& path, const Entry& entry);
+};
+
+#endif // MANIFEST_H
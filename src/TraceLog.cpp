@@ -0,0 +1,203 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+    psid64 - create a C64 executable from a PSID file
+    Copyright (C) 2001-2023  Roland Hermans <rolandh@users.sourceforge.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+//////////////////////////////////////////////////////////////////////////////
+//                             I N C L U D E S
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "TraceLog.h"
+
+#include <cstdio>
+#include <fstream>
+
+using std::ofstream;
+using std::ostream;
+using std::string;
+using std::vector;
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                     L O C A L   F U N C T I O N S
+//////////////////////////////////////////////////////////////////////////////
+
+static string
+quoteJson(const string& text)
+{
+    string quoted("\"");
+    for (string::const_iterator it = text.begin(); it != text.end(); ++it)
+    {
+        const unsigned char c = *it;
+        if ((c == '"') || (c == '\\'))
+        {
+            quoted += '\\';
+            quoted += c;
+        }
+        else if (c < 0x20)
+        {
+            char str[8];
+            sprintf(str, "\\u%04x", c);
+            quoted += str;
+        }
+        else
+        {
+            quoted += c;
+        }
+    }
+    quoted += '"';
+    return quoted;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//               P U B L I C   M E M B E R   F U N C T I O N S
+//////////////////////////////////////////////////////////////////////////////
+
+// constructor
+
+TraceLog::TraceLog() :
+    m_startTime(Psid64::getMicroseconds()),
+    m_spans(),
+    m_threadNames(),
+    m_mutex()
+{
+}
+
+// destructor
+
+TraceLog::~TraceLog()
+{
+}
+
+
+void
+TraceLog::setThreadName(int thread, const string& name)
+{
+    MutexLock lock(m_mutex);
+    if (m_threadNames.size() <= static_cast<size_t>(thread))
+    {
+        m_threadNames.resize(thread + 1);
+    }
+    m_threadNames[thread] = name;
+}
+
+
+void
+TraceLog::addSpan(const char* name, int thread, uint_least64_t start,
+                  unsigned long duration, const string& argument)
+{
+    MutexLock lock(m_mutex);
+    append(name, thread, start, duration, argument);
+}
+
+
+void
+TraceLog::addConversion(int thread, const string& fileName,
+                        uint_least64_t start, unsigned long duration,
+                        const Psid64& psid64)
+{
+    // the phases were already timed by the converter, so tracing costs a
+    // single lock per file
+    const Psid64::Stats& stats = psid64.getStats();
+    MutexLock lock(m_mutex);
+    append("convert-file", thread, start, duration, fileName);
+    for (int phase = 0; phase < Psid64::NUM_PHASES; ++phase)
+    {
+        if (stats.phaseStart[phase] != 0)
+        {
+            append(Psid64::getPhaseName(static_cast<Psid64::Phase>(phase)),
+                   thread, stats.phaseStart[phase], stats.phaseTime[phase],
+                   "");
+        }
+    }
+}
+
+
+bool
+TraceLog::write(const string& fileName) const
+{
+    ofstream out(fileName.c_str());
+    writeJson(out);
+    out.close();
+    return !out.fail();
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//              P R I V A T E   M E M B E R   F U N C T I O N S
+//////////////////////////////////////////////////////////////////////////////
+
+void
+TraceLog::append(const char* name, int thread, uint_least64_t start,
+                 unsigned long duration, const string& argument)
+{
+    // mutex must be held by the caller
+    Span span;
+    span.name = name;
+    span.thread = thread;
+    span.start = start;
+    span.duration = duration;
+    m_spans.push_back(span);
+    m_spans.back().argument = argument;
+}
+
+
+void
+TraceLog::writeJson(ostream& out) const
+{
+    MutexLock lock(m_mutex);
+
+    // times are in microseconds since the start of the run; the difference
+    // is taken modulo 2^64 and read as signed, so that it survives a
+    // wrap of the clock and a span that started before the run
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    const char* separator = "\n";
+    for (size_t thread = 0; thread < m_threadNames.size(); ++thread)
+    {
+        if (!m_threadNames[thread].empty())
+        {
+            out << separator
+                << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, "
+                << "\"tid\": " << thread << ", \"args\": {\"name\": "
+                << quoteJson(m_threadNames[thread]) << "}}";
+            separator = ",\n";
+        }
+    }
+    for (vector<Span>::const_iterator it = m_spans.begin();
+         it != m_spans.end(); ++it)
+    {
+        const int_least64_t start =
+            static_cast<int_least64_t>(it->start - m_startTime);
+        out << separator
+            << "{\"name\": \"" << it->name << "\", \"ph\": \"X\", \"pid\": 1, "
+            << "\"tid\": " << it->thread << ", \"ts\": " << start
+            << ", \"dur\": " << it->duration;
+        if (!it->argument.empty())
+        {
+            out << ", \"args\": {\"path\": " << quoteJson(it->argument) << "}";
+        }
+        out << "}";
+        separator = ",\n";
+    }
+    out << "\n]}\n";
+}
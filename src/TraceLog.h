@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+    psid64 - create a C64 executable from a PSID file
+    Copyright (C) 2001-2023  Roland Hermans <rolandh@users.sourceforge.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef TRACELOG_H
+#define TRACELOG_H
+
+//////////////////////////////////////////////////////////////////////////////
+//                             I N C L U D E S
+//////////////////////////////////////////////////////////////////////////////
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <psid64/psid64.h>
+
+#include "libpsid64/mutexlock.h"
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                           D E F I N I T I O N S
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Timeline of a run in the Chrome trace event format, which can be viewed
+ * with chrome://tracing or Perfetto. Spans are kept in memory by any thread
+ * and written when the run has finished. Thread 0 is the main thread, the
+ * worker threads of a parallel conversion are numbered from 1.
+ */
+class TraceLog
+{
+public:
+    TraceLog();
+    ~TraceLog();
+
+    /**
+     * Name a thread in the timeline.
+     */
+    void setThreadName(int thread, const std::string& name);
+
+    /**
+     * Add a span of duration microseconds that started at start, as
+     * returned by Psid64::getMicroseconds(). The name must be a string
+     * constant. The path argument, e.g. a file name, is optional.
+     */
+    void addSpan(const char* name, int thread, uint_least64_t start,
+                 unsigned long duration, const std::string& argument = "");
+
+    /**
+     * Add the span of the conversion of a file and the spans of the phases
+     * of its conversion, as recorded by psid64.
+     */
+    void addConversion(int thread, const std::string& fileName,
+                       uint_least64_t start, unsigned long duration,
+                       const Psid64& psid64);
+
+    bool write(const std::string& fileName) const;
+
+private:
+    TraceLog(const TraceLog&);
+    TraceLog& operator=(const TraceLog&);
+
+    struct Span
+    {
+        const char* name;
+        int thread;
+        uint_least64_t start;
+        unsigned long duration;
+        std::string argument;
+    };
+
+    uint_least64_t m_startTime;
+    std::vector<Span> m_spans;
+    std::vector<std::string> m_threadNames;
+    mutable Mutex m_mutex;
+
+    void append(const char* name, int thread, uint_least64_t start,
+                unsigned long duration, const std::string& argument);
+    void writeJson(std::ostream& out) const;
+};
+
+#endif // TRACELOG_H
@@ -0,0 +1,323 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+    psid64 - create a C64 executable from a PSID file
+    Copyright (C) 2001-2023  Roland Hermans <rolandh@users.sourceforge.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+//////////////////////////////////////////////////////////////////////////////
+//                             I N C L U D E S
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <psid64/psid64.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include "mutexlock.h"
+
+using std::string;
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                           D E F I N I T I O N S
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef ACCESSPERMS
+#define ACCESSPERMS                     (S_IRWXU|S_IRWXG|S_IRWXO)
+#endif
+
+#ifdef MKDIR_TAKES_ONE_ARG
+#define mkdir(path, mode)               mkdir(path)
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                           G L O B A L   D A T A
+//////////////////////////////////////////////////////////////////////////////
+
+const char* Psid64Cache::txt_cannotCreateDirectory = "PSID64: Cannot create cache directory";
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                     L O C A L   F U N C T I O N S
+//////////////////////////////////////////////////////////////////////////////
+
+static bool
+isKey(const char* name)
+{
+    size_t n = 0;
+    for (; name[n] != '\0'; ++n)
+    {
+        if (!(((name[n] >= '0') && (name[n] <= '9'))
+              || ((name[n] >= 'a') && (name[n] <= 'f'))))
+        {
+            return false;
+        }
+    }
+    return n == Psid64Cache::KEY_LENGTH;
+}
+
+
+static bool
+makeDir(const string& path)
+{
+    struct stat s;
+    if (stat(path.c_str(), &s) == 0)
+    {
+        return S_ISDIR(s.st_mode);
+    }
+    return mkdir(path.c_str(), ACCESSPERMS) == 0;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//               P U B L I C   M E M B E R   F U N C T I O N S
+//////////////////////////////////////////////////////////////////////////////
+
+// constructor
+
+Psid64Cache::Psid64Cache() :
+    m_directory(),
+    m_maxSize(0),
+    m_statusString(NULL),
+    m_mutex(new Mutex),
+    m_entries(),
+    m_lru(),
+    m_size(0),
+    m_useCount(0),
+    m_tempCount(0)
+{
+}
+
+// destructor
+
+Psid64Cache::~Psid64Cache()
+{
+    delete m_mutex;
+}
+
+
+bool
+Psid64Cache::open(const string& directory, uint_least64_t maxSize)
+{
+    MutexLock lock(*m_mutex);
+
+    m_directory.clear();
+    m_maxSize = maxSize;
+    m_entries.clear();
+    m_lru.clear();
+    m_size = 0;
+    m_useCount = 0;
+
+    if (directory.empty() || !makeDir(directory))
+    {
+        m_statusString = txt_cannotCreateDirectory;
+        return false;
+    }
+
+    // collect the entries of all subdirectories, and index them from the
+    // least to the most recently used one
+    typedef std::pair<time_t, std::pair<string, unsigned long> > Found;
+    std::vector<Found> found;
+    DIR* dp = opendir(directory.c_str());
+    if (dp != NULL)
+    {
+        struct dirent* dirp;
+        while ((dirp = readdir(dp)) != NULL)
+        {
+            const char* sub = dirp->d_name;
+            if ((strlen(sub) != 2) || !isxdigit((unsigned char) sub[0])
+                || !isxdigit((unsigned char) sub[1]))
+            {
+                continue;
+            }
+            const string subPath = directory + "/" + sub;
+            DIR* subdp = opendir(subPath.c_str());
+            if (subdp == NULL)
+            {
+                continue;
+            }
+            struct dirent* entp;
+            while ((entp = readdir(subdp)) != NULL)
+            {
+                struct stat s;
+                if (isKey(entp->d_name)
+                    && (stat((subPath + "/" + entp->d_name).c_str(), &s) == 0)
+                    && S_ISREG(s.st_mode))
+                {
+                    found.push_back(Found(s.st_mtime,
+                                          std::make_pair(string(entp->d_name),
+                                                         (unsigned long) s.st_size)));
+                }
+            }
+            closedir(subdp);
+        }
+        closedir(dp);
+    }
+    std::sort(found.begin(), found.end());
+
+    m_directory = directory;
+    for (std::vector<Found>::const_iterator it = found.begin();
+         it != found.end(); ++it)
+    {
+        index(it->second.first, it->second.second);
+    }
+    evict();
+
+    return true;
+}
+
+
+bool
+Psid64Cache::lookup(const char* key, uint_least8_t* buffer, size_t bufferSize,
+                    size_t& size)
+{
+    if (!isOpen())
+    {
+        return false;
+    }
+
+    // the entry may also have been stored by another process, so the file
+    // is looked up rather than the index
+    const string path = entryPath(key);
+    FILE* fp = fopen(path.c_str(), "rb");
+    if (fp == NULL)
+    {
+        return false;
+    }
+    size = fread(buffer, 1, bufferSize, fp);
+    const bool ok = (size > 0) && (size < bufferSize) && !ferror(fp);
+    fclose(fp);
+    if (!ok)
+    {
+        return false;
+    }
+
+    // mark the entry as recently used, also for the following runs
+    utime(path.c_str(), NULL);
+    MutexLock lock(*m_mutex);
+    index(key, size);
+
+    return true;
+}
+
+
+void
+Psid64Cache::store(const char* key, const uint_least8_t* data, size_t size)
+{
+    if (!isOpen())
+    {
+        return;
+    }
+
+    // write the entry under a temporary name and rename it afterwards, so
+    // that concurrent readers never see a partial entry
+    const string path = entryPath(key);
+    std::ostringstream tempPath;
+    {
+        MutexLock lock(*m_mutex);
+        tempPath << path << ".tmp" << getpid() << "." << m_tempCount++;
+    }
+    if (!makeDir(path.substr(0, path.length() - KEY_LENGTH - 1)))
+    {
+        return;
+    }
+    FILE* fp = fopen(tempPath.str().c_str(), "wb");
+    if (fp == NULL)
+    {
+        return;
+    }
+    bool ok = fwrite(data, 1, size, fp) == size;
+    ok = (fclose(fp) == 0) && ok;
+    if (!ok || (rename(tempPath.str().c_str(), path.c_str()) != 0))
+    {
+        remove(tempPath.str().c_str());
+        return;
+    }
+
+    MutexLock lock(*m_mutex);
+    index(key, size);
+    evict();
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//              P R I V A T E   M E M B E R   F U N C T I O N S
+//////////////////////////////////////////////////////////////////////////////
+
+string
+Psid64Cache::entryPath(const char* key) const
+{
+    string path(m_directory);
+    path += '/';
+    path.append(key, 2);
+    path += '/';
+    path += key;
+    return path;
+}
+
+
+void
+Psid64Cache::index(const string& key, unsigned long size)
+{
+    // mutex must be held by the caller
+    EntryMap::iterator it = m_entries.find(key);
+    if (it != m_entries.end())
+    {
+        m_lru.erase(it->second.lastUse);
+        m_size -= it->second.size;
+    }
+    else
+    {
+        it = m_entries.insert(EntryMap::value_type(key, Entry())).first;
+    }
+    it->second.size = size;
+    it->second.lastUse = ++m_useCount;
+    m_lru[m_useCount] = key;
+    m_size += size;
+}
+
+
+void
+Psid64Cache::evict()
+{
+    // mutex must be held by the caller
+    while ((m_size > m_maxSize) && !m_lru.empty())
+    {
+        UseMap::iterator oldest = m_lru.begin();
+        EntryMap::iterator it = m_entries.find(oldest->second);
+        remove(entryPath(oldest->second.c_str()).c_str());
+        m_size -= it->second.size;
+        m_entries.erase(it);
+        m_lru.erase(oldest);
+    }
+}
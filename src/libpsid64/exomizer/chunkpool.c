@@ -30,51 +30,83 @@
 #include "chunkpool.h"
 #include "log.h"
 
+static
 void
-chunkpool_init(struct chunkpool *ctx, int size)
+chunkpool_fail(struct chunkpool *ctx)
+{
+    if (ctx->fail != NULL)
+    {
+        longjmp(*ctx->fail, 1);
+    }
+    exit(1);
+}
+
+void
+chunkpool_init(struct chunkpool *ctx, int size, jmp_buf *fail)
 {
     ctx->chunk_size = size;
     ctx->chunk = -1;
     ctx->chunk_pos = 0;
     ctx->chunk_max = (0x1fffff / size) * size;
+    ctx->chunk_count = 0;
+    ctx->fail = fail;
 }
 
 void
 chunkpool_free(struct chunkpool *ctx)
 {
-    while(ctx->chunk >= 0)
+    while(ctx->chunk_count > 0)
     {
-        free(ctx->chunks[ctx->chunk]);
-        ctx->chunk -= 1;
+        ctx->chunk_count -= 1;
+        free(ctx->chunks[ctx->chunk_count]);
     }
+    ctx->chunk = -1;
+    ctx->chunk_pos = 0;
+}
+
+void
+chunkpool_reset(struct chunkpool *ctx)
+{
+    ctx->chunk = -1;
     ctx->chunk_pos = 0;
 }
 
+size_t
+chunkpool_size(const struct chunkpool *ctx)
+{
+    return (size_t)ctx->chunk_count * ctx->chunk_max;
+}
+
 void *
 chunkpool_malloc(struct chunkpool *ctx)
 {
     void *p;
     if(ctx->chunk_pos == 0)
     {
-        void *m;
-        if(ctx->chunk == 31)
-        {
-            LOG(LOG_ERROR, ("out of chunks in file %s, line %d\n",
-                            __FILE__, __LINE__));
-            LOG(LOG_BRIEF, ("chunk_size %d\n", ctx->chunk_size));
-            LOG(LOG_BRIEF, ("chunk_max %d\n", ctx->chunk_max));
-            LOG(LOG_BRIEF, ("chunk %d\n", ctx->chunk));
-            exit(1);
-        }
-        m = malloc(ctx->chunk_max);
-        if (m == NULL)
+        if(ctx->chunk + 1 == ctx->chunk_count)
         {
-            LOG(LOG_ERROR, ("out of memory error in file %s, line %d\n",
-                            __FILE__, __LINE__));
-            exit(1);
+            /* all chunks are in use, allocate a new one */
+            void *m;
+            if(ctx->chunk_count == 32)
+            {
+                LOG(LOG_ERROR, ("out of chunks in file %s, line %d\n",
+                                __FILE__, __LINE__));
+                LOG(LOG_BRIEF, ("chunk_size %d\n", ctx->chunk_size));
+                LOG(LOG_BRIEF, ("chunk_max %d\n", ctx->chunk_max));
+                LOG(LOG_BRIEF, ("chunk %d\n", ctx->chunk));
+                chunkpool_fail(ctx);
+            }
+            m = malloc(ctx->chunk_max);
+            if (m == NULL)
+            {
+                LOG(LOG_ERROR, ("out of memory error in file %s, line %d\n",
+                                __FILE__, __LINE__));
+                chunkpool_fail(ctx);
+            }
+            ctx->chunks[ctx->chunk_count] = m;
+            ctx->chunk_count += 1;
         }
         ctx->chunk += 1;
-        ctx->chunks[ctx->chunk] = m;
     }
     p = (char*)ctx->chunks[ctx->chunk] + ctx->chunk_pos;
     ctx->chunk_pos += ctx->chunk_size;
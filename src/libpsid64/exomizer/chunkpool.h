@@ -28,20 +28,35 @@
  *
  */
 
+#include <setjmp.h>
+#include <stddef.h>
+
 struct chunkpool {
     int chunk_size;
     int chunk;
     int chunk_pos;
     int chunk_max;
+    int chunk_count;
     void *chunks[32];
+    jmp_buf *fail;
 };
 
+/* when fail is not NULL, running out of chunks or memory does a longjmp
+ * to it instead of terminating the program */
 void
-chunkpool_init(struct chunkpool *ctx, int size);
+chunkpool_init(struct chunkpool *ctx, int size, jmp_buf *fail);
 
 void
 chunkpool_free(struct chunkpool *ctx);
 
+/* makes all chunks available again without freeing them */
+void
+chunkpool_reset(struct chunkpool *ctx);
+
+/* number of bytes allocated by the pool */
+size_t
+chunkpool_size(const struct chunkpool *ctx);
+
 void *
 chunkpool_malloc(struct chunkpool *ctx);
 
@@ -38,6 +38,18 @@
 
 #include "exomizer.h"
 
+struct exomizer_ctx {
+    match_ctx match;
+    output_ctx out;
+    search_node snp_arr[65536];
+    struct optimal_ctx optimal;
+    encode_match_data emd;
+    encode_match_priv optimal_priv;
+    jmp_buf fail;
+    int passes;                 /* statistics of the last compression */
+    unsigned long matches;
+};
+
 static
 int
 generate_output(match_ctx ctx,
@@ -45,13 +57,14 @@ generate_output(match_ctx ctx,
                 struct sfx_decruncher *decr,
                 encode_match_f * f,
                 encode_match_data emd,
+                output_ctxp out,
                 int load, int len, int start, unsigned char *buf)
 {
     int pos;
     int pos_diff;
     int max_diff;
     int diff;
-    static output_ctx out;
+    int copy_len;
     output_ctxp old;
 
     output_ctx_init(out);
@@ -110,11 +123,16 @@ generate_output(match_ctx ctx,
     output_word(out, (unsigned short int) (load + len));
 
     len = output_get_pos(out);
-    decr->load(out, (unsigned short int) load - max_diff);
+    copy_len = decr->load(out, (unsigned short int) load - max_diff);
+    if (copy_len < 0)
+    {
+        emd->out = old;
+        return EXOMIZER_ERROR_LOAD;
+    }
     output_copy_bytes(out, 0, len);
 
     /* second stage of decruncher */
-    decr->stages(out, (unsigned short int) start);
+    decr->stages(out, (unsigned short int) start, copy_len);
 
     /*len = output_ctx_close(out, of);*/
     len = out->pos - out->start;
@@ -125,28 +143,45 @@ generate_output(match_ctx ctx,
     return len;
 }
 
+struct effort {
+    int max_offset;     /* longest match offset searched for */
+    int max_passes;     /* passes of search_buffer() and optimal_optimize() */
+    float min_gain;     /* stop when a pass gains less than this fraction */
+    int retries;        /* passes without gain before giving up */
+};
+
+static const struct effort efforts[] = {
+    { 16384, 4, 0.005f, 0 },    /* EXOMIZER_EFFORT_FAST */
+    { 65536, 65536, 0.0f, 0 },  /* EXOMIZER_EFFORT_NORMAL */
+    { 65536, 65536, 0.0f, 2 },  /* EXOMIZER_EFFORT_MAX */
+};
+
 static
 search_nodep
-do_compress(match_ctx ctx, encode_match_data emd, int max_passes)
+do_compress(struct exomizer_ctx *exo, encode_match_data emd,
+            const struct effort *effort)
 {
+    match_ctxp ctx = exo->match;
     matchp_cache_enum mpce;
     matchp_snp_enum snpe;
     search_nodep snp;
-    search_nodep best_snp;
     int pass;
+    int failed;
     float old_size;
 
     pass = 1;
 
     matchp_cache_get_enum(ctx, mpce);
-    optimal_optimize(emd, matchp_cache_enum_get_next, mpce);
+    optimal_optimize(emd, matchp_cache_enum_get_next, mpce, &exo->optimal);
 
-    best_snp = NULL;
+    failed = 0;
     old_size = 1000000.0;
 
     for (;;)
     {
-        snp = search_buffer(ctx, optimal_encode, emd);
+        snp = search_buffer(ctx, optimal_encode, emd, exo->snp_arr,
+                            &exo->matches);
+        ++exo->passes;
         if (snp == NULL)
         {
             fprintf(stderr, "error: search_buffer() returned NULL\n");
@@ -156,23 +191,29 @@ do_compress(match_ctx ctx, encode_match_data emd, int max_passes)
         float size = snp->total_score;
         if (size >= old_size)
         {
-#if 0 /* RH */
-            search_node_free(snp);
-#endif /* RH */
-            break;
+            if (++failed > effort->retries)
+            {
+                break;
+            }
         }
-
-#if 0 /* RH */
-        if (best_snp != NULL)
+        else
         {
-            search_node_free(best_snp);
+            float gain = old_size - size;
+
+            failed = 0;
+            old_size = size;
+            if (effort->retries > 0)
+            {
+                optimal_keep(emd, &exo->optimal);
+            }
+            if (gain < size * effort->min_gain)
+            {
+                break;
+            }
         }
-#endif /* RH */
-        best_snp = snp;
-        old_size = size;
         ++pass;
 
-        if (pass > max_passes)
+        if (pass > effort->max_passes)
         {
             break;
         }
@@ -181,40 +222,102 @@ do_compress(match_ctx ctx, encode_match_data emd, int max_passes)
         optimal_init(emd);
 
         matchp_snp_get_enum(snp, snpe);
-        optimal_optimize(emd, matchp_snp_enum_get_next, snpe);
+        optimal_optimize(emd, matchp_snp_enum_get_next, snpe, &exo->optimal);
+    }
+
+    if (failed > 0 && effort->retries > 0)
+    {
+        /* the last passes were worse, search again with the tables of the
+         * best one */
+        optimal_restore(emd, &exo->optimal);
+        snp = search_buffer(ctx, optimal_encode, emd, exo->snp_arr,
+                            &exo->matches);
+        ++exo->passes;
+    }
+
+    /* the nodes are kept in the context, the search of the final pass
+     * always uses the tables in emd so they are consistent */
+    return snp;
+}
+
+
+struct exomizer_ctx *exomizer_ctx_new(void)
+{
+    struct exomizer_ctx *exo;
+
+    exo = calloc(1, sizeof(struct exomizer_ctx));
+    if (exo != NULL)
+    {
+        match_ctx_setup(exo->match, &exo->fail);
+        optimal_ctx_init(&exo->optimal, &exo->fail);
     }
+    return exo;
+}
 
-    return best_snp;
+void exomizer_ctx_free(struct exomizer_ctx *exo)      /* IN/OUT */
+{
+    if (exo != NULL)
+    {
+        match_ctx_free(exo->match);
+        optimal_ctx_free(&exo->optimal);
+        free(exo);
+    }
 }
 
+size_t exomizer_ctx_memory(const struct exomizer_ctx *exo)    /* IN */
+{
+    return sizeof(struct exomizer_ctx) + chunkpool_size(exo->match->m_pool) +
+        optimal_ctx_size(&exo->optimal);
+}
 
-int exomizer(const unsigned char *srcbuf, int len, int load, int start, unsigned char *destbuf)
+void exomizer_ctx_stats(const struct exomizer_ctx *exo,     /* IN */
+                        int *passes, unsigned long *matches) /* OUT */
+{
+    *passes = exo->passes;
+    *matches = exo->matches;
+}
+
+int exomizer(struct exomizer_ctx *exo, /* IN/OUT */
+             const unsigned char *srcbuf, int len, int load, int start,
+             int effort, unsigned char *destbuf)
 {
     int destlen;
-    int max_offset = 65536;
-    int max_passes = 65536;
-    static match_ctx ctx;
-    encode_match_data emd;
-    encode_match_priv optimal_priv;
+    match_ctxp ctx = exo->match;
+    encode_match_datap emd = exo->emd;
     search_nodep snp;
 
-    match_ctx_init(ctx, srcbuf, len, max_offset);
+    if (effort < EXOMIZER_EFFORT_FAST || effort > EXOMIZER_EFFORT_MAX)
+    {
+        effort = EXOMIZER_EFFORT_NORMAL;
+    }
+
+    exo->passes = 0;
+    exo->matches = 0;
 
     emd->out = NULL;
-    emd->priv = optimal_priv;
+    emd->priv = exo->optimal_priv;
+    exo->optimal_priv->offset_f_priv = NULL;
+
+    /* the pools jump back here when they run out of memory, all state
+     * that needs to be cleaned up is kept in the context */
+    if (setjmp(exo->fail) != 0)
+    {
+        optimal_free(emd);
+        return EXOMIZER_ERROR_MEMORY;
+    }
+
+    match_ctx_init(ctx, srcbuf, len, efforts[effort].max_offset);
 
     optimal_init(emd);
 
-    snp = do_compress(ctx, emd, max_passes);
+    snp = do_compress(exo, emd, &efforts[effort]);
 
     destlen = generate_output(ctx, snp, sfx_c64ne, optimal_encode, emd,
-                              load, len, start, destbuf);
+                              exo->out, load, len, start, destbuf);
     optimal_free(emd);
 
-#if 0 /* RH */
-    search_node_free(snp);
-#endif /* RH */
-    match_ctx_free(ctx);
+    /* the search nodes are kept in the context and the match pool is
+     * reset by the next match_ctx_init(), so nothing is freed here */
 
     return destlen;
 }
@@ -32,7 +32,37 @@ extern "C" {
 #endif
 
 
-int exomizer(const unsigned char *srcbuf, int len, int load, int start, unsigned char *destbuf);
+#include <stddef.h>
+
+/* error codes returned by exomizer() */
+#define EXOMIZER_ERROR_MEMORY -1        /* out of memory or pool chunks */
+#define EXOMIZER_ERROR_LOAD -2          /* load address too low */
+
+/* compression effort levels, more effort gives smaller output */
+#define EXOMIZER_EFFORT_FAST 0          /* few passes, short offsets */
+#define EXOMIZER_EFFORT_NORMAL 1        /* pass until the size grows */
+#define EXOMIZER_EFFORT_MAX 2           /* keep trying, use the best pass */
+
+/* all working state of a compression, several contexts can be used
+ * concurrently by different threads */
+struct exomizer_ctx;
+
+struct exomizer_ctx *exomizer_ctx_new(void);
+
+void exomizer_ctx_free(struct exomizer_ctx *ctx);     /* IN/OUT */
+
+/* number of bytes allocated by the context, the memory of a compression
+ * is kept for reuse by the next one so this is also the peak usage */
+size_t exomizer_ctx_memory(const struct exomizer_ctx *ctx);   /* IN */
+
+/* number of search passes and matches evaluated by the last compression */
+void exomizer_ctx_stats(const struct exomizer_ctx *ctx,     /* IN */
+                        int *passes, unsigned long *matches); /* OUT */
+
+/* returns the size of the compressed data or a negative error code */
+int exomizer(struct exomizer_ctx *ctx, /* IN/OUT */
+             const unsigned char *srcbuf, int len, int load, int start,
+             int effort, unsigned char *destbuf);
 
 #ifdef __cplusplus
 }
@@ -60,13 +60,18 @@ matchp match_new(match_ctx ctx, /* IN/OUT */
 }
 
 
+void match_ctx_setup(match_ctx ctx,     /* OUT */
+                     jmp_buf *fail)     /* IN */
+{
+    chunkpool_init(ctx->m_pool, sizeof(match), fail);
+}
+
 void match_ctx_init(match_ctx ctx,      /* IN/OUT */
                     const unsigned char *buf,      /* IN */
                     int buf_len,        /* IN */
                     int max_offset)
 {
     struct match_node *np;
-    struct chunkpool map_pool[1];
 
     int c, i;
     int val;
@@ -75,8 +80,7 @@ void match_ctx_init(match_ctx ctx,      /* IN/OUT */
     memset(ctx->rle, 0, sizeof(ctx->rle));
     memset(ctx->rle_r, 0, sizeof(ctx->rle_r));
 
-    chunkpool_init(ctx->m_pool, sizeof(match));
-    chunkpool_init(map_pool, sizeof(match));
+    chunkpool_reset(ctx->m_pool);
 
     ctx->max_offset = max_offset;
 
@@ -114,12 +118,12 @@ void match_ctx_init(match_ctx ctx,      /* IN/OUT */
     /* add extra nodes to rle sequences */
     for(c = 0; c < 256; ++c)
     {
-        static char rle_map[65536];
+        char *rle_map = ctx->rle_map;
         struct match_node *prev_np;
         int rle_len;
 
         /* for each possible rle char */
-        memset(rle_map, 0, sizeof(rle_map));
+        memset(rle_map, 0, sizeof(ctx->rle_map));
         prev_np = NULL;
         for (i = 0; i < buf_len; ++i)
         {
@@ -155,7 +159,7 @@ void match_ctx_init(match_ctx ctx,      /* IN/OUT */
             prev_np = np;
         }
 
-        memset(rle_map, 0, sizeof(rle_map));
+        memset(rle_map, 0, sizeof(ctx->rle_map));
         prev_np = NULL;
         for (i = buf_len - 1; i >= 0; --i)
         {
@@ -211,8 +215,6 @@ void match_ctx_init(match_ctx ctx,      /* IN/OUT */
     }
 
     LOG(LOG_NORMAL, ("\n"));
-
-    chunkpool_free(map_pool);
 }
 
 void match_ctx_free(match_ctx ctx)      /* IN/OUT */
@@ -51,6 +51,7 @@ struct match_ctx {
     pre_calc info[65536];
     unsigned short int rle[65536];
     unsigned short int rle_r[65536];
+    char rle_map[65536];
     const unsigned char *buf;
     int len;
     int max_offset;
@@ -59,6 +60,11 @@ struct match_ctx {
 typedef struct match_ctx match_ctx[1];
 typedef struct match_ctx *match_ctxp;
 
+/* sets up the pool, must be called once before match_ctx_init() */
+void match_ctx_setup(match_ctx ctx,     /* OUT */
+                     jmp_buf *fail);    /* IN */
+
+/* may be called repeatedly, the pool chunks of a previous call are reused */
 void match_ctx_init(match_ctx ctx,      /* IN/OUT */
                     const unsigned char *buf,   /* IN */
                     int buf_len,        /* IN */
@@ -64,38 +64,22 @@ interval_node_init(interval_nodep inp, int start, int depth, int flags)
 }
 
 static
-interval_nodep interval_node_clone(interval_nodep inp)
+interval_nodep interval_node_clone(struct chunkpool *pool,
+                                   interval_nodep inp)
 {
     interval_nodep inp2 = NULL;
 
     if(inp != NULL)
     {
-        inp2 = malloc(sizeof(interval_node));
-        if (inp2 == NULL)
-        {
-            LOG(LOG_ERROR, ("out of memory error in file %s, line %d\n",
-                            __FILE__, __LINE__));
-            exit(0);
-        }
+        inp2 = chunkpool_malloc(pool);
         /* copy contents */
         *inp2 = *inp;
-        inp2->next = interval_node_clone(inp->next);
+        inp2->next = interval_node_clone(pool, inp->next);
     }
 
     return inp2;
 }
 
-static
-void interval_node_delete(interval_nodep inp)
-{
-    while (inp != NULL)
-    {
-        interval_nodep inp2 = inp;
-        inp = inp->next;
-        free(inp2);
-    }
-}
-
 #if 0 /* RH */
 static
 void interval_node_dump(interval_nodep inp)
@@ -240,7 +224,7 @@ struct _optimize_arg {
     int *stats2;
     int max_depth;
     int flags;
-    struct chunkpool in_pool[1];
+    struct chunkpool *in_pool;
 };
 
 #define CACHE_KEY(START, DEPTH, MAXDEPTH) ((int)((START)*(MAXDEPTH)|DEPTH))
@@ -341,7 +325,8 @@ optimize1(optimize_arg arg, int start, int depth)
 }
 
 static interval_nodep
-optimize(int stats[65536], int stats2[65536], int max_depth, int flags)
+optimize(struct optimal_ctx *ctx,
+         int stats[65536], int stats2[65536], int max_depth, int flags)
 {
     optimize_arg arg;
 
@@ -353,22 +338,46 @@ optimize(int stats[65536], int stats2[65536], int max_depth, int flags)
     arg->max_depth = max_depth;
     arg->flags = flags;
 
-    chunkpool_init(arg->in_pool, sizeof(interval_node));
+    chunkpool_reset(ctx->in_pool);
+    arg->in_pool = ctx->in_pool;
 
-    radix_tree_init(arg->cache);
+    chunkpool_reset(ctx->cache_pool);
+    radix_tree_init(arg->cache, ctx->cache_pool);
 
     inp = optimize1(arg, 1, 0);
 
-    /* use normal malloc for the winner */
-    inp = interval_node_clone(inp);
+    /* the winner outlives the pools of the search */
+    inp = interval_node_clone(ctx->winner_pool, inp);
 
     /* cleanup */
     radix_tree_free(arg->cache, NULL, NULL);
-    chunkpool_free(arg->in_pool);
 
     return inp;
 }
 
+void optimal_ctx_init(struct optimal_ctx *ctx,  /* OUT */
+                      jmp_buf *fail)    /* IN */
+{
+    chunkpool_init(ctx->in_pool, sizeof(interval_node), fail);
+    chunkpool_init(ctx->cache_pool, RADIX_TREE_NODE_SIZE, fail);
+    chunkpool_init(ctx->winner_pool, sizeof(interval_node), fail);
+    chunkpool_init(ctx->kept_pool, sizeof(interval_node), fail);
+}
+
+void optimal_ctx_free(struct optimal_ctx *ctx)  /* IN/OUT */
+{
+    chunkpool_free(ctx->in_pool);
+    chunkpool_free(ctx->cache_pool);
+    chunkpool_free(ctx->winner_pool);
+    chunkpool_free(ctx->kept_pool);
+}
+
+size_t optimal_ctx_size(const struct optimal_ctx *ctx)  /* IN */
+{
+    return chunkpool_size(ctx->in_pool) + chunkpool_size(ctx->cache_pool) +
+        chunkpool_size(ctx->winner_pool) + chunkpool_size(ctx->kept_pool);
+}
+
 
 /*static interval_nodep optimal_offset[16] = {NULL, NULL};
   static interval_nodep optimal_len = NULL;*/
@@ -384,7 +393,7 @@ void optimal_init(encode_match_data emd)        /* OUT */
 
     data->offset_f = optimal_encode_int;
     data->len_f = optimal_encode_int;
-    inpp = malloc(sizeof(interval_nodep[8]));
+    inpp = data->offset_f_tables;
     inpp[0] = NULL;
     inpp[1] = NULL;
     inpp[2] = NULL;
@@ -400,28 +409,11 @@ void optimal_init(encode_match_data emd)        /* OUT */
 void optimal_free(encode_match_data emd)        /* IN */
 {
     encode_match_privp data;
-    interval_nodep *inpp;
-    interval_nodep inp;
 
     data = emd->priv;
 
-    inpp = data->offset_f_priv;
-    if (inpp != NULL)
-    {
-        interval_node_delete(inpp[0]);
-        interval_node_delete(inpp[1]);
-        interval_node_delete(inpp[2]);
-        interval_node_delete(inpp[3]);
-        interval_node_delete(inpp[4]);
-        interval_node_delete(inpp[5]);
-        interval_node_delete(inpp[6]);
-        interval_node_delete(inpp[7]);
-    }
-    free(inpp);
-
-    inp = data->len_f_priv;
-    interval_node_delete(inp);
-
+    /* the interval nodes are owned by the winner pool of the optimal_ctx
+     * and the table of offset tables is part of data */
     data->offset_f_priv = NULL;
     data->len_f_priv = NULL;
 }
@@ -450,14 +442,15 @@ void freq_stats_dump_raw(int arr[65536])
 
 void optimal_optimize(encode_match_data emd,    /* IN/OUT */
                       matchp_enum_get_next_f * f,       /* IN */
-                      void *matchp_enum)        /* IN */
+                      void *matchp_enum,        /* IN */
+                      struct optimal_ctx *ctx)  /* IN/OUT */
 {
     encode_match_privp data;
     const_matchp mp;
     interval_nodep *offset;
-    static int offset_arr[8][65536];
-    static int offset_parr[8][65536];
-    static int len_arr[65536];
+    int (*offset_arr)[65536] = ctx->offset_arr;
+    int (*offset_parr)[65536] = ctx->offset_parr;
+    int *len_arr = ctx->len_arr;
     int treshold;
 
     int i, j;
@@ -465,9 +458,12 @@ void optimal_optimize(encode_match_data emd,    /* IN/OUT */
 
     data = emd->priv;
 
-    memset(offset_arr, 0, sizeof(offset_arr));
-    memset(offset_parr, 0, sizeof(offset_parr));
-    memset(len_arr, 0, sizeof(len_arr));
+    memset(ctx->offset_arr, 0, sizeof(ctx->offset_arr));
+    memset(ctx->offset_parr, 0, sizeof(ctx->offset_parr));
+    memset(ctx->len_arr, 0, sizeof(ctx->len_arr));
+
+    /* the tables of the previous call are no longer in use */
+    chunkpool_reset(ctx->winner_pool);
 
     offset = data->offset_f_priv;
 
@@ -486,7 +482,7 @@ void optimal_optimize(encode_match_data emd,    /* IN/OUT */
         len_arr[i] += len_arr[i + 1];
     }
 
-    data->len_f_priv = optimize(len_arr, NULL, 16, -1);
+    data->len_f_priv = optimize(ctx, len_arr, NULL, 16, -1);
 
     /* then the offsets */
     priv1 = matchp_enum;
@@ -540,14 +536,51 @@ void optimal_optimize(encode_match_data emd,    /* IN/OUT */
         }
     }
 
-    offset[0] = optimize(offset_arr[0], offset_parr[0], 1 << 2, 2);
-    offset[1] = optimize(offset_arr[1], offset_parr[1], 1 << 4, 4);
-    offset[2] = optimize(offset_arr[2], offset_parr[2], 1 << 4, 4);
-    offset[3] = optimize(offset_arr[3], offset_parr[3], 1 << 4, 4);
-    offset[4] = optimize(offset_arr[4], offset_parr[4], 1 << 4, 4);
-    offset[5] = optimize(offset_arr[5], offset_parr[5], 1 << 4, 4);
-    offset[6] = optimize(offset_arr[6], offset_parr[6], 1 << 4, 4);
-    offset[7] = optimize(offset_arr[7], offset_parr[7], 1 << 4, 4);
+    offset[0] = optimize(ctx, offset_arr[0], offset_parr[0], 1 << 2, 2);
+    offset[1] = optimize(ctx, offset_arr[1], offset_parr[1], 1 << 4, 4);
+    offset[2] = optimize(ctx, offset_arr[2], offset_parr[2], 1 << 4, 4);
+    offset[3] = optimize(ctx, offset_arr[3], offset_parr[3], 1 << 4, 4);
+    offset[4] = optimize(ctx, offset_arr[4], offset_parr[4], 1 << 4, 4);
+    offset[5] = optimize(ctx, offset_arr[5], offset_parr[5], 1 << 4, 4);
+    offset[6] = optimize(ctx, offset_arr[6], offset_parr[6], 1 << 4, 4);
+    offset[7] = optimize(ctx, offset_arr[7], offset_parr[7], 1 << 4, 4);
+}
+
+void optimal_keep(encode_match_data emd,        /* IN */
+                  struct optimal_ctx *ctx)      /* IN/OUT */
+{
+    encode_match_privp data;
+    interval_nodep *offset;
+    int i;
+
+    data = emd->priv;
+    offset = data->offset_f_priv;
+
+    chunkpool_reset(ctx->kept_pool);
+    for (i = 0; i < 8; ++i)
+    {
+        ctx->kept_offset_f_priv[i] =
+            interval_node_clone(ctx->kept_pool, offset[i]);
+    }
+    ctx->kept_len_f_priv = interval_node_clone(ctx->kept_pool,
+                                               data->len_f_priv);
+}
+
+void optimal_restore(encode_match_data emd,     /* IN/OUT */
+                     struct optimal_ctx *ctx)   /* IN */
+{
+    encode_match_privp data;
+    interval_nodep *offset;
+    int i;
+
+    data = emd->priv;
+    offset = data->offset_f_priv;
+
+    for (i = 0; i < 8; ++i)
+    {
+        offset[i] = ctx->kept_offset_f_priv[i];
+    }
+    data->len_f_priv = ctx->kept_len_f_priv;
 }
 
 #if 0 /* RH */
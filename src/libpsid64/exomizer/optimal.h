@@ -30,6 +30,29 @@
 
 #include "search.h"
 #include "output.h"
+#include "chunkpool.h"
+
+/* working memory of optimal_optimize(), the encoding tables it creates
+ * stay valid until the next call */
+struct optimal_ctx {
+    int offset_arr[8][65536];
+    int offset_parr[8][65536];
+    int len_arr[65536];
+    struct chunkpool in_pool[1];
+    struct chunkpool cache_pool[1];
+    struct chunkpool winner_pool[1];
+    /* a copy of the encoding tables made by optimal_keep() */
+    struct chunkpool kept_pool[1];
+    void *kept_offset_f_priv[8];
+    void *kept_len_f_priv;
+};
+
+void optimal_ctx_init(struct optimal_ctx *ctx,  /* OUT */
+                      jmp_buf *fail);   /* IN */
+
+void optimal_ctx_free(struct optimal_ctx *ctx); /* IN/OUT */
+
+size_t optimal_ctx_size(const struct optimal_ctx *ctx); /* IN */
 
 float optimal_encode(const_matchp mp,   /* IN */
                      encode_match_data emp);    /* IN */
@@ -40,7 +63,17 @@ void optimal_free(encode_match_data emd);       /* IN */
 
 void optimal_optimize(encode_match_data emd,    /* IN/OUT */
                       matchp_enum_get_next_f * f,       /* IN */
-                      void *priv);      /* IN */
+                      void *priv,       /* IN */
+                      struct optimal_ctx *ctx); /* IN/OUT */
+
+/* copies the current encoding tables so they survive the following calls
+ * of optimal_optimize() */
+void optimal_keep(encode_match_data emd,        /* IN */
+                  struct optimal_ctx *ctx);     /* IN/OUT */
+
+/* makes the tables copied by the last optimal_keep() current again */
+void optimal_restore(encode_match_data emd,     /* IN/OUT */
+                     struct optimal_ctx *ctx);  /* IN */
 
 void optimal_fixup(encode_match_data emd,       /* IN/OUT */
                    int max_len, /* IN */
@@ -32,19 +32,18 @@
 #include "radix.h"
 #include "chunkpool.h"
 
-#define RADIX_TREE_NODE_RADIX 11U
 #define RADIX_TREE_NODE_MASK  ((1U << RADIX_TREE_NODE_RADIX) - 1U)
 
 struct _radix_node {
     struct _radix_node *rn;
 };
 
-void radix_tree_init(radix_root rr)     /* IN */
+void radix_tree_init(radix_root rr,     /* IN/OUT */
+                     struct chunkpool *mem)     /* IN */
 {
     rr->depth = 0;
     rr->root = NULL;
-
-    chunkpool_init(rr->mem, (1 << RADIX_TREE_NODE_RADIX) * sizeof(void *));
+    rr->mem = mem;
 }
 
 static
@@ -85,7 +84,6 @@ void radix_tree_free(radix_root rr,     /* IN */
     radix_tree_free_helper(rr->depth, rr->root, f, priv);
     rr->depth = 0;
     rr->root = NULL;
-    chunkpool_free(rr->mem);
 }
 
 void radix_node_set(radix_rootp rrp,    /* IN */
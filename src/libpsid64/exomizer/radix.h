@@ -29,12 +29,15 @@
 
 #include "chunkpool.h"
 
+#define RADIX_TREE_NODE_RADIX 11U
+#define RADIX_TREE_NODE_SIZE ((1 << RADIX_TREE_NODE_RADIX) * sizeof(void *))
+
 typedef struct _radix_node *radix_nodep;
 
 struct _radix_root {
     int depth;
     radix_nodep root;
-    struct chunkpool mem[1];
+    struct chunkpool *mem;
 };
 
 typedef struct _radix_root radix_root[1];
@@ -48,7 +51,10 @@ void radix_tree_free(radix_root rr,     /* IN */
                      free_callback * f, /* IN */
                      void *priv);       /* IN */
 
-void radix_tree_init(radix_root rr);    /* IN */
+/* the nodes are allocated from mem, which must have been initialized with
+ * RADIX_TREE_NODE_SIZE as size and is not freed by radix_tree_free() */
+void radix_tree_init(radix_root rr,     /* IN/OUT */
+                     struct chunkpool *mem);    /* IN */
 
 void radix_node_set(radix_rootp rrp,    /* IN */
                     unsigned int index, /* IN */
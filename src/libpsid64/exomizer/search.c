@@ -62,9 +62,11 @@ void search_node_dump(search_nodep snp) /* IN */
 
 search_nodep search_buffer(match_ctx ctx,       /* IN */
                            encode_match_f * f,  /* IN */
-                           encode_match_data emd)       /* IN */
+                           encode_match_data emd,       /* IN */
+                           search_node *snp_arr,        /* IN/OUT */
+                           unsigned long *evaluated)    /* IN/OUT */
 {
-    static search_node snp_arr[65536];
+    unsigned long count = 0;
     const_matchp mp;
     search_nodep snp;
 #if 0 /* RH */
@@ -76,7 +78,7 @@ search_nodep search_buffer(match_ctx ctx,       /* IN */
 
     int len = ctx->len;
 
-    memset(snp_arr, 0, sizeof(snp_arr));
+    memset(snp_arr, 0, 65536 * sizeof(search_node));
 
     snp = snp_arr[len];
     snp->index = len;
@@ -237,6 +239,7 @@ search_nodep search_buffer(match_ctx ctx,       /* IN */
 
                 score = f(tmp, emd);
                 total_score = prev_score + score;
+                ++count;
 
                 snp = snp_arr[len - tmp->len];
 
@@ -293,6 +296,7 @@ search_nodep search_buffer(match_ctx ctx,       /* IN */
     }
     LOG(LOG_NORMAL, ("\n"));
 
+    *evaluated += count;
     return snp_arr[0];
 }
 
@@ -68,6 +68,8 @@ struct _encode_match_priv {
     encode_int_f *len_f;
     void *offset_f_priv;
     void *len_f_priv;
+    /* offset_f_priv points here, so no memory is allocated per pass */
+    struct _interval_node *offset_f_tables[8];
 
     output_ctxp out;
 };
@@ -83,9 +85,13 @@ void search_node_dump(search_nodep snp);        /* IN */
 
 void search_node_free(search_nodep snp);        /* IN/OUT */
 
+/* snp_arr must hold 65536 nodes, the returned node points into it, the
+ * number of matches evaluated is added to *evaluated */
 search_nodep search_buffer(match_ctx ctx,       /* IN */
                            encode_match_f * f,  /* IN */
-                           encode_match_data emd);      /* IN */
+                           encode_match_data emd,       /* IN */
+                           search_node *snp_arr,        /* IN/OUT */
+                           unsigned long *evaluated);   /* IN/OUT */
 
 struct _matchp_snp_enum {
     const_search_nodep startp;
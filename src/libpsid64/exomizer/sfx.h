@@ -29,13 +29,16 @@
  */
 
 #include "output.h"
+/* returns the number of bytes the stages need to copy or -1 when the
+ * load address can't be handled */
 typedef
-void sfx1_set_new_load_f(output_ctx out,        /* IN/OUT */
-                         unsigned short int load);      /* IN */
+int sfx1_set_new_load_f(output_ctx out, /* IN/OUT */
+                        unsigned short int load);       /* IN */
 
 typedef
 void sfx2_add_stages_f(output_ctx out,  /* IN/OUT */
-                       unsigned short int start);       /* IN */
+                       unsigned short int start,        /* IN */
+                       unsigned int copy_len);  /* IN */
 struct sfx_decruncher {
     sfx1_set_new_load_f *load;
     sfx2_add_stages_f *stages;
@@ -45,7 +45,7 @@ static const unsigned char stage1[] = {
 #define STAGE1_BEGIN 0x07ff
 #define STAGE1_END   (STAGE1_BEGIN + sizeof(stage1))
 
-static unsigned char stage2[] = {
+static const unsigned char stage2[] = {
     0xE8, 0xA9, 0x00, 0x85, 0xFC, 0x85, 0xFB, 0xE0,
     0x01, 0x90, 0x21, 0xA5, 0xFD, 0x4A, 0xD0, 0x11,
     0xAD, 0x1C, 0x01, 0xD0, 0x03,
@@ -81,14 +81,14 @@ static unsigned char stage2[] = {
 #define STAGE2_START        49
 #define STAGE2_COPY_LEN_LO 225
 
-static unsigned char stage3s[] = {
+static const unsigned char stage3s[] = {
     0xB9, 0x00, 0x00, 0x99, 0x00, 0x00, 0x88, 0xD0,
     0xF7, 0x4C, 0x43, 0x01
 };
 #define STAGE3S_COPY_SRC    1
 #define STAGE3S_COPY_DEST   4
 
-static unsigned char stage3l[] = {
+static const unsigned char stage3l[] = {
     0xA2, 0x00, 0xB0, 0x0E, 0xCA, 0xCE, 0x1A, 0x09,
     0xCE, 0x1D, 0x09, 0x88, 0xB9, 0x00, 0x00, 0x99,
     0x00, 0x00, 0x98, 0xD0, 0xF6, 0x8A, 0xD0, 0xEC,
@@ -100,18 +100,18 @@ static unsigned char stage3l[] = {
 #define STAGE3L_COPY_SRC    13
 #define STAGE3L_COPY_DEST   16
 
-static unsigned int L_copy_len;
 static
-void load(output_ctx out,       /* IN/OUT */
-          unsigned short int load)      /* IN */
+int load(output_ctx out,        /* IN/OUT */
+         unsigned short int load)       /* IN */
 {
     unsigned short int new_load;
+    unsigned int L_copy_len;
     if (load < DECOMP_MIN_ADDR)
     {
         LOG(LOG_ERROR,
             ("error: cant handle load address < $%04X\n",
              DECOMP_MIN_ADDR));
-        exit(1);
+        return -1;
     }
 
     output_ctx_set_start(out, STAGE1_BEGIN);
@@ -132,11 +132,13 @@ void load(output_ctx out,       /* IN/OUT */
     LOG(LOG_DUMP, ("copy_len $%04X\n", L_copy_len));
     LOG(LOG_DUMP, ("new_load $%04X\n", new_load));
 
+    return (int) L_copy_len;
 }
 
 static
 void stages(output_ctx out,     /* IN/OUT */
-            unsigned short int start)   /* IN */
+            unsigned short int start,   /* IN */
+            unsigned int L_copy_len)    /* IN */
 {
     unsigned int i;
     int stage2_begin;
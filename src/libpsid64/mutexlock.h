@@ -0,0 +1,173 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+    psid64 - create a C64 executable from a PSID file
+    Copyright (C) 2001-2023  Roland Hermans <rolandh@users.sourceforge.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef MUTEXLOCK_H
+#define MUTEXLOCK_H
+
+//////////////////////////////////////////////////////////////////////////////
+//                             I N C L U D E S
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                     D A T A   D E C L A R A T O R S
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Mutual exclusion lock. On systems without POSIX threads all operations
+ * are no-ops.
+ */
+class Mutex
+{
+public:
+    Mutex()
+    {
+#ifdef HAVE_PTHREAD_H
+        pthread_mutex_init(&m_mutex, NULL);
+#endif
+    }
+
+    ~Mutex()
+    {
+#ifdef HAVE_PTHREAD_H
+        pthread_mutex_destroy(&m_mutex);
+#endif
+    }
+
+    void lock()
+    {
+#ifdef HAVE_PTHREAD_H
+        pthread_mutex_lock(&m_mutex);
+#endif
+    }
+
+    void unlock()
+    {
+#ifdef HAVE_PTHREAD_H
+        pthread_mutex_unlock(&m_mutex);
+#endif
+    }
+
+private:
+    Mutex(const Mutex&);
+    Mutex& operator=(const Mutex&);
+
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_t m_mutex;
+#endif
+};
+
+
+/**
+ * Holds a mutex locked for the lifetime of the object.
+ */
+class MutexLock
+{
+public:
+    explicit MutexLock(Mutex& mutex) : m_mutex(mutex)
+    {
+        m_mutex.lock();
+    }
+
+    ~MutexLock()
+    {
+        m_mutex.unlock();
+    }
+
+private:
+    MutexLock(const MutexLock&);
+    MutexLock& operator=(const MutexLock&);
+
+    Mutex& m_mutex;
+};
+
+
+/**
+ * Flag that is set once, e.g. when a resource has been loaded under a
+ * mutex, and is then tested without taking the mutex. Setting the flag
+ * releases the writes made before it to the threads that see it set. On
+ * systems with POSIX threads but without atomic operations isSet() always
+ * returns false, so the caller takes the mutex and tests again.
+ */
+class OnceFlag
+{
+public:
+    OnceFlag() : m_set(0)
+    {
+    }
+
+    /**
+     * Test the flag without holding the mutex.
+     */
+    bool isSet() const
+    {
+#if defined(HAVE_ATOMIC_BUILTINS)
+        return __atomic_load_n(&m_set, __ATOMIC_ACQUIRE) != 0;
+#elif defined(HAVE_PTHREAD_H)
+        return false;
+#else
+        return m_set != 0;
+#endif
+    }
+
+    /**
+     * Test the flag with the mutex held.
+     */
+    bool isSetLocked() const
+    {
+        return m_set != 0;
+    }
+
+    /**
+     * Set the flag with the mutex held.
+     */
+    void set()
+    {
+#ifdef HAVE_ATOMIC_BUILTINS
+        __atomic_store_n(&m_set, 1, __ATOMIC_RELEASE);
+#else
+        m_set = 1;
+#endif
+    }
+
+    /**
+     * Clear the flag while no other thread uses it.
+     */
+    void clear()
+    {
+        m_set = 0;
+    }
+
+private:
+    OnceFlag(const OnceFlag&);
+    OnceFlag& operator=(const OnceFlag&);
+
+    int m_set;
+};
+
+#endif  // MUTEXLOCK_H
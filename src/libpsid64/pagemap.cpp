@@ -0,0 +1,189 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+    psid64 - create a C64 executable from a PSID file
+    Copyright (C) 2001-2023  Roland Hermans <rolandh@users.sourceforge.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+//////////////////////////////////////////////////////////////////////////////
+//                             I N C L U D E S
+//////////////////////////////////////////////////////////////////////////////
+
+#include "pagemap.h"
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                      G L O B A L   F U N C T I O N S
+//////////////////////////////////////////////////////////////////////////////
+
+// constructor
+
+PageMap::PageMap()
+{
+    setAll(false);
+}
+
+
+void PageMap::setAll(bool used)
+{
+    for (unsigned int i = 0; i < NUM_WORDS; ++i)
+    {
+        m_used[i] = used ? ~static_cast<word_t>(0) : 0;
+    }
+}
+
+
+void PageMap::reserve(unsigned int first, unsigned int count)
+{
+    setRange(first, count, true);
+}
+
+
+void PageMap::release(unsigned int first, unsigned int count)
+{
+    setRange(first, count, false);
+}
+
+
+bool PageMap::isFree(unsigned int first, unsigned int count) const
+{
+    unsigned int end = first + count;
+    if (end > NUM_PAGES)
+    {
+        return false;
+    }
+    while (first < end)
+    {
+        unsigned int bit = first % WORD_BITS;
+        unsigned int n = end - first;
+        if (n > (WORD_BITS - bit))
+        {
+            n = WORD_BITS - bit;
+        }
+        if (m_used[first / WORD_BITS] & rangeMask(bit, n))
+        {
+            return false;
+        }
+        first += n;
+    }
+    return true;
+}
+
+
+unsigned int PageMap::findFreeRun(unsigned int size, unsigned int from) const
+{
+    unsigned int page = from;
+    for (;;)
+    {
+        unsigned int first = findPage(page, false);
+        if (first == NUM_PAGES)
+        {
+            return 0;
+        }
+        unsigned int end = findPage(first, true);
+        if (end == NUM_PAGES)
+        {
+            return 0;
+        }
+        if ((end - first) >= size)
+        {
+            return first;
+        }
+        page = end;
+    }
+}
+
+
+unsigned int PageMap::findUsedPage(unsigned int page) const
+{
+    return findPage(page, true);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//              P R I V A T E   M E M B E R   F U N C T I O N S
+//////////////////////////////////////////////////////////////////////////////
+
+PageMap::word_t PageMap::rangeMask(unsigned int bit, unsigned int count)
+{
+    word_t mask = (count >= WORD_BITS)
+        ? ~static_cast<word_t>(0)
+        : (static_cast<word_t>(1) << count) - 1;
+    return mask << bit;
+}
+
+
+unsigned int PageMap::countTrailingZeros(word_t bits)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(bits);
+#else
+    unsigned int n = 0;
+    while (!(bits & 1))
+    {
+        bits >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+
+void PageMap::setRange(unsigned int first, unsigned int count, bool used)
+{
+    unsigned int end = first + count;
+    if (end > NUM_PAGES)
+    {
+        end = NUM_PAGES;
+    }
+    while (first < end)
+    {
+        unsigned int bit = first % WORD_BITS;
+        unsigned int n = end - first;
+        if (n > (WORD_BITS - bit))
+        {
+            n = WORD_BITS - bit;
+        }
+        if (used)
+        {
+            m_used[first / WORD_BITS] |= rangeMask(bit, n);
+        }
+        else
+        {
+            m_used[first / WORD_BITS] &= ~rangeMask(bit, n);
+        }
+        first += n;
+    }
+}
+
+
+unsigned int PageMap::findPage(unsigned int page, bool used) const
+{
+    // returns the first page from page onwards that is used or free, or
+    // NUM_PAGES if there is none
+    while (page < NUM_PAGES)
+    {
+        unsigned int index = page / WORD_BITS;
+        word_t bits = used ? m_used[index] : ~m_used[index];
+        bits &= ~static_cast<word_t>(0) << (page % WORD_BITS);
+        if (bits)
+        {
+            return (index * WORD_BITS) + countTrailingZeros(bits);
+        }
+        page = (index + 1) * WORD_BITS;
+    }
+    return NUM_PAGES;
+}
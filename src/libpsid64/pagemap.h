@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+    psid64 - create a C64 executable from a PSID file
+    Copyright (C) 2001-2023  Roland Hermans <rolandh@users.sourceforge.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef PAGEMAP_H
+#define PAGEMAP_H
+
+//////////////////////////////////////////////////////////////////////////////
+//                             I N C L U D E S
+//////////////////////////////////////////////////////////////////////////////
+
+#include <sidplay/sidint.h>
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                  F O R W A R D   D E C L A R A T O R S
+//////////////////////////////////////////////////////////////////////////////
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                     D A T A   D E C L A R A T O R S
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The used and free pages of the C64 memory, stored as a bitmap with one
+ * bit per page. Ranges of pages are reserved and tested with masks and free
+ * pages are searched a word at a time.
+ */
+class PageMap
+{
+public:
+    static const unsigned int NUM_PAGES = 256;
+
+    PageMap();
+
+    /**
+     * Mark all pages as used or all pages as free.
+     */
+    void setAll(bool used);
+
+    /**
+     * Mark count pages starting at page first as used. Pages beyond the
+     * end of the memory are ignored.
+     */
+    void reserve(unsigned int first, unsigned int count);
+
+    /**
+     * Mark count pages starting at page first as free. Pages beyond the end
+     * of the memory are ignored.
+     */
+    void release(unsigned int first, unsigned int count);
+
+    /**
+     * Check whether all count pages starting at page first are free.
+     */
+    bool isFree(unsigned int first, unsigned int count) const;
+
+    /**
+     * Find the first run of at least size free pages that is followed by a
+     * used page and return its first page. The search starts at page from,
+     * which should be a used page or the start of a run. A run that extends
+     * to the end of the memory is not considered. Returns 0 if there is no
+     * such run.
+     */
+    unsigned int findFreeRun(unsigned int size, unsigned int from = 0) const;
+
+    /**
+     * Get the first used page from page onwards, which is the end of the
+     * run of free pages at page. Returns NUM_PAGES if there is none.
+     */
+    unsigned int findUsedPage(unsigned int page) const;
+
+private:
+    typedef uint_least64_t word_t;
+
+    static const unsigned int WORD_BITS = 64;
+    static const unsigned int NUM_WORDS = NUM_PAGES / WORD_BITS;
+
+    static word_t rangeMask(unsigned int bit, unsigned int count);
+    static unsigned int countTrailingZeros(word_t bits);
+
+    void setRange(unsigned int first, unsigned int count, bool used);
+    unsigned int findPage(unsigned int page, bool used) const;
+
+    word_t m_used[NUM_WORDS];  // a set bit marks a used page
+};
+
+#endif // PAGEMAP_H
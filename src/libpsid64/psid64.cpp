@@ -28,23 +28,28 @@
 
 #include <psid64/psid64.h>
 
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+
 #include <algorithm>
 #include <cctype>
+#include <cstring>
+#include <ctime>
 #include <iomanip>
 #include <iostream>
 #include <ostream>
 #include <sstream>
-#include <vector>
 
+#include "mutexlock.h"
+#include "pagemap.h"
 #include "reloc65.h"
 #include "screen.h"
-#include "sidid.h"
 #include "theme.h"
-#include "stilview/stil.h"
 #include "exomizer/exomizer.h"
+#include "../sidutils/MD5/MD5.h"
 
 using std::cerr;
-using std::dec;
 using std::endl;
 using std::hex;
 using std::ofstream;
@@ -55,7 +60,6 @@ using std::setfill;
 using std::setw;
 using std::string;
 using std::uppercase;
-using std::vector;
 
 
 //////////////////////////////////////////////////////////////////////////////
@@ -76,18 +80,476 @@ struct block_t
     uint_least16_t load; /**< start address */
     uint_least16_t size; /**< size of the memory block in bytes */
     const uint_least8_t* data; /**< data to be stored */
-    string description; /**< a short description */
+    const char* description; /**< a short description */
+};
+
+/**
+ * A candidate memory layout for the memory layout planner. Pages are 0 when
+ * a block is not placed.
+ */
+struct layout_t
+{
+    uint_least8_t screen; /**< startpage of the screen */
+    uint_least8_t chars; /**< startpage of the character set */
+    uint_least8_t driver; /**< startpage of the driver */
+    uint_least8_t stil; /**< startpage of the STIL text */
+    uint_least8_t songlengths; /**< startpage of the song length data */
+    unsigned int headerSize; /**< load address, BASIC line and boot code */
+    unsigned int blockSize; /**< driver, music data and screen */
+    unsigned int stilSize; /**< size of the STIL text, 0 if none */
+    unsigned int songlengthsSize; /**< size of the song lengths, 0 if none */
+    unsigned int charsetSize; /**< size of the character set copy */
+};
+
+/**
+ * Cost of a memory layout. Unless blocks may be left out, the planner picks
+ * the layout with the lowest cost of those that leave out the fewest
+ * blocks. Of layouts with the same cost the first one found is used.
+ */
+typedef unsigned long (*layout_cost_t)(const layout_t& layout);
+
+/**
+ * Enumerates the layouts of the driver, STIL text and song lengths around a
+ * screen and character set and keeps the cheapest one.
+ */
+class LayoutPlanner
+{
+public:
+    LayoutPlanner(layout_cost_t cost, bool leaveOutBlocks,
+                  const layout_t& sizes, unsigned int driverPages,
+                  unsigned int stilPages, unsigned int songlengthsPages);
+
+    void addScreen(const PageMap& pages, uint_least8_t screen,
+                   uint_least8_t chars);
+
+    inline bool found() const
+    {
+        return m_found;
+    }
+
+    inline const layout_t& best() const
+    {
+        return m_best;
+    }
+
+private:
+    void addLayout(const layout_t& layout);
+
+    layout_cost_t m_cost;
+    bool m_leaveOutBlocks;
+    layout_t m_sizes;
+    unsigned int m_driverPages;
+    unsigned int m_stilPages;
+    unsigned int m_songlengthsPages;
+    bool m_found;
+    layout_t m_best;
+    unsigned int m_bestMissing;
+    unsigned long m_bestCost;
+};
+
+/**
+ * Labels that the driver and boot code objects leave undefined. Their
+ * values are kept in an array indexed by these enumerators. The labels
+ * before GLOBAL_COL_BORDER depend on the tune, the colors only on the
+ * theme.
+ */
+enum Global
+{
+    GLOBAL_SONG,
+    GLOBAL_PLAYER,
+    GLOBAL_STOPVEC,
+    GLOBAL_SCREEN,
+    GLOBAL_BARSPRPTR,
+    GLOBAL_DD00,
+    GLOBAL_D018,
+    GLOBAL_SCREEN_SONGNUM,
+    GLOBAL_SID2BASE,
+    GLOBAL_SID3BASE,
+    GLOBAL_STIL,
+    GLOBAL_SONGLENGTHS_MIN,
+    GLOBAL_SONGLENGTHS_SEC,
+    GLOBAL_SONGTPI_LO,
+    GLOBAL_SONGTPI_HI,
+    GLOBAL_COL_BORDER,
+    GLOBAL_COL_BACKGROUND,
+    GLOBAL_COL_RASTER_TIME,
+    GLOBAL_COL_TITLE,
+    GLOBAL_COL_LINE_0,
+    GLOBAL_COL_PARAMETER = GLOBAL_COL_LINE_0 + NUM_LINE_COLORS,
+    GLOBAL_COL_COLON,
+    GLOBAL_COL_VALUE,
+    GLOBAL_COL_LEGEND,
+    GLOBAL_COL_BAR_FG,
+    GLOBAL_COL_BAR_BG,
+    GLOBAL_COL_SCROLLER,
+    GLOBAL_COL_SCROLLER_0,
+    GLOBAL_COL_FOOTER_0 = GLOBAL_COL_SCROLLER_0 + NUM_SCROLLER_COLORS,
+    NUM_GLOBALS = GLOBAL_COL_FOOTER_0 + NUM_FOOTER_COLORS
+};
+
+/**
+ * Relocation tables of the driver and boot code objects.
+ */
+class RelocTables
+{
+public:
+    RelocTables();
+
+    Reloc65Table driver;
+    Reloc65Table extDriver;
+    Reloc65Table boot;
+    Reloc65Table extBoot;
+};
+
+/**
+ * Cache of relocated driver and boot code images, shared by all threads.
+ * An image is relocated to its address with the colors of a theme, the
+ * labels that depend on the tune are patched by the caller. Images are
+ * never removed, so a returned image stays valid.
+ *
+ * The images are kept in a fixed table indexed by relocation table, page
+ * and theme, with room for two addresses in a page: the boot code sits
+ * behind the BASIC line or not. The storage is allocated once, on the first
+ * miss, so that later conversions do not allocate memory, also when they
+ * relocate a new image. Only the pages of the images that are used are
+ * touched. An image is relocated outside the lock: its slot is claimed
+ * first and published when the image is complete.
+ */
+class RelocCache
+{
+public:
+    explicit RelocCache(const RelocTables& tables);
+    ~RelocCache();
+
+    /**
+     * Get the image of table relocated to addr, or NULL when the slots of
+     * its page are taken by other addresses.
+     */
+    const uint_least8_t* get(const Reloc65Table& table, int addr,
+                             Psid64::Theme theme, const int* globals);
+
+private:
+    RelocCache(const RelocCache&);
+    RelocCache& operator=(const RelocCache&);
+
+    static const int NUM_TABLES = 4;
+    static const int NUM_PAGES = 256;
+    static const int NUM_THEMES = Psid64::THEME_RAINBOW + 1;
+    static const int NUM_SLOTS = 2;
+
+    const Reloc65Table* m_tables[NUM_TABLES];
+    uint_least8_t* m_storage;  // NULL until the first miss
+    uint_least8_t* m_images[NUM_TABLES];
+
+    // address of the image in a slot, 0 when the slot is free and negative
+    // while the image is being relocated
+    int m_addrs[NUM_TABLES][NUM_PAGES][NUM_THEMES][NUM_SLOTS];
+    Mutex m_mutex;
+
+    void allocate();
 };
 
 static inline unsigned int min(unsigned int a, unsigned int b);
 static bool block_cmp(const block_t& a, const block_t& b);
-static void setThemeGlobals(globals_t& globals, Psid64::Theme theme);
+static const char* formatHexWord(char* str, uint_least16_t value);
+static const char* formatNumber(char* str, unsigned int value);
+static const char* sidModelName(int sidModel);
+static void setThemeGlobals(int* globals, Psid64::Theme theme);
+static void cacheKey(char* key, const uint_least8_t* data, size_t size,
+                     uint_least16_t loadAddr, uint_least16_t startAddr,
+                     int effort);
+static unsigned int layoutMissing(const layout_t& layout);
+static unsigned long layoutBlockSize(const layout_t& layout);
+static unsigned long layoutOutputSize(const layout_t& layout);
+static unsigned long layoutBytesMoved(const layout_t& layout);
+static unsigned long costComplete(const layout_t& layout);
+static unsigned long costSmall(const layout_t& layout);
+static unsigned long costFastBoot(const layout_t& layout);
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                            L O C A L   D A T A
+//////////////////////////////////////////////////////////////////////////////
+
+static const uint_least8_t psid_driver_obj[] = {
+#include "psiddrv.h"
+};
+static const uint_least8_t psid_extdriver_obj[] = {
+#include "psidextdrv.h"
+};
+static const uint_least8_t psid_boot_obj[] = {
+#include "psidboot.h"
+};
+static const uint_least8_t psid_extboot_obj[] = {
+#include "psidextboot.h"
+};
+
+// names of the labels, in the order of enum Global
+static const char* const globalNames[NUM_GLOBALS] = {
+    "song",
+    "player",
+    "stopvec",
+    "screen",
+    "barsprptr",
+    "dd00",
+    "d018",
+    "screen_songnum",
+    "sid2base",
+    "sid3base",
+    "stil",
+    "songlengths_min",
+    "songlengths_sec",
+    "songtpi_lo",
+    "songtpi_hi",
+    "COL_BORDER",
+    "COL_BACKGROUND",
+    "COL_RASTER_TIME",
+    "COL_TITLE",
+    "COL_LINE_0", "COL_LINE_1", "COL_LINE_2", "COL_LINE_3", "COL_LINE_4",
+    "COL_LINE_5", "COL_LINE_6", "COL_LINE_7", "COL_LINE_8", "COL_LINE_9",
+    "COL_LINE_10", "COL_LINE_11", "COL_LINE_12", "COL_LINE_13",
+    "COL_LINE_14",
+    "COL_PARAMETER",
+    "COL_COLON",
+    "COL_VALUE",
+    "COL_LEGEND",
+    "COL_BAR_FG",
+    "COL_BAR_BG",
+    "COL_SCROLLER",
+    "COL_SCROLLER_0", "COL_SCROLLER_1", "COL_SCROLLER_2", "COL_SCROLLER_3",
+    "COL_SCROLLER_4", "COL_SCROLLER_5", "COL_SCROLLER_6", "COL_SCROLLER_7",
+    "COL_FOOTER_0", "COL_FOOTER_1", "COL_FOOTER_2", "COL_FOOTER_3",
+    "COL_FOOTER_4", "COL_FOOTER_5", "COL_FOOTER_6", "COL_FOOTER_7",
+    "COL_FOOTER_8", "COL_FOOTER_9", "COL_FOOTER_10", "COL_FOOTER_11",
+    "COL_FOOTER_12", "COL_FOOTER_13", "COL_FOOTER_14", "COL_FOOTER_15"
+};
+
+// The objects are parsed once when the library is loaded, before any
+// thread can convert a file. The tables are read-only afterwards.
+static const RelocTables relocTables;
+
+static RelocCache relocCache(relocTables);
+
+// cost functions of the memory layout objectives, in the order of
+// Psid64::Layout (first fit does not use the planner)
+static const layout_cost_t layoutCosts[] = {
+    NULL,
+    costComplete,
+    costSmall,
+    costFastBoot
+};
 
 
 //////////////////////////////////////////////////////////////////////////////
 //                       L O C A L   F U N C T I O N S
 //////////////////////////////////////////////////////////////////////////////
 
+RelocTables::RelocTables() :
+    driver(),
+    extDriver(),
+    boot(),
+    extBoot()
+{
+    driver.compile(psid_driver_obj, sizeof(psid_driver_obj),
+                   globalNames, NUM_GLOBALS);
+    extDriver.compile(psid_extdriver_obj, sizeof(psid_extdriver_obj),
+                      globalNames, NUM_GLOBALS);
+    boot.compile(psid_boot_obj, sizeof(psid_boot_obj),
+                 globalNames, NUM_GLOBALS);
+    extBoot.compile(psid_extboot_obj, sizeof(psid_extboot_obj),
+                    globalNames, NUM_GLOBALS);
+}
+
+
+LayoutPlanner::LayoutPlanner(layout_cost_t cost, bool leaveOutBlocks,
+                             const layout_t& sizes, unsigned int driverPages,
+                             unsigned int stilPages,
+                             unsigned int songlengthsPages) :
+    m_cost(cost),
+    m_leaveOutBlocks(leaveOutBlocks),
+    m_sizes(sizes),
+    m_driverPages(driverPages),
+    m_stilPages(stilPages),
+    m_songlengthsPages(songlengthsPages),
+    m_found(false),
+    m_best(sizes),
+    m_bestMissing(0),
+    m_bestCost(0)
+{
+}
+
+
+void
+LayoutPlanner::addScreen(const PageMap& pages, uint_least8_t screen,
+                         uint_least8_t chars)
+{
+    layout_t layout = m_sizes;
+    layout.screen = screen;
+    layout.chars = chars;
+
+    // the driver at the start of every free run that is large enough
+    for (unsigned int driver = pages.findFreeRun(m_driverPages);
+         driver != 0;
+         driver = pages.findFreeRun(m_driverPages, pages.findUsedPage(driver)))
+    {
+        PageMap driverPages = pages;
+        driverPages.reserve(driver, m_driverPages);
+        layout.driver = driver;
+
+        // the STIL text at the start of every free run that is large
+        // enough, and left out
+        unsigned int stil = m_stilPages ? driverPages.findFreeRun(m_stilPages) : 0;
+        for (;;)
+        {
+            PageMap stilPages = driverPages;
+            if (stil)
+            {
+                stilPages.reserve(stil, m_stilPages);
+            }
+            layout.stil = stil;
+
+            // the song lengths in the first free run, and left out
+            layout.songlengths = m_songlengthsPages
+                ? stilPages.findFreeRun(m_songlengthsPages) : 0;
+            addLayout(layout);
+            if (layout.songlengths)
+            {
+                layout.songlengths = 0;
+                addLayout(layout);
+            }
+
+            if (!stil)
+            {
+                break;
+            }
+            stil = driverPages.findFreeRun(m_stilPages,
+                                           driverPages.findUsedPage(stil));
+        }
+    }
+}
+
+
+void
+LayoutPlanner::addLayout(const layout_t& layout)
+{
+    // the sizes are only compared between layouts that keep the same
+    // number of blocks, unless blocks may be left out
+    unsigned int missing = m_leaveOutBlocks ? 0 : layoutMissing(layout);
+    unsigned long cost = m_cost(layout);
+    if (!m_found || (missing < m_bestMissing)
+        || ((missing == m_bestMissing) && (cost < m_bestCost)))
+    {
+        m_found = true;
+        m_best = layout;
+        m_bestMissing = missing;
+        m_bestCost = cost;
+    }
+}
+
+
+RelocCache::RelocCache(const RelocTables& tables) :
+    m_storage(NULL),
+    m_mutex()
+{
+    m_tables[0] = &tables.driver;
+    m_tables[1] = &tables.extDriver;
+    m_tables[2] = &tables.boot;
+    m_tables[3] = &tables.extBoot;
+    for (int i = 0; i < NUM_TABLES; ++i)
+    {
+        m_images[i] = NULL;
+    }
+}
+
+
+RelocCache::~RelocCache()
+{
+    delete[] m_storage;
+}
+
+
+const uint_least8_t*
+RelocCache::get(const Reloc65Table& table, int addr, Psid64::Theme theme,
+                const int* globals)
+{
+    int i = 0;
+    while ((i < NUM_TABLES) && (m_tables[i] != &table))
+    {
+        ++i;
+    }
+    if ((i == NUM_TABLES) || (addr <= 0) || (addr >= 0x10000))
+    {
+        return NULL;
+    }
+
+    const int size = table.getSize();
+    const int page = addr >> 8;
+    int* addrs = m_addrs[i][page][theme];
+    uint_least8_t* image = NULL;
+    int claimed = 0;
+    {
+        MutexLock lock(m_mutex);
+        if (m_storage == NULL)
+        {
+            allocate();
+        }
+        uint_least8_t* images = m_images[i]
+            + ((page * NUM_THEMES) + theme) * NUM_SLOTS * size;
+        for (int slot = 0; slot < NUM_SLOTS; ++slot)
+        {
+            if (addrs[slot] == addr)
+            {
+                return images + (slot * size);
+            }
+            if (addrs[slot] == -addr)
+            {
+                // another thread is relocating the image
+                return NULL;
+            }
+            if (addrs[slot] == 0)
+            {
+                addrs[slot] = -addr;
+                image = images + (slot * size);
+                claimed = slot;
+                break;
+            }
+        }
+    }
+    if (image == NULL)
+    {
+        return NULL;
+    }
+
+    table.relocate(image, addr, globals);
+    MutexLock lock(m_mutex);
+    addrs[claimed] = addr;
+    return image;
+}
+
+
+void
+RelocCache::allocate()
+{
+    // mutex must be held by the caller; the images are left uninitialized,
+    // so that the pages of unused slots are never touched
+    size_t total = 0;
+    for (int i = 0; i < NUM_TABLES; ++i)
+    {
+        total += NUM_PAGES * NUM_THEMES * NUM_SLOTS * m_tables[i]->getSize();
+    }
+    m_storage = new uint_least8_t[total];
+    uint_least8_t* images = m_storage;
+    for (int i = 0; i < NUM_TABLES; ++i)
+    {
+        m_images[i] = images;
+        images += NUM_PAGES * NUM_THEMES * NUM_SLOTS * m_tables[i]->getSize();
+    }
+
+    // address 0 marks a free slot, no image is relocated to page 0
+    memset(m_addrs, 0, sizeof(m_addrs));
+}
+
+
 static inline unsigned int
 min(unsigned int a, unsigned int b)
 {
@@ -106,8 +568,60 @@ block_cmp(const block_t& a, const block_t& b)
 }
 
 
+static const char*
+formatHexWord(char* str, uint_least16_t value)
+{
+    // like Psid64::toHexWord(), but without allocating memory
+    static const char hexDigits[] = "0123456789ABCDEF";
+    for (int i = 3; i >= 0; --i)
+    {
+        str[i] = hexDigits[value & 0x0f];
+        value >>= 4;
+    }
+    str[4] = '\0';
+    return str;
+}
+
+
+static const char*
+formatNumber(char* str, unsigned int value)
+{
+    char digits[12];
+    int n = 0;
+    do
+    {
+        digits[n++] = (char) ('0' + (value % 10));
+        value /= 10;
+    } while (value > 0);
+    int i = 0;
+    while (n > 0)
+    {
+        str[i++] = digits[--n];
+    }
+    str[i] = '\0';
+    return str;
+}
+
+
+static const char*
+sidModelName(int sidModel)
+{
+    switch (sidModel)
+    {
+    case SIDTUNE_SIDMODEL_6581:
+        return "6581";
+    case SIDTUNE_SIDMODEL_8580:
+        return "8580";
+    case SIDTUNE_SIDMODEL_ANY:
+        return "6581/8580";
+    default:
+        return "SID";
+    }
+}
+
+
 static void
-setThemeGlobals(globals_t& globals, Psid64::Theme theme)
+setThemeGlobals(int* globals, Psid64::Theme theme)
 {
     DriverTheme *driverTheme;
     switch (theme)
@@ -148,43 +662,147 @@ setThemeGlobals(globals_t& globals, Psid64::Theme theme)
         break;
     }
 
-    globals["COL_BORDER"] = driverTheme->getBorderColor();
-    globals["COL_BACKGROUND"] = driverTheme->getBackgroundColor();
-    globals["COL_RASTER_TIME"] = driverTheme->getRasterTimeColor();
-    globals["COL_TITLE"] = driverTheme->getTitleColor();
+    globals[GLOBAL_COL_BORDER] = driverTheme->getBorderColor();
+    globals[GLOBAL_COL_BACKGROUND] = driverTheme->getBackgroundColor();
+    globals[GLOBAL_COL_RASTER_TIME] = driverTheme->getRasterTimeColor();
+    globals[GLOBAL_COL_TITLE] = driverTheme->getTitleColor();
     const int *lineColors = driverTheme->getLineColors();
     for (int i = 0; i < NUM_LINE_COLORS; ++i)
     {
-        ostringstream oss;
-        oss << "COL_LINE_" << i;
-        globals[oss.str()] = lineColors[i];
-    }
-    globals["COL_PARAMETER"] = driverTheme->getFieldNameColor();
-    globals["COL_COLON"] = driverTheme->getFieldColonColor();
-    globals["COL_VALUE"] = driverTheme->getFieldValueColor();
-    globals["COL_LEGEND"] = driverTheme->getLegendColor();
-    globals["COL_BAR_FG"] = driverTheme->getProgressBarFillColor();
-    globals["COL_BAR_BG"] = driverTheme->getProgressBarBackgroundColor();
-    globals["COL_SCROLLER"] = driverTheme->getScrollerColor();
+        globals[GLOBAL_COL_LINE_0 + i] = lineColors[i];
+    }
+    globals[GLOBAL_COL_PARAMETER] = driverTheme->getFieldNameColor();
+    globals[GLOBAL_COL_COLON] = driverTheme->getFieldColonColor();
+    globals[GLOBAL_COL_VALUE] = driverTheme->getFieldValueColor();
+    globals[GLOBAL_COL_LEGEND] = driverTheme->getLegendColor();
+    globals[GLOBAL_COL_BAR_FG] = driverTheme->getProgressBarFillColor();
+    globals[GLOBAL_COL_BAR_BG] = driverTheme->getProgressBarBackgroundColor();
+    globals[GLOBAL_COL_SCROLLER] = driverTheme->getScrollerColor();
     const int *scrollerColors = driverTheme->getScrollerColors();
     for (int i = 0; i < NUM_SCROLLER_COLORS; ++i)
     {
-        ostringstream oss;
-        oss << "COL_SCROLLER_" << i;
-        globals[oss.str()] = scrollerColors[i];
+        globals[GLOBAL_COL_SCROLLER_0 + i] = scrollerColors[i];
     }
     const int *footerColors = driverTheme->getFooterColors();
     for (int i = 0; i < NUM_FOOTER_COLORS; ++i)
     {
-        ostringstream oss;
-        oss << "COL_FOOTER_" << i;
-        globals[oss.str()] = footerColors[i];
+        globals[GLOBAL_COL_FOOTER_0 + i] = footerColors[i];
     }
 
     delete driverTheme;
 }
 
 
+static void
+cacheKey(char* key, const uint_least8_t* data, size_t size,
+         uint_least16_t loadAddr, uint_least16_t startAddr, int effort)
+{
+    // the compressed file depends on nothing but the data to compress, the
+    // addresses, the effort and the version of the compressor
+    uint_least8_t params[5];
+    params[0] = (uint_least8_t) (loadAddr & 0xff);
+    params[1] = (uint_least8_t) (loadAddr >> 8);
+    params[2] = (uint_least8_t) (startAddr & 0xff);
+    params[3] = (uint_least8_t) (startAddr >> 8);
+    params[4] = (uint_least8_t) effort;
+
+    MD5 md5;
+    md5.append(PACKAGE " " VERSION, sizeof(PACKAGE " " VERSION));
+    md5.append(params, sizeof(params));
+    md5.append(data, size);
+    md5.finish();
+
+    static const char hexDigits[] = "0123456789abcdef";
+    const md5_byte_t* digest = md5.getDigest();
+    for (unsigned int i = 0; i < Psid64Cache::KEY_LENGTH / 2; ++i)
+    {
+        key[2 * i] = hexDigits[digest[i] >> 4];
+        key[2 * i + 1] = hexDigits[digest[i] & 0x0f];
+    }
+    key[Psid64Cache::KEY_LENGTH] = '\0';
+}
+
+
+static unsigned int
+layoutMissing(const layout_t& layout)
+{
+    // number of blocks that are wanted but not placed
+    unsigned int missing = 0;
+    if (layout.stilSize && !layout.stil)
+    {
+        ++missing;
+    }
+    if (layout.songlengthsSize && !layout.songlengths)
+    {
+        ++missing;
+    }
+    return missing;
+}
+
+
+static unsigned long
+layoutBlockSize(const layout_t& layout)
+{
+    unsigned long size = layout.blockSize;
+    if (layout.stil)
+    {
+        size += layout.stilSize;
+    }
+    if (layout.songlengths)
+    {
+        size += layout.songlengthsSize;
+    }
+    return size;
+}
+
+
+static unsigned long
+layoutOutputSize(const layout_t& layout)
+{
+    return layout.headerSize + layoutBlockSize(layout);
+}
+
+
+static unsigned long
+layoutBytesMoved(const layout_t& layout)
+{
+    // psidboot moves all blocks in whole pages to the end of the memory,
+    // copies each block to its place and copies the character set from ROM
+    unsigned long size = layoutBlockSize(layout);
+    unsigned long moved = ((size + 0xff) & ~0xffUL) + size;
+    if (layout.chars)
+    {
+        moved += layout.charsetSize;
+    }
+    return moved;
+}
+
+
+static unsigned long
+costComplete(const layout_t& layout)
+{
+    // as many blocks as possible, even when blocks may be left out, in the
+    // order of the first fit search
+    return layoutMissing(layout);
+}
+
+
+static unsigned long
+costSmall(const layout_t& layout)
+{
+    // smallest file
+    return layoutOutputSize(layout);
+}
+
+
+static unsigned long
+costFastBoot(const layout_t& layout)
+{
+    // fewest bytes copied at boot time
+    return layoutBytesMoved(layout);
+}
+
+
 //////////////////////////////////////////////////////////////////////////////
 //                   P R I V A T E   M E M B E R   D A T A
 //////////////////////////////////////////////////////////////////////////////
@@ -192,9 +810,13 @@ setThemeGlobals(globals_t& globals, Psid64::Theme theme)
 const char* Psid64::txt_relocOverlapsImage = "PSID64: relocation information overlaps the load image";
 const char* Psid64::txt_notEnoughC64Memory = "PSID64: C64 memory has no space for driver code";
 const char* Psid64::txt_fileIoError = "PSID64: File I/O error";
+const char* Psid64::txt_bufferTooSmall = "PSID64: Buffer too small for the C64 executable";
 const char* Psid64::txt_noSidTuneLoaded = "PSID64: No SID tune loaded";
 const char* Psid64::txt_noSidTuneConverted = "PSID64: No SID tune converted";
-const char* Psid64::txt_sidIdConfigError = "PSID64: Cannot read SID ID configuration file";
+const char* Psid64::txt_sharedResources = "PSID64: Cannot modify shared resources";
+const char* Psid64::txt_outOfMemory = "PSID64: Out of memory";
+const char* Psid64::txt_compressOutOfMemory = "PSID64: Not enough memory to compress the file";
+const char* Psid64::txt_compressLoadAddress = "PSID64: Load address too low for the decompressor";
 
 
 //////////////////////////////////////////////////////////////////////////////
@@ -207,23 +829,74 @@ Psid64::Psid64() :
     m_noDriver(false),
     m_blankScreen(false),
     m_compress(false),
+    m_compressEffort(EFFORT_NORMAL),
+    m_layout(LAYOUT_FIRST_FIT),
+    m_leaveOutBlocks(false),
+    m_initialSong(0),
+    m_useGlobalComment(false),
+    m_verbose(false),
+    m_logStream(&cerr),
+    m_theme(THEME_DEFAULT),
+    m_cache(NULL),
+    m_status(false),
+    m_statusString(NULL),
+    m_fileName(),
+    m_hvscFileName(),
+    m_tune(0),
+    m_tuneInfo(),
+    m_ownResources(new Psid64Resources),
+    m_resources(m_ownResources),
+    m_screen(new Screen),
+    m_stilText(),
+    m_stilPath(),
+    m_stilEntries(),
+    m_songlengthsData(),
+    m_songlengthsSize(0),
+    m_driverPage(0),
+    m_screenPage(0),
+    m_charPage(0),
+    m_stilPage(0),
+    m_songlengthsPage(0),
+    m_playerId(),
+    m_sidIdWork(),
+    m_driverCode(),
+    m_globals(),
+    m_globalsTheme(THEME_DEFAULT),
+    m_programBuffer(NULL),
+    m_compressBuffer(NULL),
+    m_programData(NULL),
+    m_programSize(0),
+    m_bytesCopied(0),
+    m_stats(),
+    m_exomizer(NULL)
+{
+}
+
+Psid64::Psid64(const Psid64Resources& resources) :
+    m_noDriver(false),
+    m_blankScreen(false),
+    m_compress(false),
+    m_compressEffort(EFFORT_NORMAL),
+    m_layout(LAYOUT_FIRST_FIT),
+    m_leaveOutBlocks(false),
     m_initialSong(0),
     m_useGlobalComment(false),
     m_verbose(false),
-    m_hvscRoot(),
-    m_databaseFileName(),
-    m_sidIdConfigFileName(),
+    m_logStream(&cerr),
     m_theme(THEME_DEFAULT),
+    m_cache(NULL),
     m_status(false),
     m_statusString(NULL),
     m_fileName(),
+    m_hvscFileName(),
     m_tune(0),
     m_tuneInfo(),
-    m_database(),
-    m_stil(new STIL),
-    m_sidId(new SidId),
+    m_ownResources(NULL),
+    m_resources(&resources),
     m_screen(new Screen),
     m_stilText(),
+    m_stilPath(),
+    m_stilEntries(),
     m_songlengthsData(),
     m_songlengthsSize(0),
     m_driverPage(0),
@@ -232,8 +905,17 @@ Psid64::Psid64() :
     m_stilPage(0),
     m_songlengthsPage(0),
     m_playerId(),
+    m_sidIdWork(),
+    m_driverCode(),
+    m_globals(),
+    m_globalsTheme(THEME_DEFAULT),
+    m_programBuffer(NULL),
+    m_compressBuffer(NULL),
     m_programData(NULL),
-    m_programSize(0)
+    m_programSize(0),
+    m_bytesCopied(0),
+    m_stats(),
+    m_exomizer(NULL)
 {
 }
 
@@ -241,23 +923,31 @@ Psid64::Psid64() :
 
 Psid64::~Psid64()
 {
-    delete m_stil;
-    delete m_sidId;
+    delete m_ownResources;
     delete m_screen;
-    delete[] m_programData;
+    delete[] m_programBuffer;
+    delete[] m_compressBuffer;
+    exomizer_ctx_free(m_exomizer);
 }
 
 
 bool Psid64::setHvscRoot(const string &hvscRoot)
 {
-    m_hvscRoot = hvscRoot;
-    if (!m_hvscRoot.empty())
+    if (m_ownResources == NULL)
     {
-        if (!m_stil->setBaseDir(m_hvscRoot.c_str()))
-        {
-            m_statusString = m_stil->getErrorStr();
-            return false;
-        }
+        m_statusString = txt_sharedResources;
+        return false;
+    }
+    if (!m_ownResources->setHvscRoot(hvscRoot))
+    {
+        m_statusString = m_ownResources->getStatus();
+        return false;
+    }
+    m_ownResources->load();
+    if (m_ownResources->getStilError() != NULL)
+    {
+        m_statusString = m_ownResources->getStilError();
+        return false;
     }
 
     return true;
@@ -266,14 +956,21 @@ bool Psid64::setHvscRoot(const string &hvscRoot)
 
 bool Psid64::setDatabaseFileName(const string &databaseFileName)
 {
-    m_databaseFileName = databaseFileName;
-    if (!m_databaseFileName.empty())
+    if (m_ownResources == NULL)
     {
-        if (m_database.open(m_databaseFileName.c_str()) < 0)
-        {
-            m_statusString = m_database.error();
-            return false;
-        }
+        m_statusString = txt_sharedResources;
+        return false;
+    }
+    if (!m_ownResources->setDatabaseFileName(databaseFileName))
+    {
+        m_statusString = m_ownResources->getStatus();
+        return false;
+    }
+    m_ownResources->load();
+    if (m_ownResources->getDatabaseError() != NULL)
+    {
+        m_statusString = m_ownResources->getDatabaseError();
+        return false;
     }
 
     return true;
@@ -282,14 +979,21 @@ bool Psid64::setDatabaseFileName(const string &databaseFileName)
 
 bool Psid64::setSidIdConfigFileName(const string &sidIdConfigFileName)
 {
-    m_sidIdConfigFileName = sidIdConfigFileName;
-    if (!m_sidIdConfigFileName.empty())
+    if (m_ownResources == NULL)
     {
-        if (!m_sidId->readConfigFile(m_sidIdConfigFileName))
-        {
-            m_statusString = txt_sidIdConfigError;
-            return false;
-        }
+        m_statusString = txt_sharedResources;
+        return false;
+    }
+    if (!m_ownResources->setSidIdConfigFileName(sidIdConfigFileName))
+    {
+        m_statusString = m_ownResources->getStatus();
+        return false;
+    }
+    m_ownResources->load();
+    if (m_ownResources->getSidIdError() != NULL)
+    {
+        m_statusString = m_ownResources->getSidIdError();
+        return false;
     }
 
     return true;
@@ -299,7 +1003,12 @@ bool Psid64::setSidIdConfigFileName(const string &sidIdConfigFileName)
 bool
 Psid64::load(const char* fileName)
 {
-    if (!m_tune.load(fileName))
+    resetStats(false);
+    const uint_least64_t start = getMicroseconds();
+    m_hvscFileName.clear();
+    const bool loaded = m_tune.load(fileName);
+    recordPhase(PHASE_LOAD, start);
+    if (!loaded)
     {
         m_fileName.clear();
         m_statusString = m_tune.getInfo().statusString;
@@ -314,16 +1023,36 @@ Psid64::load(const char* fileName)
 }
 
 
+bool
+Psid64::load(const uint_least8_t* data, uint_least32_t dataLen,
+             const char* hvscFileName)
+{
+    resetStats(false);
+    const uint_least64_t start = getMicroseconds();
+    m_fileName.clear();
+    m_hvscFileName.clear();
+    const bool loaded = m_tune.read(data, dataLen);
+    recordPhase(PHASE_LOAD, start);
+    if (!loaded)
+    {
+        m_statusString = m_tune.getInfo().statusString;
+        return false;
+    }
+
+    m_tune.getInfo(m_tuneInfo);
+
+    if (hvscFileName != NULL)
+    {
+        m_hvscFileName = hvscFileName;
+    }
+
+    return true;
+}
+
+
 bool
 Psid64::convert()
 {
-    static const uint_least8_t psid_boot_obj[] = {
-#include "psidboot.h"
-    };
-    static const uint_least8_t psid_extboot_obj[] = {
-#include "psidextboot.h"
-    };
-    uint_least8_t* psid_mem;
     uint_least8_t* psid_driver;
     int driver_size;
     uint_least16_t size;
@@ -335,10 +1064,16 @@ Psid64::convert()
         return false;
     }
 
+    m_bytesCopied = 0;
+    resetStats(true);
+
     // handle special treatment of conversion without driver code
     if (m_noDriver)
     {
-        return convertNoDriver();
+        const uint_least64_t start = getMicroseconds();
+        const bool converted = convertNoDriver();
+        recordPhase(PHASE_BUILD, start);
+        return converted;
     }
 
     // handle special treatment of tunes programmed in BASIC
@@ -347,19 +1082,28 @@ Psid64::convert()
     }
 
     // retrieve STIL entry for this SID tune
-    if (!formatStilText())
+    uint_least64_t start = getMicroseconds();
+    const bool formatted = formatStilText();
+    recordPhase(PHASE_STIL, start);
+    m_stats.stilBytes = m_stilText.length();
+    if (!formatted)
     {
         return false;
     }
 
     // retrieve song length data for this SID tune
-    if (!getSongLengths())
+    start = getMicroseconds();
+    const bool haveSongLengths = getSongLengths();
+    recordPhase(PHASE_SONG_LENGTHS, start);
+    if (!haveSongLengths)
     {
         return false;
     }
 
     // find space for driver and screen (optional)
+    start = getMicroseconds();
     findFreeSpace();
+    recordPhase(PHASE_LAYOUT, start);
     if (m_driverPage == 0x00)
     {
         m_statusString = txt_notEnoughC64Memory;
@@ -375,34 +1119,37 @@ Psid64::convert()
     }
 
     // relocate and initialize the driver
-    initDriver(&psid_mem, &psid_driver, &driver_size);
+    start = getMicroseconds();
+    initDriver(&psid_driver, &driver_size);
+    recordPhase(PHASE_DRIVER, start);
 
-    // copy SID data
-    uint_least8_t c64buf[65536];
-    m_tune.placeSidTuneInC64mem(c64buf);
+    // the SID data is used where it is in the loaded file
+    const uint_least8_t* c64data = m_tune.getC64Data();
+    const unsigned int c64dataLen = getC64DataLen();
 
     // identify player routine
-    const uint_least8_t* p_start = c64buf + m_tuneInfo.loadAddr;
-    const uint_least8_t* p_end = p_start + m_tuneInfo.c64dataLen;
-    vector<uint_least8_t> buffer(p_start, p_end);
-    m_playerId = m_sidId->identify(buffer);
+    start = getMicroseconds();
+    m_playerId = m_resources->identifyPlayer(c64data, c64dataLen,
+                                             m_sidIdWork);
+    recordPhase(PHASE_PLAYER_ID, start);
+    start = getMicroseconds();
 
     // fill the blocks structure
-    vector<block_t> blocks;
-    blocks.reserve(MAX_BLOCKS);
+    block_t blocks[MAX_BLOCKS];
+    unsigned int numBlocks = 0;
     block_t driver_block;
     driver_block.load = m_driverPage << 8;
     driver_block.size = driver_size;
     driver_block.data = psid_driver;
     driver_block.description = "Driver code";
-    blocks.push_back(driver_block);
+    blocks[numBlocks++] = driver_block;
 
     block_t music_data_block;
     music_data_block.load = m_tuneInfo.loadAddr;
-    music_data_block.size = m_tuneInfo.c64dataLen;
-    music_data_block.data = &(c64buf[m_tuneInfo.loadAddr]);
+    music_data_block.size = c64dataLen;
+    music_data_block.data = c64data;
     music_data_block.description = "Music data";
-    blocks.push_back(music_data_block);
+    blocks[numBlocks++] = music_data_block;
 
     if (m_screenPage != 0x00)
     {
@@ -412,7 +1159,7 @@ Psid64::convert()
         screen_block.size = m_screen->getDataSize();
         screen_block.data = m_screen->getData();
         screen_block.description = "Screen";
-        blocks.push_back(screen_block);
+        blocks[numBlocks++] = screen_block;
     }
 
     if (m_stilPage != 0x00)
@@ -422,7 +1169,7 @@ Psid64::convert()
         stil_text_block.size = m_stilText.length();
         stil_text_block.data = reinterpret_cast<const uint_least8_t*>(m_stilText.c_str());
         stil_text_block.description = "STIL text";
-        blocks.push_back(stil_text_block);
+        blocks[numBlocks++] = stil_text_block;
     }
 
     if (m_songlengthsPage != 0x00)
@@ -432,35 +1179,35 @@ Psid64::convert()
         song_length_data_block.size = m_songlengthsSize;
         song_length_data_block.data = m_songlengthsData;
         song_length_data_block.description = "Song length data";
-        blocks.push_back(song_length_data_block);
+        blocks[numBlocks++] = song_length_data_block;
     }
 
-    std::sort(blocks.begin(), blocks.end(), block_cmp);
+    std::sort(blocks, blocks + numBlocks, block_cmp);
 
     // print memory map
     if (m_verbose)
     {
         uint_least16_t charset = m_charPage << 8;
 
-        cerr << "C64 memory map:" << endl;
-        for (vector<block_t>::const_iterator block_iter = blocks.begin();
-             block_iter != blocks.end();
+        *m_logStream << "C64 memory map:" << endl;
+        for (const block_t* block_iter = blocks;
+             block_iter != blocks + numBlocks;
              ++block_iter)
         {
             if ((charset != 0) && (block_iter->load > charset))
             {
-                cerr << "  $" << toHexWord(charset) << "-$"
+                *m_logStream << "  $" << toHexWord(charset) << "-$"
                      << toHexWord(charset + (256 * NUM_CHAR_PAGES))
                      << "  Character set" << endl;
                 charset = 0;
             }
-            cerr << "  $" << toHexWord(block_iter->load) << "-$"
+            *m_logStream << "  $" << toHexWord(block_iter->load) << "-$"
                  << toHexWord(block_iter->load + block_iter->size) << "  "
                  << block_iter->description << endl;
         }
         if (charset != 0)
         {
-            cerr << "  $" << toHexWord(charset) << "-$"
+            *m_logStream << "  $" << toHexWord(charset) << "-$"
                  << toHexWord(charset + (256 * NUM_CHAR_PAGES))
                  << "  Character set" << endl;
         }
@@ -468,8 +1215,8 @@ Psid64::convert()
 
     // calculate total size of the blocks
     size = 0;
-    for (vector<block_t>::const_iterator block_iter = blocks.begin();
-         block_iter != blocks.end();
+    for (const block_t* block_iter = blocks;
+         block_iter != blocks + numBlocks;
          ++block_iter)
     {
         size = size + block_iter->size;
@@ -498,65 +1245,38 @@ Psid64::convert()
         break;
     default:
         lineNumber = 1103;
-        break;
-    }
-
-    // select boot code object
-    const uint_least8_t* boot_obj;
-    int boot_size;
-    if (m_screenPage == 0x00)
-    {
-        boot_obj = psid_boot_obj;
-        boot_size = sizeof(psid_boot_obj);
-    }
-    else
-    {
-        boot_obj = psid_extboot_obj;
-        boot_size = sizeof(psid_extboot_obj);
+        break;
     }
 
-    // relocate boot code
-    uint_least8_t* boot_mem;
-    uint_least8_t* boot_reloc;
-    boot_mem = boot_reloc = new uint_least8_t[boot_size];
-    if (boot_mem == NULL)
-    {
-        return false;
-    }
-    memcpy(boot_reloc, boot_obj, boot_size);
+    // select boot code object
+    const Reloc65Table& boot_table = (m_screenPage == 0x00)
+                                     ? relocTables.boot : relocTables.extBoot;
+    const int boot_size = boot_table.getSize();
 
-    globals_t globals;
-    setThemeGlobals(globals, m_theme);
-    globals["song"] = (initialSong - 1) & 0xff;
+    int* globals = initGlobals();
+    globals[GLOBAL_SONG] = (initialSong - 1) & 0xff;
     uint_least16_t jmpAddr = m_driverPage << 8;
     // start address of driver
-    globals["player"] = jmpAddr;
+    globals[GLOBAL_PLAYER] = jmpAddr;
     // address of new stop vector for tunes that call $a7ae during init
-    globals["stopvec"] = jmpAddr+3;
+    globals[GLOBAL_STOPVEC] = jmpAddr+3;
     const uint_least16_t load_addr = 0x0801;
     int screen = m_screenPage << 8;
-    globals["screen"] = screen;
-    globals["barsprptr"] = ((screen + BAR_SPRITE_SCREEN_OFFSET) & 0x3fc0) >> 6;
-    globals["dd00"] = ((((m_screenPage & 0xc0) >> 6) ^ 3) | 0x04);
+    globals[GLOBAL_SCREEN] = screen;
+    globals[GLOBAL_BARSPRPTR] = ((screen + BAR_SPRITE_SCREEN_OFFSET) & 0x3fc0) >> 6;
+    globals[GLOBAL_DD00] = ((((m_screenPage & 0xc0) >> 6) ^ 3) | 0x04);
     uint_least8_t vsa;  // video screen address
     uint_least8_t cba;  // character memory base address
     vsa = (uint_least8_t) ((m_screenPage & 0x3c) << 2);
     cba = (uint_least8_t) (m_charPage ? (m_charPage >> 2) & 0x0e : 0x06);
-    globals["d018"] = vsa | cba;
+    globals[GLOBAL_D018] = vsa | cba;
 
     // the additional BASIC starter code is not needed when compressing file
     uint_least16_t basic_size = (m_compress ? 0 : 12);
     uint_least16_t boot_addr = load_addr + basic_size;
-    if (!reloc65 (reinterpret_cast<char **>(&boot_reloc), &boot_size, boot_addr, &globals))
-    {
-        cerr << PACKAGE << ": Relocation error." << endl;
-        return false;
-    }
 
     uint_least16_t file_size = basic_size + boot_size + size;
-    m_programSize = 2 + file_size;
-    delete[] m_programData;
-    m_programData = new uint_least8_t[m_programSize];
+    initProgramData(2 + file_size);
     uint_least8_t *dest = m_programData;
     *(dest++) = (uint_least8_t) (load_addr & 0xff);
     *(dest++) = (uint_least8_t) (load_addr >> 8);
@@ -581,10 +1301,18 @@ Psid64::convert()
         *(dest++) = (uint_least8_t) 0x00;
         *(dest++) = (uint_least8_t) 0x00;
     }
-    memcpy(dest, boot_reloc, boot_size);
-
-    // free memory of relocated boot code
-    delete[] boot_mem;
+    // copy the relocated boot code and fill in the labels of this tune
+    const uint_least8_t* boot_image =
+        relocCache.get(boot_table, boot_addr, m_theme, globals);
+    if (boot_image != NULL)
+    {
+        copyBytes(dest, boot_image, boot_size);
+    }
+    else
+    {
+        boot_table.relocate(dest, boot_addr, globals);
+    }
+    boot_table.relocateLabels(dest, globals, 0, GLOBAL_COL_BORDER);
 
     uint_least16_t addr = 5;  // parameter offset in psidboot.a65
     uint_least16_t eof = load_addr + file_size;
@@ -599,15 +1327,15 @@ Psid64::convert()
     dest[addr++] = (uint_least8_t) ((size + 0xff) >> 8);  // number of pages to copy
     dest[addr++] = (uint_least8_t) ((0x10000 - size) & 0xff);  // start of blocks after moving
     dest[addr++] = (uint_least8_t) ((0x10000 - size) >> 8);
-    dest[addr++] = (uint_least8_t) (blocks.size() - 1);  // number of blocks - 1
+    dest[addr++] = (uint_least8_t) (numBlocks - 1);  // number of blocks - 1
 
     // copy block data to psidboot.a65 parameters
-    for (vector<block_t>::const_iterator block_iter = blocks.begin();
-         block_iter != blocks.end();
+    for (const block_t* block_iter = blocks;
+         block_iter != blocks + numBlocks;
          ++block_iter)
     {
-        int block_index = block_iter - blocks.begin();
-        uint_least16_t offs = addr + blocks.size() - 1 - block_index;
+        int block_index = block_iter - blocks;
+        uint_least16_t offs = addr + numBlocks - 1 - block_index;
         dest[offs] = (uint_least8_t) (block_iter->load & 0xff);
         dest[offs + MAX_BLOCKS] = (uint_least8_t) (block_iter->load >> 8);
         dest[offs + 2 * MAX_BLOCKS] = (uint_least8_t) (block_iter->size & 0xff);
@@ -617,38 +1345,76 @@ Psid64::convert()
     dest += boot_size;
 
     // copy blocks to c64 program file
-    for (vector<block_t>::const_iterator block_iter = blocks.begin();
-         block_iter != blocks.end();
+    for (const block_t* block_iter = blocks;
+         block_iter != blocks + numBlocks;
          ++block_iter)
     {
-        memcpy(dest, block_iter->data, block_iter->size);
+        copyBytes(dest, block_iter->data, block_iter->size);
         dest += block_iter->size;
     }
-
-    // free memory of relocated driver
-    delete[] psid_mem;
+    recordPhase(PHASE_BUILD, start);
 
     if (m_compress)
     {
-        // Use Exomizer to compress the program data. The first two bytes
-        // of m_programData are skipped as these contain the load address.
-        uint_least8_t* compressedData = new uint_least8_t[0x10000];
-        m_programSize = exomizer(m_programData + 2, m_programSize - 2,
-                                 load_addr, boot_addr, compressedData);
+        if (!compress(load_addr, boot_addr))
+        {
+            return false;
+        }
         // set BASIC line number
-        compressedData[4] = (uint_least8_t) (lineNumber & 0xff);
-        compressedData[5] = (uint_least8_t) (lineNumber >> 8);
-        delete[] m_programData;
-        m_programData = compressedData;
+        m_programData[4] = (uint_least8_t) (lineNumber & 0xff);
+        m_programData[5] = (uint_least8_t) (lineNumber >> 8);
     }
 
     return true;
 }
 
 
+size_t
+Psid64::getCompressionMemory() const
+{
+    if (m_exomizer == NULL)
+    {
+        return 0;
+    }
+    return exomizer_ctx_memory(m_exomizer);
+}
+
+
+const char*
+Psid64::getPhaseName(Phase phase)
+{
+    static const char* const names[NUM_PHASES] = {
+        "load", "stil", "song-lengths", "layout", "driver", "player-id",
+        "build", "compress", "write"
+    };
+    return ((phase >= 0) && (phase < NUM_PHASES)) ? names[phase] : "";
+}
+
+
+unsigned long
+Psid64::getMicroseconds()
+{
+    // the wall clock may be set while a conversion runs, and the processor
+    // time of the process counts all threads
+#if defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint_least64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#elif defined(HAVE_GETTIMEOFDAY)
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint_least64_t) tv.tv_sec * 1000000 + tv.tv_usec;
+#else
+    return (uint_least64_t) time(NULL) * 1000000;
+#endif
+}
+
+
 bool
 Psid64::save(const char* fileName)
 {
+    const uint_least64_t start = getMicroseconds();
+
     // Open binary output file stream.
     openmode createAttr = std::ios::out;
 #if defined(HAVE_IOS_BIN)
@@ -658,13 +1424,17 @@ Psid64::save(const char* fileName)
 #endif
 
     ofstream outfile(fileName, createAttr);
-    return write(outfile);
+    const bool written = write(outfile);
+    outfile.close();
+    recordPhase(PHASE_WRITE, start);
+    return written;
 }
 
 
 bool
 Psid64::write(ostream& out)
 {
+    const uint_least64_t start = getMicroseconds();
     if (!m_programData)
     {
         m_statusString = txt_noSidTuneConverted;
@@ -672,6 +1442,7 @@ Psid64::write(ostream& out)
     }
 
     out.write((const char*) m_programData, m_programSize);
+    recordPhase(PHASE_WRITE, start);
     if (!out)
     {
         m_statusString = txt_fileIoError;
@@ -682,6 +1453,31 @@ Psid64::write(ostream& out)
 }
 
 
+bool
+Psid64::write(uint_least8_t* buffer, size_t bufferSize, size_t& programSize)
+{
+    programSize = 0;
+    if (!m_programData)
+    {
+        m_statusString = txt_noSidTuneConverted;
+        return false;
+    }
+
+    programSize = m_programSize;
+    if (bufferSize < m_programSize)
+    {
+        m_statusString = txt_bufferTooSmall;
+        return false;
+    }
+
+    const uint_least64_t start = getMicroseconds();
+    memcpy(buffer, m_programData, m_programSize);
+    recordPhase(PHASE_WRITE, start);
+
+    return true;
+}
+
+
 //////////////////////////////////////////////////////////////////////////////
 //            P R O T E C T E D   M E M B E R   F U N C T I O N S
 //////////////////////////////////////////////////////////////////////////////
@@ -698,31 +1494,94 @@ Psid64::roundDiv(int_least32_t dividend, int_least32_t divisor)
 }
 
 
+unsigned int
+Psid64::getC64DataLen() const
+{
+    // data beyond the end of the C64 memory is cut off
+    return min(m_tuneInfo.c64dataLen, 0x10000 - m_tuneInfo.loadAddr);
+}
+
+
+void
+Psid64::copyBytes(uint_least8_t* dest, const uint_least8_t* src, size_t size)
+{
+    memcpy(dest, src, size);
+    m_bytesCopied += size;
+}
+
+
+void
+Psid64::resetStats(bool keepLoad)
+{
+    const uint_least64_t loadStart = m_stats.phaseStart[PHASE_LOAD];
+    const unsigned long loadTime = m_stats.phaseTime[PHASE_LOAD];
+    m_stats = Stats();
+    if (keepLoad)
+    {
+        m_stats.phaseStart[PHASE_LOAD] = loadStart;
+        m_stats.phaseTime[PHASE_LOAD] = loadTime;
+    }
+}
+
+
+void
+Psid64::recordPhase(Phase phase, uint_least64_t start)
+{
+    m_stats.phaseStart[phase] = start;
+    m_stats.phaseTime[phase] = getMicroseconds() - start;
+}
+
+
+void
+Psid64::initProgramData(unsigned int size)
+{
+    // the buffer is allocated once and is large enough for any program
+    if (m_programBuffer == NULL)
+    {
+        m_programBuffer = new uint_least8_t[PROGRAM_BUFFER_SIZE];
+    }
+    m_programData = m_programBuffer;
+    m_programSize = size;
+}
+
+
+int*
+Psid64::initGlobals()
+{
+    // The theme colors are only looked up again when the theme has changed.
+    // The other globals are overwritten by each relocation.
+    if (m_globals.empty() || (m_globalsTheme != m_theme))
+    {
+        m_globals.assign(NUM_GLOBALS, 0);
+        setThemeGlobals(&m_globals[0], m_theme);
+        m_globalsTheme = m_theme;
+    }
+    return &m_globals[0];
+}
+
+
 bool
 Psid64::convertNoDriver()
 {
     const uint_least16_t load_addr = m_tuneInfo.loadAddr;
-    const uint_least16_t end = load_addr + m_tuneInfo.c64dataLen;
+    const unsigned int c64dataLen = getC64DataLen();
+    const uint_least16_t end = load_addr + c64dataLen;
 
     // allocate space for C64 program
-    m_programSize = 2 + m_tuneInfo.c64dataLen;
-    delete[] m_programData;
-    m_programData = new uint_least8_t[m_programSize];
+    initProgramData(2 + c64dataLen);
 
     // first the load address
     m_programData[0] = (uint_least8_t) (load_addr & 0xff);
     m_programData[1] = (uint_least8_t) (load_addr >> 8);
 
     // then copy the music data
-    uint_least8_t c64buf[65536];
-    m_tune.placeSidTuneInC64mem(c64buf);
-    memcpy(m_programData + 2, &(c64buf[load_addr]), m_tuneInfo.c64dataLen);
+    copyBytes(m_programData + 2, m_tune.getC64Data(), c64dataLen);
 
     // print memory map
     if (m_verbose)
     {
-        cerr << "C64 memory map:" << endl;
-        cerr << "  $" << toHexWord(load_addr) << "-$" << toHexWord(end)
+        *m_logStream << "C64 memory map:" << endl;
+        *m_logStream << "  $" << toHexWord(load_addr) << "-$" << toHexWord(end)
              << "  Music data" << endl;
     }
 
@@ -734,26 +1593,25 @@ bool
 Psid64::convertBASIC()
 {
     const uint_least16_t load_addr = m_tuneInfo.loadAddr;
-    const uint_least16_t end = load_addr + m_tuneInfo.c64dataLen;
+    const unsigned int c64dataLen = getC64DataLen();
+    const uint_least16_t end = load_addr + c64dataLen;
     uint_least16_t bootCodeSize = m_compress ? 27 : 0;
+    const uint_least64_t start = getMicroseconds();
 
     // allocate space for BASIC program and boot code (optional)
-    m_programSize = 2 + m_tuneInfo.c64dataLen + bootCodeSize;
-    delete[] m_programData;
-    m_programData = new uint_least8_t[m_programSize];
+    initProgramData(2 + c64dataLen + bootCodeSize);
 
     // first the load address
     m_programData[0] = (uint_least8_t) (load_addr & 0xff);
     m_programData[1] = (uint_least8_t) (load_addr >> 8);
 
     // then copy the BASIC program
-    uint_least8_t c64buf[65536];
-    m_tune.placeSidTuneInC64mem(c64buf);
-    memcpy(m_programData + 2, &(c64buf[load_addr]), m_tuneInfo.c64dataLen);
+    copyBytes(m_programData + 2, m_tune.getC64Data(), c64dataLen);
+    recordPhase(PHASE_BUILD, start);
 
     if (m_compress)
     {
-        uint_least16_t offs = 2 + m_tuneInfo.c64dataLen;
+        uint_least16_t offs = 2 + c64dataLen;
         // lda #0
         m_programData[offs++] = 0xa9;
         m_programData[offs++] = 0x00;
@@ -794,25 +1652,21 @@ Psid64::convertBASIC()
         m_programData[offs++] = 0xae;
         m_programData[offs++] = 0xa7;
 
-        // Use Exomizer to compress the program data. The first two bytes
-        // of m_programData are skipped as these contain the load address.
-        int start = end;
-        uint_least8_t* compressedData = new uint_least8_t[0x10000];
-        m_programSize = exomizer(m_programData + 2, m_programSize - 2,
-                                 load_addr, start, compressedData);
-        delete[] m_programData;
-        m_programData = compressedData;
+        if (!compress(load_addr, end))
+        {
+            return false;
+        }
     }
 
     // print memory map
     if (m_verbose)
     {
-        cerr << "C64 memory map:" << endl;
-        cerr << "  $" << toHexWord(load_addr) << "-$" << toHexWord(end)
+        *m_logStream << "C64 memory map:" << endl;
+        *m_logStream << "  $" << toHexWord(load_addr) << "-$" << toHexWord(end)
              << "  BASIC program" << endl;
         if (m_compress)
         {
-            cerr << "  $" << toHexWord(end) << "-$"
+            *m_logStream << "  $" << toHexWord(end) << "-$"
                  << toHexWord(end + bootCodeSize)
                  << "  Post decompression boot code" << endl;
         }
@@ -827,50 +1681,38 @@ Psid64::formatStilText()
 {
     m_stilText.clear();
 
-    if (m_hvscRoot.empty())
+    const string& hvscRoot = m_resources->getHvscRoot();
+    if (hvscRoot.empty())
     {
         return true;
     }
 
-    // strip hvsc path from the file name
-    string hvscFileName = m_fileName;
-    size_t index = hvscFileName.find(m_hvscRoot);
-    if (index != string::npos)
-    {
-        hvscFileName.erase(0, index + m_hvscRoot.length());
-    }
-
-    // convert backslashes to slashes (for DOS and Windows filenames)
-    replace(hvscFileName.begin(), hvscFileName.end(), '\\', '/');
-
-    string str;
-    if (!m_stil->hasCriticalError() && m_useGlobalComment)
+    // strip hvsc path from the file name, unless the path relative to the
+    // hvsc root was given when loading from memory
+    string& hvscFileName = m_stilPath;
+    hvscFileName = m_hvscFileName;
+    if (hvscFileName.empty())
     {
-        char* globalComment = m_stil->getGlobalComment(hvscFileName.c_str());
-        if (globalComment != NULL)
+        if (m_fileName.empty())
         {
-            str += globalComment;
+            return true;
         }
-    }
-    if (!m_stil->hasCriticalError())
-    {
-        char* stilEntry = m_stil->getEntry(hvscFileName.c_str(), 0);
-        if (stilEntry != NULL)
-        {
-            str += stilEntry;
-        }
-    }
-    if (!m_stil->hasCriticalError())
-    {
-        char* bugEntry = m_stil->getBug(hvscFileName.c_str(), 0);
-        if (bugEntry != NULL)
+        hvscFileName = m_fileName;
+        size_t index = hvscFileName.find(hvscRoot);
+        if (index != string::npos)
         {
-            str += bugEntry;
+            hvscFileName.erase(0, index + hvscRoot.length());
         }
     }
-    if (m_stil->hasCriticalError())
+
+    // convert backslashes to slashes (for DOS and Windows filenames)
+    replace(hvscFileName.begin(), hvscFileName.end(), '\\', '/');
+
+    string& str = m_stilEntries;
+    str.clear();
+    if (!m_resources->getStilText(hvscFileName, m_useGlobalComment, str,
+                                  m_statusString))
     {
-        m_statusString = m_stil->getErrorStr();
         return false;
     }
 
@@ -930,10 +1772,13 @@ Psid64::getSongLengths()
     /* calculate new style MD5 */
     m_tune.createNewMD5(md5);
 
+    // retrieve song length database information of all songs at once
+    int_least32_t lengths[SIDTUNE_MAX_SONGS];
+    m_resources->getSongLengths(md5, lengths, m_tuneInfo.songs);
+
     for (int i = 0; i < m_tuneInfo.songs; ++i)
     {
-        // retrieve song length database information
-        int_least32_t length = m_database.length(md5, i + 1);
+        int_least32_t length = lengths[i];
         if (length > 0)
         {
             // maximum representable length is 99:59
@@ -950,7 +1795,7 @@ Psid64::getSongLengths()
 #if 0
             if (m_verbose)
             {
-                cerr << "Length of song " << i + 1 << ": "
+                *m_logStream << "Length of song " << i + 1 << ": "
                      << setfill('0') << setw(2) << static_cast<int>(minutes) << ":"
                      << setfill('0') << setw(2) << static_cast<int>(sec) << endl;
             }
@@ -993,79 +1838,6 @@ Psid64::getSongLengths()
 }
 
 
-uint_least8_t
-Psid64::findSonglengthsSpace(const bool* pages, uint_least8_t scr,
-                             uint_least8_t chars, uint_least8_t driver,
-                             uint_least8_t stil, uint_least8_t stil_pages,
-                             uint_least8_t size) const
-{
-    uint_least8_t firstPage = 0;
-    for (unsigned int i = 0; i < MAX_PAGES; ++i)
-    {
-        if (pages[i] || (scr && (scr <= i) && (i < (scr + NUM_SCREEN_PAGES)))
-            || (chars && (chars <= i) && (i < (chars + NUM_CHAR_PAGES)))
-            || ((driver <= i) && (i < (driver + NUM_EXTDRV_PAGES)))
-            || (stil && (stil <= i) && (i < (stil + stil_pages))))
-        {
-            if ((i - firstPage) >= size)
-            {
-                return firstPage;
-            }
-            firstPage = i + 1;
-        }
-    }
-
-    return 0;
-}
-
-
-
-uint_least8_t
-Psid64::findStilSpace(const bool* pages, uint_least8_t scr,
-                      uint_least8_t chars, uint_least8_t driver,
-                      uint_least8_t size) const
-{
-    uint_least8_t firstPage = 0;
-    for (unsigned int i = 0; i < MAX_PAGES; ++i)
-    {
-        if (pages[i] || (scr && (scr <= i) && (i < (scr + NUM_SCREEN_PAGES)))
-            || (chars && (chars <= i) && (i < (chars + NUM_CHAR_PAGES)))
-            || ((driver <= i) && (i < (driver + NUM_EXTDRV_PAGES))))
-        {
-            if ((i - firstPage) >= size)
-            {
-                return firstPage;
-            }
-            firstPage = i + 1;
-        }
-    }
-
-    return 0;
-}
-
-
-uint_least8_t
-Psid64::findDriverSpace(const bool* pages, uint_least8_t scr,
-                        uint_least8_t chars, uint_least8_t size) const
-{
-    uint_least8_t firstPage = 0;
-    for (unsigned int i = 0; i < MAX_PAGES; ++i)
-    {
-        if (pages[i] || (scr && (scr <= i) && (i < (scr + NUM_SCREEN_PAGES)))
-            || (chars && (chars <= i) && (i < (chars + NUM_CHAR_PAGES))))
-        {
-            if ((i - firstPage) >= size)
-            {
-                return firstPage;
-            }
-            firstPage = i + 1;
-        }
-    }
-
-    return 0;
-}
-
-
 void
 Psid64::findFreeSpace()
 /*--------------------------------------------------------------------------*
@@ -1085,14 +1857,10 @@ Psid64::findFreeSpace()
                                   memory ranges $4000-$8000 and $c000-$d000.
  *--------------------------------------------------------------------------*/
 {
-    bool pages[MAX_PAGES];
+    PageMap pages;
     unsigned int startp = m_tuneInfo.relocStartPage;
     unsigned int maxp = m_tuneInfo.relocPages;
     unsigned int i;
-    unsigned int j;
-    unsigned int k;
-    uint_least8_t scr;
-    uint_least8_t chars;
     uint_least8_t driver;
 
     // calculate size of the STIL text in pages
@@ -1120,15 +1888,11 @@ Psid64::findFreeSpace()
         used[7] = (m_tuneInfo.loadAddr + m_tuneInfo.c64dataLen - 1) >> 8;
 
         // Mark used pages in table.
-        for (i = 0; i < MAX_PAGES; ++i)
-        {
-            pages[i] = false;
-        }
         for (i = 0; i < sizeof(used) / sizeof(*used); i += 2)
         {
-            for (j = used[i]; j <= used[i + 1]; ++j)
+            if (used[i] <= used[i + 1])
             {
-                pages[j] = true;
+                pages.reserve(used[i], used[i + 1] - used[i] + 1);
             }
         }
     }
@@ -1149,10 +1913,8 @@ Psid64::findFreeSpace()
             return;
         }
 
-        for (i = 0; i < MAX_PAGES; ++i)
-        {
-            pages[i] = ((startp <= i) && (i < endp)) ? false : true;
-        }
+        pages.setAll(true);
+        pages.release(startp, endp - startp);
     }
     else
     {
@@ -1160,8 +1922,49 @@ Psid64::findFreeSpace()
         return;
     }
 
-    driver = 0;
-    for (i = 0; i < 4; ++i)
+    if ((m_layout != LAYOUT_FIRST_FIT)
+        && planLayout(pages, stilSize, songlengthsSize))
+    {
+        return;
+    }
+
+    // the first screen position that leaves room for the driver
+    uint_least8_t screens[MAX_SCREEN_PLACES];
+    uint_least8_t chars[MAX_SCREEN_PLACES];
+    const unsigned int numPlaces = findScreenPlaces(pages, screens, chars);
+    for (i = 0; i < numPlaces; ++i)
+    {
+        PageMap screenPages = pages;
+        screenPages.reserve(screens[i], NUM_SCREEN_PAGES);
+        if (chars[i])
+        {
+            screenPages.reserve(chars[i], NUM_CHAR_PAGES);
+        }
+        driver = screenPages.findFreeRun(NUM_EXTDRV_PAGES);
+        if (driver)
+        {
+            m_screenPage = screens[i];
+            m_charPage = chars[i];
+            placeDriver(screenPages, driver, stilSize, songlengthsSize);
+            return;
+        }
+    }
+
+    driver = pages.findFreeRun(NUM_MINDRV_PAGES);
+    m_driverPage = driver;
+}
+
+
+unsigned int
+Psid64::findScreenPlaces(const PageMap& pages, uint_least8_t* screens,
+                         uint_least8_t* chars)
+{
+    // The places of the screen and of the copy of the character set, in the
+    // order in which they are tried, as used by both the first fit search
+    // and the memory layout planner. The character set is 0 when the
+    // screen uses the character rom.
+    unsigned int n = 0;
+    for (unsigned int i = 0; i < 4; ++i)
     {
         // Calculate the VIC bank offset. Screens located inside banks 1 and 3
         // require a copy the character rom in ram. The code below uses a
@@ -1169,84 +1972,119 @@ Psid64::findFreeSpace()
         // before 1 and 3.
         uint_least8_t bank = (((i & 1) ^ (i >> 1)) ? i ^ 3 : i) << 6;
 
-        for (j = 0; j < 0x40; j += 4)
+        for (unsigned int j = 0; j < 0x40; j += 4)
         {
             // screen may not reside within the char rom mirror areas
             if (!(bank & 0x40) && (0x10 <= j) && (j < 0x20))
                 continue;
 
             // check if screen area is available
-            scr = bank + j;
-            if (pages[scr] || pages[scr + 1] || pages[scr + 2]
-                || pages[scr + 3])
+            uint_least8_t scr = bank + j;
+            if (!pages.isFree(scr, NUM_SCREEN_PAGES))
                 continue;
 
             if (bank & 0x40)
             {
                 // The char rom needs to be copied to RAM so let's try to find
                 // a suitable location.
-                for (k = 0; k < 0x40; k += 8)
+                for (unsigned int k = 0; k < 0x40; k += 8)
                 {
                     // char rom area may not overlap with screen area
                     if (k == (j & 0x38))
                         continue;
 
                     // check if character rom area is available
-                    chars = bank + k;
-                    if (pages[chars] || pages[chars + 1]
-                        || pages[chars + 2] || pages[chars + 3])
+                    if (!pages.isFree(bank + k, NUM_CHAR_PAGES))
                         continue;
 
-                    driver =
-                        findDriverSpace(pages, scr, chars, NUM_EXTDRV_PAGES);
-                    if (driver)
-                    {
-                        m_driverPage = driver;
-                        m_screenPage = scr;
-                        m_charPage = chars;
-                        if (stilSize)
-                        {
-                            m_stilPage = findStilSpace(pages, scr, chars,
-                                                       driver, stilSize);
-                        }
-                        if (songlengthsSize)
-                        {
-                            m_songlengthsPage = findSonglengthsSpace(
-                                pages, scr, chars, driver, m_stilPage,
-                                stilSize, songlengthsSize);
-                        }
-                        return;
-                    }
+                    screens[n] = scr;
+                    chars[n] = bank + k;
+                    ++n;
                 }
             }
             else
             {
-                driver = findDriverSpace(pages, scr, 0, NUM_EXTDRV_PAGES);
-                if (driver)
-                {
-                    m_driverPage = driver;
-                    m_screenPage = scr;
-                    if (stilSize)
-                    {
-                        m_stilPage = findStilSpace(pages, scr, 0, driver,
-                                                   stilSize);
-                    }
-                    if (songlengthsSize)
-                    {
-                        m_songlengthsPage = findSonglengthsSpace(
-                            pages, scr, 0, driver, m_stilPage, stilSize,
-                            songlengthsSize);
-                    }
-                    return;
-                }
+                screens[n] = scr;
+                chars[n] = 0;
+                ++n;
             }
         }
     }
+    return n;
+}
+
+
+bool
+Psid64::planLayout(const PageMap& pages, uint_least8_t stilSize,
+                   uint_least8_t songlengthsSize)
+{
+    // the sizes of the parts of the C64 executable
+    layout_t sizes;
+    sizes.screen = 0;
+    sizes.chars = 0;
+    sizes.driver = 0;
+    sizes.stil = 0;
+    sizes.songlengths = 0;
+    sizes.headerSize = 2 + (m_compress ? 0 : 12)
+                       + relocTables.extBoot.getSize();
+    sizes.blockSize = relocTables.extDriver.getSize() + getC64DataLen()
+                      + m_screen->getDataSize();
+    sizes.stilSize = m_stilText.length();
+    sizes.songlengthsSize = m_songlengthsSize;
+    sizes.charsetSize = NUM_CHAR_PAGES << 8;
+
+    LayoutPlanner planner(layoutCosts[m_layout], m_leaveOutBlocks, sizes,
+                          NUM_EXTDRV_PAGES, stilSize, songlengthsSize);
+
+    // the same screen and character set positions as the first fit search
+    uint_least8_t screens[MAX_SCREEN_PLACES];
+    uint_least8_t chars[MAX_SCREEN_PLACES];
+    const unsigned int numPlaces = findScreenPlaces(pages, screens, chars);
+    for (unsigned int i = 0; i < numPlaces; ++i)
+    {
+        PageMap screenPages = pages;
+        screenPages.reserve(screens[i], NUM_SCREEN_PAGES);
+        if (chars[i])
+        {
+            screenPages.reserve(chars[i], NUM_CHAR_PAGES);
+        }
+        planner.addScreen(screenPages, screens[i], chars[i]);
+    }
+
+    if (!planner.found())
+    {
+        return false;
+    }
+
+    const layout_t& layout = planner.best();
+    m_screenPage = layout.screen;
+    m_charPage = layout.chars;
+    m_driverPage = layout.driver;
+    m_stilPage = layout.stil;
+    m_songlengthsPage = layout.songlengths;
+    return true;
+}
 
-    if (!driver)
+
+void
+Psid64::placeDriver(PageMap& pages, uint_least8_t driver,
+                    uint_least8_t stilSize, uint_least8_t songlengthsSize)
+{
+    // the STIL text and the song lengths are placed in the pages that are
+    // left by the screen, the character set and the driver
+    m_driverPage = driver;
+    pages.reserve(driver, NUM_EXTDRV_PAGES);
+    if (stilSize)
+    {
+        m_stilPage = pages.findFreeRun(stilSize);
+        if (m_stilPage)
+        {
+            pages.reserve(m_stilPage, stilSize);
+        }
+    }
+    if (songlengthsSize)
     {
-        driver = findDriverSpace(pages, 0, 0, NUM_MINDRV_PAGES);
-        m_driverPage = driver;
+        m_songlengthsPage = pages.findFreeRun(songlengthsSize);
     }
 }
 
@@ -1275,50 +2113,26 @@ uint8_t Psid64::iomap(uint_least16_t addr)
 
 
 void
-Psid64::initDriver(uint_least8_t** mem, uint_least8_t** ptr, int* n)
+Psid64::initDriver(uint_least8_t** ptr, int* n)
 {
-    static const uint_least8_t psid_driver[] = {
-#include "psiddrv.h"
-    };
-    static const uint_least8_t psid_extdriver[] = {
-#include "psidextdrv.h"
-    };
-    const uint_least8_t* driver;
-    uint_least8_t* psid_mem;
     uint_least8_t* psid_reloc;
     int psid_size;
     uint_least16_t reloc_addr;
     uint_least16_t addr;
 
-    *ptr = NULL;
-    *n = 0;
-
     // select driver
-    if (m_screenPage == 0x00)
-    {
-        psid_size = sizeof(psid_driver);
-        driver = psid_driver;
-    }
-    else
-    {
-        psid_size = sizeof(psid_extdriver);
-        driver = psid_extdriver;
-    }
-
-    // Relocation of C64 PSID driver code.
-    psid_mem = psid_reloc = new uint_least8_t[psid_size];
-    if (psid_mem == NULL)
-    {
-        return;
-    }
-    memcpy(psid_reloc, driver, psid_size);
+    const Reloc65Table& driver_table = (m_screenPage == 0x00)
+                                       ? relocTables.driver
+                                       : relocTables.extDriver;
+    psid_size = driver_table.getSize();
+    m_driverCode.resize(psid_size);
+    psid_reloc = &m_driverCode[0];
     reloc_addr = m_driverPage << 8;
 
     // undefined references in the driver code need to be added to globals
-    globals_t globals;
-    setThemeGlobals(globals, m_theme);
+    int* globals = initGlobals();
     int screen = m_screenPage << 8;
-    globals["screen"] = screen;
+    globals[GLOBAL_SCREEN] = screen;
     int screen_songnum = 0;
     if (m_tuneInfo.songs > 1)
     {
@@ -1326,7 +2140,7 @@ Psid64::initDriver(uint_least8_t** mem, uint_least8_t** ptr, int* n)
         if (m_tuneInfo.songs >= 100) ++screen_songnum;
         if (m_tuneInfo.songs >= 10) ++screen_songnum;
     }
-    globals["screen_songnum"] = screen_songnum;
+    globals[GLOBAL_SCREEN_SONGNUM] = screen_songnum;
     int sid2base;
     if (((m_tuneInfo.secondSIDAddress & 1) == 0)
         && (((0x42 <= m_tuneInfo.secondSIDAddress) && (m_tuneInfo.secondSIDAddress <= 0x7e))
@@ -1338,7 +2152,7 @@ Psid64::initDriver(uint_least8_t** mem, uint_least8_t** ptr, int* n)
     {
         sid2base = 0xd400;
     }
-    globals["sid2base"] = sid2base;
+    globals[GLOBAL_SID2BASE] = sid2base;
     int sid3base;
     if (((m_tuneInfo.thirdSIDAddress & 1) == 0)
         && (((0x42 <= m_tuneInfo.thirdSIDAddress) && (m_tuneInfo.thirdSIDAddress <= 0x7e))
@@ -1351,28 +2165,37 @@ Psid64::initDriver(uint_least8_t** mem, uint_least8_t** ptr, int* n)
     {
         sid3base = 0xd400;
     }
-    globals["sid3base"] = sid3base;
-    globals["stil"] = m_stilPage * 0x100;
+    globals[GLOBAL_SID3BASE] = sid3base;
+    globals[GLOBAL_STIL] = m_stilPage * 0x100;
     if (m_songlengthsPage != 0x00)
     {
-        globals["songlengths_min"] = m_songlengthsPage * 0x100;
-        globals["songlengths_sec"] = (m_songlengthsPage * 0x100) + m_tuneInfo.songs;
-        globals["songtpi_lo"] = (m_songlengthsPage * 0x100) + (2 * m_tuneInfo.songs);
-        globals["songtpi_hi"] = (m_songlengthsPage * 0x100) + (3 * m_tuneInfo.songs);
+        globals[GLOBAL_SONGLENGTHS_MIN] = m_songlengthsPage * 0x100;
+        globals[GLOBAL_SONGLENGTHS_SEC] = (m_songlengthsPage * 0x100) + m_tuneInfo.songs;
+        globals[GLOBAL_SONGTPI_LO] = (m_songlengthsPage * 0x100) + (2 * m_tuneInfo.songs);
+        globals[GLOBAL_SONGTPI_HI] = (m_songlengthsPage * 0x100) + (3 * m_tuneInfo.songs);
     }
     else
     {
-        globals["songlengths_min"] = 0x0000;
-        globals["songlengths_sec"] = 0x0000;
-        globals["songtpi_lo"] = 0x0000;
-        globals["songtpi_hi"] = 0x0000;
+        globals[GLOBAL_SONGLENGTHS_MIN] = 0x0000;
+        globals[GLOBAL_SONGLENGTHS_SEC] = 0x0000;
+        globals[GLOBAL_SONGTPI_LO] = 0x0000;
+        globals[GLOBAL_SONGTPI_HI] = 0x0000;
     }
 
-    if (!reloc65 (reinterpret_cast<char **>(&psid_reloc), &psid_size, reloc_addr, &globals))
+    // Relocation of C64 PSID driver code, the image for the driver page and
+    // theme is shared by all conversions and only the labels of this tune
+    // are patched.
+    const uint_least8_t* driver_image =
+        relocCache.get(driver_table, reloc_addr, m_theme, globals);
+    if (driver_image != NULL)
     {
-        cerr << PACKAGE << ": Relocation error." << endl;
-        return;
+        copyBytes(psid_reloc, driver_image, psid_size);
+    }
+    else
+    {
+        driver_table.relocate(psid_reloc, reloc_addr, globals);
     }
+    driver_table.relocateLabels(psid_reloc, globals, 0, GLOBAL_COL_BORDER);
 
     // Skip JMP table
     addr = 6;
@@ -1405,14 +2228,13 @@ Psid64::initDriver(uint_least8_t** mem, uint_least8_t** ptr, int* n)
     psid_reloc[addr++] = iomap(m_tuneInfo.initAddr);
     psid_reloc[addr++] = iomap(m_tuneInfo.playAddr);
 
-    *mem = psid_mem;
     *ptr = psid_reloc;
     *n = psid_size;
 }
 
 
 void
-Psid64::addFlag(bool &hasFlags, const string &flagName)
+Psid64::addFlag(bool &hasFlags, const char* flagName)
 {
     if (hasFlags)
     {
@@ -1437,17 +2259,6 @@ Psid64::toHexWord(uint16_t value) const
 }
 
 
-string
-Psid64::toNumStr(int value) const
-{
-    ostringstream oss;
-
-    oss << dec << value;
-
-    return string(oss.str());
-}
-
-
 void
 Psid64::drawScreen()
 {
@@ -1472,28 +2283,29 @@ Psid64::drawScreen()
 
     // information lines
     m_screen->moveTo(0, 4);
+    char str[32];
     m_screen->write("Name   : ");
-    m_screen->write(string(m_tuneInfo.infoString[0]).substr(0, 31));
+    m_screen->write(m_tuneInfo.infoString[0], 31);
 
     m_screen->write("\nAuthor : ");
-    m_screen->write(string(m_tuneInfo.infoString[1]).substr(0, 31));
+    m_screen->write(m_tuneInfo.infoString[1], 31);
 
     m_screen->write("\nRelease: ");
-    m_screen->write(string(m_tuneInfo.infoString[2]).substr(0, 31));
+    m_screen->write(m_tuneInfo.infoString[2], 31);
 
     m_screen->write("\nLoad   : $");
-    m_screen->write(toHexWord(m_tuneInfo.loadAddr));
+    m_screen->write(formatHexWord(str, m_tuneInfo.loadAddr));
     m_screen->write("-$");
-    m_screen->write(toHexWord(m_tuneInfo.loadAddr + m_tuneInfo.c64dataLen));
+    m_screen->write(formatHexWord(str, m_tuneInfo.loadAddr + m_tuneInfo.c64dataLen));
 
     m_screen->write("\nInit   : $");
-    m_screen->write(toHexWord(m_tuneInfo.initAddr));
+    m_screen->write(formatHexWord(str, m_tuneInfo.initAddr));
 
     m_screen->write("\nPlay   : ");
     if (m_tuneInfo.playAddr)
     {
         m_screen->write("$");
-        m_screen->write(toHexWord(m_tuneInfo.playAddr));
+        m_screen->write(formatHexWord(str, m_tuneInfo.playAddr));
     }
     else
     {
@@ -1501,7 +2313,7 @@ Psid64::drawScreen()
     }
 
     m_screen->write("\nSongs  : ");
-    m_screen->write(toNumStr(m_tuneInfo.songs));
+    m_screen->write(formatNumber(str, m_tuneInfo.songs));
     if (m_tuneInfo.songs > 1)
     {
         m_screen->write(" (now playing");
@@ -1566,43 +2378,19 @@ Psid64::drawScreen()
     }
     if (sid2base != 0)
     {
-        ostringstream oss;
-        oss << ((sid3base == 0) ? " at $" : "@") << toHexWord(sid2base);
-        switch (m_tuneInfo.sid2Model)
-        {
-        case SIDTUNE_SIDMODEL_6581:
-            addFlag(hasFlags, "6581" + oss.str());
-            break;
-        case SIDTUNE_SIDMODEL_8580:
-            addFlag(hasFlags, "8580" + oss.str());
-            break;
-        case SIDTUNE_SIDMODEL_ANY:
-            addFlag(hasFlags, "6581/8580" + oss.str());
-            break;
-        default:
-            addFlag(hasFlags, "SID" + oss.str());
-            break;
-        }
+        char hexWord[5];
+        strcpy(str, sidModelName(m_tuneInfo.sid2Model));
+        strcat(str, (sid3base == 0) ? " at $" : "@");
+        strcat(str, formatHexWord(hexWord, sid2base));
+        addFlag(hasFlags, str);
     }
     if (sid3base != 0)
     {
-        ostringstream oss;
-        oss << "@" << toHexWord(sid3base);
-        switch (m_tuneInfo.sid3Model)
-        {
-        case SIDTUNE_SIDMODEL_6581:
-            addFlag(hasFlags, "6581" + oss.str());
-            break;
-        case SIDTUNE_SIDMODEL_8580:
-            addFlag(hasFlags, "8580" + oss.str());
-            break;
-        case SIDTUNE_SIDMODEL_ANY:
-            addFlag(hasFlags, "6581/8580" + oss.str());
-            break;
-        default:
-            addFlag(hasFlags, "SID" + oss.str());
-            break;
-        }
+        char hexWord[5];
+        strcpy(str, sidModelName(m_tuneInfo.sid3Model));
+        strcat(str, "@");
+        strcat(str, formatHexWord(hexWord, sid3base));
+        addFlag(hasFlags, str);
     }
     if (!hasFlags)
     {
@@ -1610,16 +2398,18 @@ Psid64::drawScreen()
     }
 
     m_screen->write("\nPlayer : ");
-    string playerName = m_playerId;
-    if (playerName.empty())
+    if (m_playerId.empty())
     {
-        playerName = "<?>";
+        m_screen->write("<?>");
     }
     else
     {
-        std::replace(playerName.begin(), playerName.end(), '_', ' ');
+        for (string::const_iterator iter = m_playerId.begin();
+             iter != m_playerId.end(); ++iter)
+        {
+            m_screen->putchar((*iter == '_') ? ' ' : *iter);
+        }
     }
-    m_screen->write(playerName);
 
     m_screen->write("\nClock  :   :");
     if (m_songlengthsPage != 0)
@@ -1685,3 +2475,89 @@ Psid64::drawScreen()
         m_screen->poke(BAR_SPRITE_SCREEN_OFFSET + i, 0x00);
     }
 }
+
+
+bool
+Psid64::compress(uint_least16_t loadAddr, uint_least16_t startAddr)
+{
+    const uint_least64_t start = getMicroseconds();
+    int effort;
+    switch (m_compressEffort)
+    {
+    case EFFORT_FAST:
+        effort = EXOMIZER_EFFORT_FAST;
+        break;
+    case EFFORT_MAX:
+        effort = EXOMIZER_EFFORT_MAX;
+        break;
+    default:
+        effort = EXOMIZER_EFFORT_NORMAL;
+        break;
+    }
+
+    // Use Exomizer to compress the program data. The first two bytes
+    // of m_programData are skipped as these contain the load address.
+    if (m_compressBuffer == NULL)
+    {
+        m_compressBuffer = new uint_least8_t[COMPRESS_BUFFER_SIZE];
+    }
+
+    // reuse the result of an earlier compression of the same data
+    char key[Psid64Cache::KEY_LENGTH + 1];
+    if (m_cache != NULL)
+    {
+        cacheKey(key, m_programData + 2, m_programSize - 2, loadAddr,
+                 startAddr, effort);
+        size_t cachedSize;
+        if (m_cache->lookup(key, m_compressBuffer, COMPRESS_BUFFER_SIZE,
+                            cachedSize))
+        {
+            m_programData = m_compressBuffer;
+            m_programSize = cachedSize;
+            m_stats.compressCached = true;
+            recordPhase(PHASE_COMPRESS, start);
+            if (m_verbose)
+            {
+                *m_logStream << "Compressed file read from cache" << endl;
+            }
+            return true;
+        }
+    }
+
+    if (m_exomizer == NULL)
+    {
+        m_exomizer = exomizer_ctx_new();
+        if (m_exomizer == NULL)
+        {
+            m_statusString = txt_outOfMemory;
+            return false;
+        }
+    }
+    int compressedSize = exomizer(m_exomizer, m_programData + 2,
+                                  m_programSize - 2, loadAddr, startAddr,
+                                  effort, m_compressBuffer);
+    exomizer_ctx_stats(m_exomizer, &m_stats.compressPasses,
+                       &m_stats.matchesEvaluated);
+    recordPhase(PHASE_COMPRESS, start);
+    if (compressedSize < 0)
+    {
+        m_statusString = (compressedSize == EXOMIZER_ERROR_LOAD)
+                         ? txt_compressLoadAddress : txt_compressOutOfMemory;
+        return false;
+    }
+    m_programData = m_compressBuffer;
+    m_programSize = compressedSize;
+    if (m_cache != NULL)
+    {
+        m_cache->store(key, m_programData, m_programSize);
+    }
+
+    if (m_verbose)
+    {
+        *m_logStream << "Compression memory: "
+                     << (getCompressionMemory() + 1023) / 1024 << " KiB"
+                     << endl;
+    }
+
+    return true;
+}
@@ -25,6 +25,7 @@
     For use with VICE VSID.
 */
 
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <cstdlib>
@@ -33,6 +34,7 @@
 
 
 #define BUF     (9*2+8)         /* 16 bit header */
+#define NUM_UD  128             /* undefined labels without allocation */
 
 struct file65 {
         char            *fname;
@@ -42,6 +44,7 @@ struct file65 {
         int             tdiff, ddiff, bdiff, zdiff;
         int             nundef;
         char            **ud;
+        char            *udbuf[NUM_UD];
         unsigned char   *segt;
         unsigned char   *segd;
         unsigned char   *utab;
@@ -57,17 +60,18 @@ int read_undef(const unsigned char *f, file65 *fp);
 unsigned char *reloc_seg(unsigned char *f, int len, unsigned char *rtab, file65 *fp);
 unsigned char *reloc_globals(unsigned char *, file65 *fp);
 
-file65 file;
-unsigned char cmp[] = { 1, 0, 'o', '6', '5' };
+static const unsigned char cmp[] = { 1, 0, 'o', '6', '5' };
 
 int reloc65(char** buf, int* fsize, int addr, globals_t* globals)
 {
+        file65 file;
         int mode, hlen;
 
         int tflag=0, dflag=0, bflag=0, zflag=0;
         int tbase=0, dbase=0, bbase=0, zbase=0;
         int extract = 0;
 
+        memset(&file, 0, sizeof(file));
         file.globals = globals;
 
         file.buf = (unsigned char *) *buf;
@@ -132,7 +136,9 @@ int reloc65(char** buf, int* fsize, int addr, globals_t* globals)
         }
 
         /* free array with names of undefined labels */
-        free(file.ud);
+        if (file.ud != file.udbuf) {
+                free(file.ud);
+        }
 
         switch(extract) {
         case 0: /* whole file */
@@ -169,7 +175,11 @@ int read_undef(const unsigned char *buf, file65 *fp) {
         n = buf[0] + 256*buf[1];
 
         fp->nundef = n;
-        fp->ud = (char **) calloc(n, sizeof(char *));
+        if (n <= NUM_UD) {
+                fp->ud = fp->udbuf;
+        } else {
+                fp->ud = (char **) calloc(n, sizeof(char *));
+        }
 
 /*printf("number of undefined labels = %d\n", fp->nundef);*/
         i=0;
@@ -276,3 +286,159 @@ unsigned char *reloc_globals(unsigned char *buf, file65 *fp) {
         }
         return buf;
 }
+
+
+Reloc65Table::Reloc65Table() :
+        m_text(NULL),
+        m_textBase(0),
+        m_textLen(0),
+        m_patches()
+{
+}
+
+bool Reloc65Table::compile(const unsigned char* obj, int objSize,
+                           const char* const* labelNames, int numLabels)
+{
+        file65 file;
+        int mode, hlen;
+
+        memset(&file, 0, sizeof(file));
+        file.buf = (unsigned char *) obj;
+        file.fsize = objSize;
+        m_patches.clear();
+
+        if (memcmp(obj, cmp, 5) != 0) {
+                return false;
+        }
+
+        mode=obj[7]*256+obj[6];
+        if(mode & 0x6000) {
+                return false;
+        }
+
+        hlen = BUF+read_options(obj+BUF);
+
+        file.tbase = obj[ 9]*256+obj[ 8];
+        file.tlen  = obj[11]*256+obj[10];
+        file.dlen  = obj[15]*256+obj[14];
+
+        file.segt  = file.buf + hlen;
+        file.segd  = file.segt + file.tlen;
+        file.utab  = file.segd + file.dlen;
+        file.rttab = file.utab + read_undef(file.utab, &file);
+
+        /* map the undefined labels to the indices of labelNames */
+        std::vector<int> labels(file.nundef, -1);
+        for (int i = 0; i < file.nundef; i++) {
+                for (int j = 0; j < numLabels; j++) {
+                        if (strcmp(file.ud[i], labelNames[j]) == 0) {
+                                labels[i] = j;
+                                break;
+                        }
+                }
+                if (labels[i] < 0) {
+                        fprintf(stderr,"Warning: undefined label '%s'\n", file.ud[i]);
+                }
+        }
+
+        /* same walk over the relocation table as reloc_seg() */
+        const unsigned char *buf = file.segt;
+        const unsigned char *rtab = file.rttab;
+        int adr = -1;
+        while(*rtab) {
+          if((*rtab & 255) == 255) {
+            adr += 254;
+            rtab++;
+          } else {
+            adr += *rtab & 255;
+            rtab++;
+            int type = *rtab & 0xe0;
+            int seg = *rtab & 0x07;
+            rtab++;
+            Patch patch;
+            patch.offset = adr;
+            patch.label = (seg == 0) ? labels[rtab[0]+256*rtab[1]] : LABEL_TEXT;
+            switch(type) {
+            case 0x80:
+                patch.type = PATCH_WORD;
+                patch.value = buf[adr] + 256*buf[adr+1];
+                break;
+            case 0x40:
+                patch.type = PATCH_HIGH;
+                patch.value = buf[adr]*256 + *rtab;
+                rtab++;
+                break;
+            default:
+                patch.type = PATCH_LOW;
+                patch.value = buf[adr];
+                break;
+            }
+            if(seg==0) rtab+=2;
+            /* only the text segment is moved, other segments and unknown
+               labels leave the address unchanged */
+            if (((type == 0x80) || (type == 0x40) || (type == 0x20))
+                && ((seg == 2) || (patch.label >= 0))) {
+                m_patches.push_back(patch);
+            }
+          }
+        }
+
+        if (file.ud != file.udbuf) {
+                free(file.ud);
+        }
+
+        /* group the patches of each label for relocateLabels() */
+        std::stable_sort(m_patches.begin(), m_patches.end(), patchCmp);
+
+        m_text = file.segt;
+        m_textBase = file.tbase;
+        m_textLen = file.tlen;
+        return true;
+}
+
+void Reloc65Table::relocate(unsigned char* dest, int addr,
+                            const int* values) const
+{
+        const int tdiff = addr - m_textBase;
+
+        memcpy(dest, m_text, m_textLen);
+        for (std::vector<Patch>::const_iterator iter = m_patches.begin();
+             iter != m_patches.end(); ++iter) {
+          applyPatch(dest, *iter,
+                     (iter->label == LABEL_TEXT) ? tdiff : values[iter->label]);
+        }
+}
+
+void Reloc65Table::relocateLabels(unsigned char* dest, const int* values,
+                                  int firstLabel, int endLabel) const
+{
+        Patch first;
+        first.label = firstLabel;
+        std::vector<Patch>::const_iterator iter =
+                std::lower_bound(m_patches.begin(), m_patches.end(), first, patchCmp);
+        for (; (iter != m_patches.end()) && (iter->label < endLabel); ++iter) {
+          applyPatch(dest, *iter, values[iter->label]);
+        }
+}
+
+bool Reloc65Table::patchCmp(const Patch& a, const Patch& b)
+{
+        return a.label < b.label;
+}
+
+void Reloc65Table::applyPatch(unsigned char* dest, const Patch& patch, int diff)
+{
+        int n_new = patch.value + diff;
+        switch(patch.type) {
+        case PATCH_WORD:
+            dest[patch.offset] = n_new & 255;
+            dest[patch.offset+1] = (n_new>>8)&255;
+            break;
+        case PATCH_HIGH:
+            dest[patch.offset] = (n_new>>8)&255;
+            break;
+        default:
+            dest[patch.offset] = n_new & 255;
+            break;
+        }
+}
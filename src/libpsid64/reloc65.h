@@ -27,6 +27,9 @@
 
 #include <map>
 #include <string>
+#include <vector>
+
+#include <sidplay/sidint.h>
 
 
 //////////////////////////////////////////////////////////////////////////////
@@ -40,6 +43,75 @@
 
 typedef std::map<std::string,int> globals_t;
 
+/**
+ * The relocation entries of the text segment of an o65 object file. The
+ * object file is parsed once by compile(), after which relocate() copies
+ * the text segment to any address with a simple patch loop. Undefined
+ * labels are resolved to indices in a list of label names, so that their
+ * values are passed as an array instead of a map.
+ */
+class Reloc65Table
+{
+public:
+    Reloc65Table();
+
+    /**
+     * Extract the relocation entries of the object file obj. An undefined
+     * label that is not in labelNames is reported and resolves to 0, as
+     * in reloc65(). Returns false if obj is not a supported o65 file.
+     */
+    bool compile(const unsigned char* obj, int objSize,
+                 const char* const* labelNames, int numLabels);
+
+    /**
+     * Get the size of the text segment.
+     */
+    inline int getSize() const
+    {
+        return m_textLen;
+    }
+
+    /**
+     * Copy the text segment to dest, relocated to addr. The values array
+     * holds the values of the labels passed to compile().
+     */
+    void relocate(unsigned char* dest, int addr, const int* values) const;
+
+    /**
+     * Patch only the references to the labels firstLabel up to, but not
+     * including, endLabel in a text segment that was relocated before. This
+     * updates an image with the values of those labels without copying it.
+     */
+    void relocateLabels(unsigned char* dest, const int* values,
+                        int firstLabel, int endLabel) const;
+
+private:
+    enum PatchType
+    {
+        PATCH_WORD,  // two byte address
+        PATCH_HIGH,  // high byte of an address
+        PATCH_LOW    // low byte of an address
+    };
+
+    static const int LABEL_TEXT = -1;  // relative to the text segment
+
+    struct Patch
+    {
+        uint_least16_t offset;  // offset in the text segment
+        uint_least8_t type;  // PatchType
+        int label;  // index of the label or LABEL_TEXT
+        int value;  // address before relocation
+    };
+
+    static bool patchCmp(const Patch& a, const Patch& b);
+    static void applyPatch(unsigned char* dest, const Patch& patch, int diff);
+
+    const unsigned char* m_text;
+    int m_textBase;
+    int m_textLen;
+    std::vector<Patch> m_patches;  // sorted by label
+};
+
 
 //////////////////////////////////////////////////////////////////////////////
 //                  F U N C T I O N   D E C L A R A T O R S
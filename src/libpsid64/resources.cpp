@@ -0,0 +1,313 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+    psid64 - create a C64 executable from a PSID file
+    Copyright (C) 2001-2023  Roland Hermans <rolandh@users.sourceforge.net>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+//////////////////////////////////////////////////////////////////////////////
+//                             I N C L U D E S
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <psid64/psid64.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+
+#include "mutexlock.h"
+#include "sidid.h"
+#include "stilview/stil.h"
+
+using std::string;
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                           G L O B A L   D A T A
+//////////////////////////////////////////////////////////////////////////////
+
+const char* Psid64Resources::txt_stilNotFound = "PSID64: Cannot find STIL.txt in the HVSC";
+const char* Psid64Resources::txt_databaseNotFound = "PSID64: Cannot find the song length database";
+const char* Psid64Resources::txt_sidIdConfigError = "PSID64: Cannot read SID ID configuration file";
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                     L O C A L   F U N C T I O N S
+//////////////////////////////////////////////////////////////////////////////
+
+static bool
+isFile(const string& fileName)
+{
+    struct stat s;
+    return (stat(fileName.c_str(), &s) == 0) && S_ISREG(s.st_mode);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//               P U B L I C   M E M B E R   F U N C T I O N S
+//////////////////////////////////////////////////////////////////////////////
+
+// constructor
+
+Psid64Resources::Psid64Resources() :
+    m_hvscRoot(),
+    m_databaseFileName(),
+    m_sidIdConfigFileName(),
+    m_statusString(NULL),
+    m_mutex(new Mutex),
+    m_database(),
+    m_stil(new STIL),
+    m_sidId(new SidId),
+    m_stilPending(false),
+    m_databasePending(false),
+    m_sidIdPending(false),
+    m_stilLoaded(new OnceFlag),
+    m_databaseLoaded(new OnceFlag),
+    m_sidIdLoaded(new OnceFlag),
+    m_stilError(NULL),
+    m_databaseError(NULL),
+    m_sidIdError(NULL)
+{
+}
+
+// destructor
+
+Psid64Resources::~Psid64Resources()
+{
+    delete m_stil;
+    delete m_sidId;
+    delete m_stilLoaded;
+    delete m_databaseLoaded;
+    delete m_sidIdLoaded;
+    delete m_mutex;
+}
+
+
+bool Psid64Resources::setHvscRoot(const string &hvscRoot)
+{
+    m_hvscRoot = hvscRoot;
+    m_stilPending = false;
+    m_stilLoaded->clear();
+    m_stilError = NULL;
+    if (!m_hvscRoot.empty())
+    {
+        if (!isFile(m_hvscRoot + "/DOCUMENTS/STIL.txt"))
+        {
+            m_statusString = txt_stilNotFound;
+            return false;
+        }
+        m_stilPending = true;
+    }
+
+    return true;
+}
+
+
+bool Psid64Resources::setDatabaseFileName(const string &databaseFileName)
+{
+    m_databaseFileName = databaseFileName;
+    m_databasePending = false;
+    m_databaseLoaded->clear();
+    m_databaseError = NULL;
+    if (!m_databaseFileName.empty())
+    {
+        if (!isFile(m_databaseFileName))
+        {
+            m_statusString = txt_databaseNotFound;
+            return false;
+        }
+        m_databasePending = true;
+    }
+
+    return true;
+}
+
+
+bool Psid64Resources::setSidIdConfigFileName(const string &sidIdConfigFileName)
+{
+    m_sidIdConfigFileName = sidIdConfigFileName;
+    m_sidIdPending = false;
+    m_sidIdLoaded->clear();
+    m_sidIdError = NULL;
+    if (!m_sidIdConfigFileName.empty())
+    {
+        if (!isFile(m_sidIdConfigFileName))
+        {
+            m_statusString = txt_sidIdConfigError;
+            return false;
+        }
+        m_sidIdPending = true;
+    }
+
+    return true;
+}
+
+
+bool Psid64Resources::load()
+{
+    const char* errors[] = { loadStil(), loadDatabase(), loadSidId() };
+    for (size_t i = 0; i < sizeof(errors) / sizeof(errors[0]); ++i)
+    {
+        if (errors[i] != NULL)
+        {
+            m_statusString = errors[i];
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+bool
+Psid64Resources::getStilText(const string &hvscFileName, bool useGlobalComment,
+                             string &text, const char* &errorString) const
+{
+    const char* loadError = loadStil();
+    if (loadError != NULL)
+    {
+        errorString = loadError;
+        return false;
+    }
+
+    const char* path = hvscFileName.c_str();
+    STIL::STILerror error = STIL::NO_STIL_ERROR;
+    if (useGlobalComment)
+    {
+        const char* globalComment = m_stil->lookupGlobalComment(path, error);
+        if (globalComment != NULL)
+        {
+            text += globalComment;
+        }
+    }
+    if (error < STIL::CRITICAL_STIL_ERROR)
+    {
+        const char* stilEntry = m_stil->lookupEntry(path, error);
+        if (stilEntry != NULL)
+        {
+            text += stilEntry;
+        }
+    }
+    if (error < STIL::CRITICAL_STIL_ERROR)
+    {
+        const char* bugEntry = m_stil->lookupBug(path, error);
+        if (bugEntry != NULL)
+        {
+            text += bugEntry;
+        }
+    }
+    if (error >= STIL::CRITICAL_STIL_ERROR)
+    {
+        errorString = STIL::getErrorStr(error);
+        return false;
+    }
+
+    return true;
+}
+
+
+void
+Psid64Resources::getSongLengths(const char* md5, int_least32_t* lengths,
+                                uint_least16_t songs) const
+{
+    loadDatabase();
+    if (m_database.lengths(md5, lengths, songs) < 0)
+    {
+        std::fill(lengths, lengths + songs, -1);
+    }
+}
+
+
+const string&
+Psid64Resources::identifyPlayer(const uint_least8_t* buffer, size_t bufferSize,
+                                std::vector<size_t>& work) const
+{
+    loadSidId();
+    return m_sidId->identify(buffer, bufferSize, work);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//              P R I V A T E   M E M B E R   F U N C T I O N S
+//////////////////////////////////////////////////////////////////////////////
+
+// The load functions load a pending resource once and return its error, or
+// NULL on success. The mutex is only taken until the resource has been
+// loaded.
+
+const char*
+Psid64Resources::loadStil() const
+{
+    if (!m_stilPending || m_stilLoaded->isSet())
+    {
+        return m_stilError;
+    }
+    MutexLock lock(*m_mutex);
+    if (!m_stilLoaded->isSetLocked())
+    {
+        if (!m_stil->setBaseDir(m_hvscRoot.c_str()))
+        {
+            m_stilError = m_stil->getErrorStr();
+        }
+        m_stilLoaded->set();
+    }
+    return m_stilError;
+}
+
+
+const char*
+Psid64Resources::loadDatabase() const
+{
+    if (!m_databasePending || m_databaseLoaded->isSet())
+    {
+        return m_databaseError;
+    }
+    MutexLock lock(*m_mutex);
+    if (!m_databaseLoaded->isSetLocked())
+    {
+        if (m_database.open(m_databaseFileName.c_str()) < 0)
+        {
+            m_databaseError = m_database.error();
+        }
+        m_databaseLoaded->set();
+    }
+    return m_databaseError;
+}
+
+
+const char*
+Psid64Resources::loadSidId() const
+{
+    if (!m_sidIdPending || m_sidIdLoaded->isSet())
+    {
+        return m_sidIdError;
+    }
+    MutexLock lock(*m_mutex);
+    if (!m_sidIdLoaded->isSetLocked())
+    {
+        if (!m_sidId->readConfigFile(m_sidIdConfigFileName))
+        {
+            m_sidIdError = txt_sidIdConfigError;
+        }
+        m_sidIdLoaded->set();
+    }
+    return m_sidIdError;
+}
@@ -119,6 +119,17 @@ void Screen::write(const char *str)
 }
 
 
+void Screen::write(const char *str, unsigned int maxLength)
+{
+    while (*str && (maxLength > 0))
+    {
+        putchar(*str);
+        ++str;
+        --maxLength;
+    }
+}
+
+
 void Screen::poke(unsigned int x, unsigned int y, uint_least8_t value)
 {
     if ((x < m_width) && (y < m_height))
@@ -49,6 +49,7 @@ public:
     void moveTo(unsigned int x, unsigned int y);
     void putchar(char c);
     void write(const char *str);
+    void write(const char *str, unsigned int maxLength);
 
     inline void write(const std::string& str)
     {
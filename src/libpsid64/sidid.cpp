@@ -24,7 +24,9 @@
 
 #include "sidid.h"
 
+#include <algorithm>
 #include <fstream>
+#include <map>
 #include <sstream>
 
 
@@ -37,6 +39,11 @@
 //                     L O C A L   D E F I N I T I O N S
 //////////////////////////////////////////////////////////////////////////////
 
+// end of a list of signatures
+static const size_t NONE = static_cast<size_t>(-1);
+
+// result when no player is identified
+static const std::string NO_PLAYER;
 
 
 //////////////////////////////////////////////////////////////////////////////
@@ -65,56 +72,9 @@ void SidId::Pattern::pushValue(uint_least16_t value)
 }
 
 
-bool SidId::Pattern::match(const std::vector<uint_least8_t>& buffer) const
+const std::vector<uint_least16_t>& SidId::Pattern::values() const
 {
-    const uint_least8_t* p_buffer = &buffer.front();
-    const uint_least16_t* p_values = &m_values.front();
-    size_t buffer_size = buffer.size();
-    size_t i = 0;
-    size_t j = 0;
-
-    while (true)
-    {
-        // search for first matching byte
-        while ((i < buffer_size) && (p_buffer[i] != p_values[j]))
-        {
-            ++i;
-        }
-        if (i == buffer_size)
-        {
-            break;
-        }
-        size_t saved_i = i;
-        size_t saved_j = j;
-
-        // check if subsequent bytes match as well
-        while ((i < buffer_size)
-               && ((p_buffer[i] == p_values[j])
-                   || (p_values[j] == MATCH_WILDCARD_ONE)))
-        {
-            ++i;
-            ++j;
-        }
-
-        if (p_values[j] == MATCH_END)
-        {
-            // all parts matched
-            break;
-        }
-        else if (p_values[j] == MATCH_WILDCARD_MULTIPLE)
-        {
-            // this part did match, continue with next part
-            ++j;
-        }
-        else
-        {
-            // retry matching after first byte of current match attempt
-            i = saved_i + 1;
-            j = saved_j;
-        }
-    }
-
-    return (p_values[j] == MATCH_END);
+    return m_values;
 }
 
 
@@ -136,18 +96,10 @@ const std::string& SidId::Player::name() const
 }
 
 
-    bool SidId::Player::match(const std::vector<uint_least8_t>& buffer) const
-    {
-        for (std::vector<Pattern>::const_iterator iter = m_patterns.begin();
-             iter != m_patterns.end(); ++iter)
-        {
-            if (iter->match(buffer))
-            {
-                return true;
-            }
-        }
-        return false;
-    }
+const std::vector<SidId::Pattern>& SidId::Player::patterns() const
+{
+    return m_patterns;
+}
 
 
 std::string SidId::trim(const std::string& str, const std::string& whitespace)
@@ -162,6 +114,250 @@ std::string SidId::trim(const std::string& str, const std::string& whitespace)
 }
 
 
+void SidId::compile()
+{
+    m_parts.clear();
+    m_signatures.clear();
+    m_nodes.clear();
+    m_rows.clear();
+    m_edgeValues.clear();
+    m_edgeNodes.clear();
+    m_nodeParts.clear();
+
+    // split the patterns into parts, identical parts are compiled only once
+    std::map<std::vector<uint_least16_t>, size_t> part_ids;
+    for (size_t player = 0; player < m_players.size(); ++player)
+    {
+        const std::vector<Pattern>& patterns = m_players[player].patterns();
+        for (std::vector<Pattern>::const_iterator iter = patterns.begin();
+             iter != patterns.end(); ++iter)
+        {
+            const std::vector<uint_least16_t>& values = iter->values();
+            Signature signature;
+            signature.player = player;
+            bool matchable = true;
+            std::vector<uint_least16_t>::const_iterator begin = values.begin();
+            while (true)
+            {
+                std::vector<uint_least16_t>::const_iterator end = begin;
+                while ((*end != MATCH_WILDCARD_MULTIPLE) && (*end != MATCH_END))
+                {
+                    ++end;
+                }
+
+                // The search for a part starts with its first byte, so an
+                // empty part or a part that starts with a wildcard is never
+                // found. An empty part at the end of a pattern is not
+                // searched for at all.
+                if (begin == end)
+                {
+                    matchable = (*end == MATCH_END);
+                    break;
+                }
+                if (*begin == MATCH_WILDCARD_ONE)
+                {
+                    matchable = false;
+                    break;
+                }
+
+                std::vector<uint_least16_t> part_values(begin, end);
+                std::map<std::vector<uint_least16_t>, size_t>::const_iterator
+                    part_iter = part_ids.find(part_values);
+                if (part_iter == part_ids.end())
+                {
+                    Part part;
+                    part.values = part_values;
+                    part.anchorOffset = 0;
+                    part.anchorEnd = 0;
+                    size_t run_start = 0;
+                    for (size_t i = 0; i <= part_values.size(); ++i)
+                    {
+                        if ((i == part_values.size())
+                            || (part_values[i] == MATCH_WILDCARD_ONE))
+                        {
+                            if (i - run_start > part.anchorEnd - part.anchorOffset)
+                            {
+                                part.anchorOffset = run_start;
+                                part.anchorEnd = i;
+                            }
+                            run_start = i + 1;
+                        }
+                    }
+                    part_iter = part_ids.insert(std::make_pair(part_values,
+                                                               m_parts.size())).first;
+                    m_parts.push_back(part);
+                }
+                signature.parts.push_back(part_iter->second);
+
+                if (*end == MATCH_END)
+                {
+                    break;
+                }
+                begin = end + 1;
+            }
+
+            if (matchable)
+            {
+                m_signatures.push_back(signature);
+            }
+        }
+    }
+
+    // build a trie of the anchors of all parts
+    std::vector<std::map<uint_least8_t, uint_least32_t> > children(1);
+    std::vector<std::vector<uint_least32_t> > node_parts(1);
+    for (size_t part_id = 0; part_id < m_parts.size(); ++part_id)
+    {
+        const Part& part = m_parts[part_id];
+        uint_least32_t node = 0;
+        for (size_t i = part.anchorOffset; i < part.anchorEnd; ++i)
+        {
+            uint_least8_t value = (uint_least8_t) part.values[i];
+            std::map<uint_least8_t, uint_least32_t>::const_iterator child =
+                children[node].find(value);
+            if (child == children[node].end())
+            {
+                uint_least32_t new_node = (uint_least32_t) children.size();
+                children[node][value] = new_node;
+                children.push_back(std::map<uint_least8_t, uint_least32_t>());
+                node_parts.push_back(std::vector<uint_least32_t>());
+                node = new_node;
+            }
+            else
+            {
+                node = child->second;
+            }
+        }
+        node_parts[node].push_back((uint_least32_t) part_id);
+    }
+
+    // add the fail and output links in breadth first order
+    m_nodes.resize(children.size());
+    m_nodes[0].fail = 0;
+    m_nodes[0].output = 0;
+    std::vector<uint_least32_t> queue(1, 0);
+    for (size_t head = 0; head < queue.size(); ++head)
+    {
+        uint_least32_t node = queue[head];
+        for (std::map<uint_least8_t, uint_least32_t>::const_iterator child =
+                 children[node].begin();
+             child != children[node].end(); ++child)
+        {
+            uint_least32_t fail = 0;
+            if (node != 0)
+            {
+                fail = m_nodes[node].fail;
+                while ((fail != 0) && (children[fail].count(child->first) == 0))
+                {
+                    fail = m_nodes[fail].fail;
+                }
+                std::map<uint_least8_t, uint_least32_t>::const_iterator
+                    fail_child = children[fail].find(child->first);
+                fail = (fail_child != children[fail].end())
+                    ? fail_child->second : 0;
+            }
+            m_nodes[child->second].fail = fail;
+            m_nodes[child->second].output =
+                node_parts[fail].empty() ? m_nodes[fail].output : fail;
+            queue.push_back(child->second);
+        }
+    }
+
+    // store the edges and parts of all nodes consecutively
+    for (size_t node = 0; node < m_nodes.size(); ++node)
+    {
+        m_nodes[node].firstEdge = (uint_least32_t) m_edgeValues.size();
+        m_nodes[node].edgeCount = (uint_least32_t) children[node].size();
+        for (std::map<uint_least8_t, uint_least32_t>::const_iterator child =
+                 children[node].begin();
+             child != children[node].end(); ++child)
+        {
+            m_edgeValues.push_back(child->first);
+            m_edgeNodes.push_back(child->second);
+        }
+        m_nodes[node].firstPart = (uint_least32_t) m_nodeParts.size();
+        m_nodes[node].partCount = (uint_least32_t) node_parts[node].size();
+        m_nodeParts.insert(m_nodeParts.end(), node_parts[node].begin(),
+                           node_parts[node].end());
+    }
+
+    // add the rows of the root and its children, the fail link of a child
+    // of the root is the root itself
+    m_nodes[0].row = 0;
+    m_rows.assign(256, 0);
+    for (size_t node = 1; node < m_nodes.size(); ++node)
+    {
+        m_nodes[node].row = NO_ROW;
+    }
+    for (std::map<uint_least8_t, uint_least32_t>::const_iterator child =
+             children[0].begin();
+         child != children[0].end(); ++child)
+    {
+        m_rows[child->first] = child->second;
+    }
+    const std::vector<uint_least32_t> root_row(m_rows);
+    for (std::map<uint_least8_t, uint_least32_t>::const_iterator child =
+             children[0].begin();
+         child != children[0].end(); ++child)
+    {
+        const uint_least32_t row = (uint_least32_t) (m_rows.size() / 256);
+        m_nodes[child->second].row = row;
+        m_rows.insert(m_rows.end(), root_row.begin(), root_row.end());
+        for (std::map<uint_least8_t, uint_least32_t>::const_iterator
+                 grandchild = children[child->second].begin();
+             grandchild != children[child->second].end(); ++grandchild)
+        {
+            m_rows[row * 256 + grandchild->first] = grandchild->second;
+        }
+    }
+}
+
+
+uint_least32_t SidId::next(uint_least32_t node, uint_least8_t value) const
+{
+    while (true)
+    {
+        const Node& n = m_nodes[node];
+        if (n.row != NO_ROW)
+        {
+            return m_rows[n.row * 256 + value];
+        }
+        if (n.edgeCount > 0)
+        {
+            const uint_least8_t* p_begin = &m_edgeValues[n.firstEdge];
+            const uint_least8_t* p_end = p_begin + n.edgeCount;
+            const uint_least8_t* p_edge =
+                std::lower_bound(p_begin, p_end, value);
+            if ((p_edge != p_end) && (*p_edge == value))
+            {
+                return m_edgeNodes[n.firstEdge + (p_edge - p_begin)];
+            }
+        }
+        node = n.fail;
+    }
+}
+
+
+bool SidId::matchPart(const Part& part, const uint_least8_t* buffer,
+                      size_t buffer_size, size_t start) const
+{
+    const size_t size = part.values.size();
+    if (start + size > buffer_size)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < size; ++i)
+    {
+        if ((part.values[i] != MATCH_WILDCARD_ONE)
+            && (part.values[i] != buffer[start + i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
 bool SidId::readConfigFile(const std::string& filename)
 {
     m_players.clear();
@@ -196,6 +392,7 @@ bool SidId::readConfigFile(const std::string& filename)
                     if (m_players.empty())
                     {
                         // first player definition did not start with a name
+                        compile();
                         return false;
                     }
                     m_players.back().addPattern(pattern);
@@ -219,20 +416,118 @@ bool SidId::readConfigFile(const std::string& filename)
         }
     }
 
+    compile();
     return true;
 }
 
 
-std::string SidId::identify(const std::vector<uint_least8_t>& buffer)
+const std::string& SidId::identify(const uint_least8_t* buffer, size_t buffer_size,
+                                   std::vector<size_t>& work) const
 {
-    for (std::vector<Player>::const_iterator iter = m_players.begin();
-         iter != m_players.end(); ++iter)
+    const size_t signature_count = m_signatures.size();
+    if (signature_count == 0)
+    {
+        return NO_PLAYER;
+    }
+
+    // Each signature waits for its next part. As the parts of a pattern have
+    // to be found in order, a part is searched for from the end of the match
+    // of the previous part. The signatures that wait for the same part are
+    // linked in a list, so that a part is only verified while needed.
+    // All lists are kept in the work vector, whose memory is reused.
+    work.assign(3 * signature_count, 0);
+    work.resize(4 * signature_count + m_parts.size(), NONE);
+    size_t* next_part = &work[0];
+    size_t* min_start = next_part + signature_count;
+    size_t* matched = min_start + signature_count;
+    size_t* next_waiting = matched + signature_count;
+    size_t* first_waiting = next_waiting + signature_count;
+    size_t waiting_count = 0;
+    for (size_t i = signature_count; i-- > 0; )
+    {
+        const Signature& signature = m_signatures[i];
+        if (signature.parts.empty())
+        {
+            matched[i] = 1;
+        }
+        else
+        {
+            next_waiting[i] = first_waiting[signature.parts[0]];
+            first_waiting[signature.parts[0]] = i;
+            ++waiting_count;
+        }
+    }
+
+    // find the parts in a single pass
+    uint_least32_t node = 0;
+    for (size_t i = 0; (i < buffer_size) && (waiting_count > 0); ++i)
+    {
+        node = next(node, buffer[i]);
+        uint_least32_t output = (m_nodes[node].partCount > 0)
+            ? node : m_nodes[node].output;
+        while (output != 0)
+        {
+            const Node& n = m_nodes[output];
+            for (uint_least32_t j = 0; j < n.partCount; ++j)
+            {
+                const uint_least32_t part_id = m_nodeParts[n.firstPart + j];
+                const Part& part = m_parts[part_id];
+                if ((first_waiting[part_id] == NONE)
+                    || (i + 1 < part.anchorEnd)
+                    || !matchPart(part, buffer, buffer_size,
+                                  i + 1 - part.anchorEnd))
+                {
+                    continue;
+                }
+
+                // advance the signatures that wait for this match
+                const size_t start = i + 1 - part.anchorEnd;
+                size_t signature = first_waiting[part_id];
+                size_t still_waiting = NONE;
+                first_waiting[part_id] = NONE;
+                while (signature != NONE)
+                {
+                    const size_t next_signature = next_waiting[signature];
+                    if (min_start[signature] > start)
+                    {
+                        next_waiting[signature] = still_waiting;
+                        still_waiting = signature;
+                    }
+                    else
+                    {
+                        const std::vector<size_t>& parts =
+                            m_signatures[signature].parts;
+                        min_start[signature] = start + part.values.size();
+                        if (++next_part[signature] == parts.size())
+                        {
+                            matched[signature] = 1;
+                            --waiting_count;
+                        }
+                        else
+                        {
+                            const size_t waiting_for =
+                                parts[next_part[signature]];
+                            size_t& first = (waiting_for == part_id)
+                                ? still_waiting : first_waiting[waiting_for];
+                            next_waiting[signature] = first;
+                            first = signature;
+                        }
+                    }
+                    signature = next_signature;
+                }
+                first_waiting[part_id] = still_waiting;
+            }
+            output = n.output;
+        }
+    }
+
+    for (size_t i = 0; i < signature_count; ++i)
     {
-        if (iter->match(buffer))
+        if (matched[i])
         {
-            return iter->name();
+            return m_players[m_signatures[i].player].name();
         }
     }
 
-    return "";
+    return NO_PLAYER;
 }
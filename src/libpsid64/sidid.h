@@ -48,7 +48,7 @@ class SidId
     public:
         void clear();
         void pushValue(uint_least16_t value);
-        bool match(const std::vector<uint_least8_t>& buffer) const;
+        const std::vector<uint_least16_t>& values() const;
     };
 
     class Player
@@ -59,20 +59,68 @@ class SidId
         explicit Player(const std::string& name);
         void addPattern(const Pattern& pattern);
         const std::string& name() const;
-        bool match(const std::vector<uint_least8_t>& buffer) const;
+        const std::vector<Pattern>& patterns() const;
+    };
+
+    // A sequence of bytes and single byte wildcards. A pattern consists of
+    // parts separated by AND wildcards, identical parts are shared.
+    struct Part
+    {
+        std::vector<uint_least16_t> values;
+        size_t anchorOffset;    // start of the longest run of bytes
+        size_t anchorEnd;       // end of the longest run of bytes
+    };
+
+    // Node of the Aho-Corasick automaton that finds the anchors of all
+    // parts. The edges and anchors of a node are stored consecutively. The
+    // root and its children, where most of the time is spent, also have a
+    // row with the next node for every byte value.
+    struct Node
+    {
+        uint_least32_t row;     // NO_ROW if there's no row
+        uint_least32_t fail;
+        uint_least32_t output;  // next node on the fail path with anchors
+        uint_least32_t firstEdge;
+        uint_least32_t edgeCount;
+        uint_least32_t firstPart;
+        uint_least32_t partCount;
+    };
+
+    // Compiled pattern: the parts to be found in this order. A pattern that
+    // can never match is not compiled at all.
+    struct Signature
+    {
+        size_t player;
+        std::vector<size_t> parts;
     };
 
     std::vector<Player> m_players;
 
+    std::vector<Part> m_parts;
+    std::vector<Signature> m_signatures;
+    std::vector<Node> m_nodes;
+    std::vector<uint_least32_t> m_rows;
+    std::vector<uint_least8_t> m_edgeValues;
+    std::vector<uint_least32_t> m_edgeNodes;
+    std::vector<uint_least32_t> m_nodeParts;
+
     static const uint_least16_t MATCH_WILDCARD_ONE = 0x100;
     static const uint_least16_t MATCH_WILDCARD_MULTIPLE = 0x101;
     static const uint_least16_t MATCH_END = 0x102;
+    static const uint_least32_t NO_ROW = 0xffffffff;
 
     static std::string trim(const std::string& str,
                             const std::string& whitespace = " \t\n\r");
+    void compile();
+    uint_least32_t next(uint_least32_t node, uint_least8_t value) const;
+    bool matchPart(const Part& part, const uint_least8_t* buffer,
+                   size_t buffer_size, size_t start) const;
 public:
     bool readConfigFile(const std::string& filename);
-    std::string identify(const std::vector<uint_least8_t>& buffer);
+    // The work vector holds the matching state. A caller that keeps it
+    // between calls saves its allocation, it must not be shared by threads.
+    const std::string& identify(const uint_least8_t* buffer, size_t buffer_size,
+                                std::vector<size_t>& work) const;
 };
 
 #endif  // SIDID_H
@@ -13,12 +13,30 @@
 #ifndef _STIL
 #define _STIL
 
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
+#include <cctype>
 #include <cstring>
 #include <fstream>
 #include <cstdio>      // For snprintf() and NULL
+#include <set>
+#include <string>
+#include <vector>
 using namespace std;
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+#include <sys/mman.h>
+#define STIL_USE_MMAP
+#endif
+
 #include "stil.h"
 
 #define STILopenFlags (ios::in | ios::binary)
@@ -27,6 +45,50 @@ const float VERSION_NO = 2.17;
 
 #define CERR_STIL_DEBUG if (STIL_DEBUG) cerr << "Line #" << __LINE__ << " STIL::"
 
+// Layout of the index file header. It is followed by the hash table and
+// the text. All values are stored in the byte order of the machine that
+// created the file, an index created on a machine with a different byte
+// order is rebuilt.
+static const char INDEX_MAGIC[8] = { 'S', 'T', 'I', 'L', 'I', 'D', 'X', '1' };
+static const char *INDEX_SUFFIX = ".idx";
+static const uint32_t INDEX_BYTE_ORDER = 0x01020304;
+
+struct IndexHeader {
+    char magic[8];
+    uint32_t byteOrder;
+    uint32_t bucketCount;
+    uint32_t textLength;     // without the terminating '\0'
+    float stilVersion;       // determines how BUGlist.txt was indexed, too
+    uint64_t fileSize;       // size of the text file
+    int64_t fileTime;        // modification time of the text file
+};
+
+// Case-insensitive hash of a pathname (FNV-1a).
+static uint32_t
+hashPath(const char *path, size_t length)
+{
+    uint32_t hash = 2166136261U;
+
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint32_t) tolower((unsigned char) path[i]);
+        hash *= 16777619U;
+    }
+
+    return hash;
+}
+
+static string
+toLowerString(const char *str, size_t length)
+{
+    string result(str, length);
+
+    for (size_t i = 0; i < length; i++) {
+        result[i] = (char) tolower((unsigned char) result[i]);
+    }
+
+    return result;
+}
+
 // CONSTRUCTOR
 STIL::STIL()
 {
@@ -40,18 +102,13 @@ STIL::STIL()
     STILVersion = 0.0;
     baseDir = NULL;
     baseDirLength = 0;
-    memset((void *)entrybuf, 0, sizeof(entrybuf));
-    memset((void *)globalbuf, 0, sizeof(globalbuf));
-    memset((void *)bugbuf, 0, sizeof(bugbuf));
     memset((void *)resultEntry, 0, sizeof(resultEntry));
     memset((void *)resultBug, 0, sizeof(resultBug));
 
-    // Just so that we have the first one in here.
-    stilDirs = createOneDir();
-    bugDirs = createOneDir();
-
-    STIL_EOL = '\n';
-    STIL_EOL2 = '\0';
+    stilData.image = NULL;
+    freeIndexedFile(stilData);
+    bugData.image = NULL;
+    freeIndexedFile(bugData);
 
     STIL_DEBUG = false;
     lastError = NO_STIL_ERROR;
@@ -62,8 +119,8 @@ STIL::~STIL()
 {
     CERR_STIL_DEBUG << "Destructor called" << endl;
 
-    deleteDirList(stilDirs);
-    deleteDirList(bugDirs);
+    freeIndexedFile(stilData);
+    freeIndexedFile(bugData);
 
     if (baseDir != NULL) {
         delete[] baseDir;
@@ -109,8 +166,11 @@ STIL::setBaseDir(const char *pathToHVSC)
     // Temporary placeholder for STIL.txt's version number.
     float tempSTILVersion = STILVersion;
 
-    // Temporary placeholders for lists of sections.
-    dirList *tempStilDirs, *tempBugDirs;
+    // Temporary placeholders for the contents of STIL.txt and BUGlist.txt.
+    indexedFile tempStilData = { NULL, 0, false, NULL, 0, NULL, 0 };
+    indexedFile tempBugData = { NULL, 0, false, NULL, 0, NULL, 0 };
+
+    STILerror error;
 
 
     lastError = NO_STIL_ERROR;
@@ -135,7 +195,21 @@ STIL::setBaseDir(const char *pathToHVSC)
     }
     tempBaseDirLength = strlen(tempBaseDir);
 
-    // Attempt to open STIL
+    // Save away the current string so we can restore it if needed.
+    strncpy(tempVersionString, versionString, 2*STIL_MAX_LINE_SIZE-1);
+    tempVersionString[2*STIL_MAX_LINE_SIZE-1] = '\0';
+#ifdef HAVE_SNPRINTF
+    snprintf(versionString, 2*STIL_MAX_LINE_SIZE-1, "STILView v%4.2f, (C) 1998, 2002 by LaLa (LaLa@C64.org)\n", VERSION_NO);
+#else
+    sprintf(versionString, "STILView v%4.2f, (C) 1998, 2002 by LaLa (LaLa@C64.org)\n", VERSION_NO);
+#endif
+    versionString[2*STIL_MAX_LINE_SIZE-1] = '\0';
+
+    // This is necessary so the version number gets scanned in from the new
+    // file, too.
+    STILVersion = 0.0;
+
+    // Attempt to read STIL
 
     // Create the full path+filename
     tempNameLength = tempBaseDirLength+strlen(PATH_TO_STIL);
@@ -145,19 +219,41 @@ STIL::setBaseDir(const char *pathToHVSC)
     tempName[tempNameLength] = '\0';
     convertSlashes(tempName);
 
-    stilFile.clear();
-    stilFile.open(tempName, STILopenFlags);
+    if (loadIndex(tempName, true, tempStilData) != true) {
+        error = buildIndex(tempName, true, tempStilData);
+        if (error != NO_STIL_ERROR) {
+            CERR_STIL_DEBUG << "setBaseDir() buildIndex() failed for " << tempName << endl;
+            lastError = error;
 
-    if (stilFile.fail()) {
-        stilFile.close();
-        CERR_STIL_DEBUG << "setBaseDir() open failed for " << tempName << endl;
-        lastError = STIL_OPEN;
-        return false;
+            // Clean up and restore things.
+            freeIndexedFile(tempStilData);
+            delete[] tempName;
+            delete[] tempBaseDir;
+            STILVersion = tempSTILVersion;
+            strncpy(versionString, tempVersionString, 2*STIL_MAX_LINE_SIZE-1);
+            versionString[2*STIL_MAX_LINE_SIZE-1] = '\0';
+            return false;
+        }
+        saveIndex(tempName, tempStilData);
     }
 
-    CERR_STIL_DEBUG << "setBaseDir(): open succeeded for " << tempName << endl;
+    CERR_STIL_DEBUG << "setBaseDir(): STIL.txt indexed, STILVersion=" << STILVersion << endl;
 
-    // Attempt to open BUGlist
+    if (STILVersion != 0.0) {
+        char versionLine[STIL_MAX_LINE_SIZE];
+
+        // Put the version number into the string, too.
+#ifdef HAVE_SNPRINTF
+        snprintf(versionLine, STIL_MAX_LINE_SIZE-1, "SID Tune Information List (STIL) v%4.2f\n", STILVersion);
+#else
+        sprintf(versionLine, "SID Tune Information List (STIL) v%4.2f\n", STILVersion);
+#endif
+        versionLine[STIL_MAX_LINE_SIZE-1] = '\0';
+        strncat(versionString, versionLine, 2*STIL_MAX_LINE_SIZE-1-strlen(versionString));
+        versionString[2*STIL_MAX_LINE_SIZE-1] = '\0';
+    }
+
+    // Attempt to read BUGlist
 
     // Create the full path+filename
     delete[] tempName;
@@ -168,80 +264,23 @@ STIL::setBaseDir(const char *pathToHVSC)
     tempName[tempNameLength] = '\0';
     convertSlashes(tempName);
 
-    bugFile.clear();
-    bugFile.open(tempName, STILopenFlags);
-
-    if (bugFile.fail()) {
-
-        // This is not a critical error - some earlier versions of HVSC did
-        // not have a BUGlist.txt file at all.
-
-        bugFile.close();
-        CERR_STIL_DEBUG << "setBaseDir() open failed for " << tempName << endl;
-        lastError = BUG_OPEN;
-    }
-
-    CERR_STIL_DEBUG << "setBaseDir(): open succeeded for " << tempName << endl;
-
-    delete[] tempName;
-
-    // Find out what the EOL really is
-    if (determineEOL() != true) {
-        stilFile.close();
-        bugFile.close();
-        CERR_STIL_DEBUG << "determinEOL() failed" << endl;
-        lastError = NO_EOL;
-        return false;
-    }
-
-    // Save away the current string so we can restore it if needed.
-    strncpy(tempVersionString, versionString, 2*STIL_MAX_LINE_SIZE-1);
-    tempVersionString[2*STIL_MAX_LINE_SIZE-1] = '\0';
-#ifdef HAVE_SNPRINTF
-    snprintf(versionString, 2*STIL_MAX_LINE_SIZE-1, "STILView v%4.2f, (C) 1998, 2002 by LaLa (LaLa@C64.org)\n", VERSION_NO);
-#else
-    sprintf(versionString, "STILView v%4.2f, (C) 1998, 2002 by LaLa (LaLa@C64.org)\n", VERSION_NO);
-#endif
-    versionString[2*STIL_MAX_LINE_SIZE-1] = '\0';
-
-    // This is necessary so the version number gets scanned in from the new
-    // file, too.
-    STILVersion = 0.0;
-
-    // These will populate the tempStilDirs and tempBugDirs arrays (or not :)
-
-    tempStilDirs = createOneDir();
-    tempBugDirs = createOneDir();
-
-    if (getDirs(stilFile, tempStilDirs, true) != true) {
-        stilFile.close();
-        bugFile.close();
-        CERR_STIL_DEBUG << "getDirs() failed for stilFile" << endl;
-        lastError = NO_STIL_DIRS;
-
-        // Clean up and restore things.
-        deleteDirList(tempStilDirs);
-        deleteDirList(tempBugDirs);
-        STILVersion = tempSTILVersion;
-        strncpy(versionString, tempVersionString, 2*STIL_MAX_LINE_SIZE-1);
-        versionString[2*STIL_MAX_LINE_SIZE-1] = '\0';
-        return false;
-    }
-
-    if (bugFile.good()) {
-        if (getDirs(bugFile, tempBugDirs, false) != true) {
+    if (loadIndex(tempName, false, tempBugData) != true) {
+        error = buildIndex(tempName, false, tempBugData);
+        if (error == NO_STIL_ERROR) {
+            saveIndex(tempName, tempBugData);
+        } else {
 
-            // This is not a critical error - it is possible that the
-            // BUGlist.txt file has no entries in it at all (in fact, that's
-            // good!).
+            // This is not a critical error - some earlier versions of HVSC
+            // did not have a BUGlist.txt file at all, and it is possible
+            // that the BUGlist.txt file has no entries in it at all (in
+            // fact, that's good!).
 
-            CERR_STIL_DEBUG << "getDirs() failed for bugFile" << endl;
+            CERR_STIL_DEBUG << "setBaseDir() buildIndex() failed for " << tempName << endl;
             lastError = BUG_OPEN;
         }
     }
 
-    stilFile.close();
-    bugFile.close();
+    delete[] tempName;
 
     // Now we can copy the stuff into private data.
     // NOTE: At this point, STILVersion and the versionString should contain
@@ -258,26 +297,13 @@ STIL::setBaseDir(const char *pathToHVSC)
     baseDir[tempBaseDirLength] = '\0';
     baseDirLength = tempBaseDirLength;
 
-    // First, delete whatever may have been there previously.
-    deleteDirList(stilDirs);
-    deleteDirList(bugDirs);
-
-    stilDirs = createOneDir();
-    bugDirs = createOneDir();
-
-    // Now proceed with copy.
-
-    copyDirList(stilDirs, tempStilDirs);
-    copyDirList(bugDirs, tempBugDirs);
-
-    // Clear the buffers (caches).
-    memset((void *)entrybuf, 0, sizeof(entrybuf));
-    memset((void *)globalbuf, 0, sizeof(globalbuf));
-    memset((void *)bugbuf, 0, sizeof(bugbuf));
+    // Replace the previous contents.
+    freeIndexedFile(stilData);
+    freeIndexedFile(bugData);
+    stilData = tempStilData;
+    bugData = tempBugData;
 
     // Cleanup.
-    deleteDirList(tempStilDirs);
-    deleteDirList(tempBugDirs);
     delete[] tempBaseDir;
 
     CERR_STIL_DEBUG << "setBaseDir() succeeded" << endl;
@@ -285,11 +311,11 @@ STIL::setBaseDir(const char *pathToHVSC)
     return true;
 }
 
-char *
+const char *
 STIL::getAbsEntry(const char *absPathToEntry, int tuneNo, STILField field)
 {
     char *tempDir;
-    char *returnPtr;
+    const char *returnPtr;
     size_t tempDirLength;
 
     lastError = NO_STIL_ERROR;
@@ -321,7 +347,7 @@ STIL::getAbsEntry(const char *absPathToEntry, int tuneNo, STILField field)
     return returnPtr;
 }
 
-char *
+const char *
 STIL::getEntry(const char *relPathToEntry, int tuneNo, STILField field)
 {
     lastError = NO_STIL_ERROR;
@@ -350,69 +376,24 @@ STIL::getEntry(const char *relPathToEntry, int tuneNo, STILField field)
         field = all;
     }
 
-    // Find out whether we have this entry in the buffer.
+    const char *entry = findEntry(stilData, relPathToEntry, strlen(relPathToEntry));
 
-    if ((MYSTRNICMP(entrybuf, relPathToEntry, strlen(relPathToEntry)) != 0) ||
-        ((( (size_t) (strchr(entrybuf, '\n')-entrybuf)) != strlen(relPathToEntry))
-            && (STILVersion > 2.59))) {
-
-        // The relative pathnames don't match or they're not the same length:
-        // we don't have it in the buffer, so pull it in.
-
-        CERR_STIL_DEBUG << "getEntry(): entry not in buffer" << endl;
-
-        // Create the full path+filename
-        size_t tempNameLength = baseDirLength+strlen(PATH_TO_STIL);
-        char *tempName = new char [tempNameLength+1];
-        tempName[tempNameLength] = '\0';
-        strncpy(tempName, baseDir, tempNameLength);
-        strncat(tempName, PATH_TO_STIL, tempNameLength-baseDirLength);
-        convertSlashes(tempName);
-
-        stilFile.clear();
-        stilFile.open(tempName, STILopenFlags);
-
-        if (stilFile.fail()) {
-            stilFile.close();
-            CERR_STIL_DEBUG << "getEntry() open failed for stilFile" << endl;
-            lastError = STIL_OPEN;
-            delete[] tempName;
-            return NULL;
-        }
-
-        CERR_STIL_DEBUG << "getEntry() open succeeded for stilFile" << endl;
-
-        if (positionToEntry(relPathToEntry, stilFile, stilDirs) == false) {
-            // Copy the entry's name to the buffer.
-            strncpy(entrybuf, relPathToEntry, STIL_MAX_ENTRY_SIZE-1);
-            strncat(entrybuf, "\n", 2);
-            entrybuf[STIL_MAX_ENTRY_SIZE-1] = '\0';
-            CERR_STIL_DEBUG << "getEntry() posToEntry() failed" << endl;
-            lastError = NOT_IN_STIL;
-        } else {
-            *entrybuf= '\0';
-            readEntry(stilFile, entrybuf);
-            CERR_STIL_DEBUG << "getEntry() entry read" << endl;
-        }
-
-        stilFile.close();
-        delete[] tempName;
+    if (entry == NULL) {
+        CERR_STIL_DEBUG << "getEntry() findEntry() failed" << endl;
+        lastError = NOT_IN_STIL;
+        return NULL;
     }
 
     // Put the requested field into the result string.
 
-    if (getField(resultEntry, entrybuf, tuneNo, field) != true) {
-        return NULL;
-    } else {
-        return resultEntry;
-    }
+    return getField(resultEntry, entry, tuneNo, field);
 }
 
-char *
+const char *
 STIL::getAbsBug(const char *absPathToEntry, int tuneNo)
 {
     char *tempDir;
-    char *returnPtr;
+    const char *returnPtr;
     size_t tempDirLength;
 
     lastError = NO_STIL_ERROR;
@@ -444,15 +425,15 @@ STIL::getAbsBug(const char *absPathToEntry, int tuneNo)
     return returnPtr;
 }
 
-char *
+const char *
 STIL::getBug(const char *relPathToEntry, int tuneNo)
 {
     lastError = NO_STIL_ERROR;
 
     CERR_STIL_DEBUG << "getBug() called, relPath=" << relPathToEntry << ", rest=" << tuneNo << endl;
 
-    if (baseDir == NULL) {
-        CERR_STIL_DEBUG << "HVSC baseDir is not yet set!" << endl;
+    if ((baseDir == NULL) || (bugData.text == NULL)) {
+        CERR_STIL_DEBUG << "BUGlist.txt is not available!" << endl;
         lastError = BUG_OPEN;
         return NULL;
     }
@@ -463,71 +444,24 @@ STIL::getBug(const char *relPathToEntry, int tuneNo)
         tuneNo = 0;
     }
 
-    // Find out whether we have this bug entry in the buffer.
-    // If the baseDir was changed, we'll have to read it in again,
-    // even if it might be in the buffer already.
-
-    if ((MYSTRNICMP(bugbuf, relPathToEntry, strlen(relPathToEntry)) != 0) ||
-        ((( (size_t) (strchr(bugbuf, '\n')-bugbuf)) != strlen(relPathToEntry)) &&
-            (STILVersion > 2.59))) {
+    const char *entry = findEntry(bugData, relPathToEntry, strlen(relPathToEntry));
 
-        // The relative pathnames don't match or they're not the same length:
-        // we don't have it in the buffer, so pull it in.
-
-        CERR_STIL_DEBUG << "getBug(): entry not in buffer" << endl;
-
-        // Create the full path+filename
-        size_t tempNameLength = baseDirLength+strlen(PATH_TO_BUGLIST);
-        char *tempName = new char [tempNameLength+1];
-        tempName[tempNameLength] = '\0';
-        strncpy(tempName, baseDir, tempNameLength);
-        strncat(tempName, PATH_TO_BUGLIST, tempNameLength-baseDirLength);
-        convertSlashes(tempName);
-
-        bugFile.clear();
-        bugFile.open(tempName, STILopenFlags);
-
-        if (bugFile.fail()) {
-            bugFile.close();
-            CERR_STIL_DEBUG << "getBug() open failed for bugFile" << endl;
-            lastError = BUG_OPEN;
-            delete[] tempName;
-            return NULL;
-        }
-
-        CERR_STIL_DEBUG << "getBug() open succeeded for bugFile" << endl;
-
-        if (positionToEntry(relPathToEntry, bugFile, bugDirs) == false) {
-            // Copy the entry's name to the buffer.
-            strncpy(bugbuf, relPathToEntry, STIL_MAX_ENTRY_SIZE-1);
-            strcat(bugbuf, "\n");
-            bugbuf[STIL_MAX_ENTRY_SIZE-1] = '\0';
-            CERR_STIL_DEBUG << "getBug() posToEntry() failed" << endl;
-            lastError = NOT_IN_BUG;
-        } else {
-            *bugbuf = '\0';
-            readEntry(bugFile, bugbuf);
-            CERR_STIL_DEBUG << "getBug() entry read" << endl;
-        }
-
-        bugFile.close();
-        delete[] tempName;
+    if (entry == NULL) {
+        CERR_STIL_DEBUG << "getBug() findEntry() failed" << endl;
+        lastError = NOT_IN_BUG;
+        return NULL;
     }
 
     // Put the requested field into the result string.
 
-    if (getField(resultBug, bugbuf, tuneNo) != true) {
-        return NULL;
-    } else {
-        return resultBug;
-    }
+    return getField(resultBug, entry, tuneNo);
 }
 
-char *
+const char *
 STIL::getAbsGlobalComment(const char *absPathToEntry)
 {
     char *tempDir;
-    char *returnPtr;
+    const char *returnPtr;
     size_t tempDirLength;
 
     lastError = NO_STIL_ERROR;
@@ -559,13 +493,12 @@ STIL::getAbsGlobalComment(const char *absPathToEntry)
     return returnPtr;
 }
 
-char *
+const char *
 STIL::getGlobalComment(const char *relPathToEntry)
 {
-    char *dir;
     size_t pathLen;
-    char *temp;
-    char *lastSlash;
+    const char *temp;
+    const char *lastSlash;
 
     lastError = NO_STIL_ERROR;
 
@@ -579,7 +512,7 @@ STIL::getGlobalComment(const char *relPathToEntry)
 
     // Save the dirpath.
 
-    lastSlash = (char *)strrchr(relPathToEntry, '/');
+    lastSlash = strrchr(relPathToEntry, '/');
 
     if (lastSlash == NULL) {
         lastError = WRONG_DIR;
@@ -587,158 +520,269 @@ STIL::getGlobalComment(const char *relPathToEntry)
     }
 
     pathLen = lastSlash-relPathToEntry+1;
-    dir = new char [pathLen+1];
-    strncpy(dir, relPathToEntry, pathLen);
-    *(dir+pathLen) = '\0';
-
-    // Find out whether we have this global comment in the buffer.
-    // If the baseDir was changed, we'll have to read it in again,
-    // even if it might be in the buffer already.
-
-    if ((MYSTRNICMP(globalbuf, dir, pathLen) != 0) ||
-        ((( (size_t) (strchr(globalbuf, '\n')-globalbuf)) != pathLen) &&
-            (STILVersion > 2.59))) {
-
-        // The relative pathnames don't match or they're not the same length:
-        // we don't have it in the buffer, so pull it in.
-
-        CERR_STIL_DEBUG << "getGC(): entry not in buffer" << endl;
-
-        // Create the full path+filename
-        size_t tempNameLength = baseDirLength+strlen(PATH_TO_STIL);
-        char *tempName = new char [tempNameLength+1];
-        tempName[tempNameLength] = '\0';
-        strncpy(tempName, baseDir, tempNameLength);
-        strncat(tempName, PATH_TO_STIL, tempNameLength-baseDirLength);
-        convertSlashes(tempName);
-
-        stilFile.clear();
-        stilFile.open(tempName, STILopenFlags);
-
-        if (stilFile.fail()) {
-            stilFile.close();
-            CERR_STIL_DEBUG << "getGC() open failed for stilFile" << endl;
-            lastError = STIL_OPEN;
-            delete[] dir;
-            delete[] tempName;
-            return NULL;
-        }
 
-        if (positionToEntry(dir, stilFile, stilDirs) == false) {
-            // Copy the dirname to the buffer.
-            strncpy(globalbuf, dir, STIL_MAX_ENTRY_SIZE-1);
-            strcat(globalbuf, "\n");
-            globalbuf[STIL_MAX_ENTRY_SIZE-1] = '\0';
-            CERR_STIL_DEBUG << "getGC() posToEntry() failed" << endl;
-            lastError = NOT_IN_STIL;
-        } else {
-            *globalbuf = '\0';
-            readEntry(stilFile, globalbuf);
-            CERR_STIL_DEBUG << "getGC() entry read" << endl;
-        }
+    temp = findEntry(stilData, relPathToEntry, pathLen);
 
-        stilFile.close();
-        delete[] tempName;
+    if (temp == NULL) {
+        CERR_STIL_DEBUG << "getGC() findEntry() failed" << endl;
+        lastError = NOT_IN_STIL;
+        return NULL;
     }
 
-    CERR_STIL_DEBUG << "getGC() globalbuf=" << globalbuf << endl;
-    CERR_STIL_DEBUG << "-=END=-" << endl;
-
     // Position pointer to the global comment field.
 
-    temp = strchr(globalbuf, '\n');
-    temp++;
+    return getWholeEntry(temp);
+}
 
-    delete[] dir;
+const char *
+STIL::lookupEntry(const char *relPathToEntry, STILerror &error) const
+{
+    error = NO_STIL_ERROR;
 
-    // Check whether this is a NULL entry or not.
+    if (baseDir == NULL) {
+        error = STIL_OPEN;
+        return NULL;
+    }
 
-    if (*temp == '\0') {
+    // Fail if a section-global comment was asked for.
+
+    size_t pathLen = strlen(relPathToEntry);
+    if (*(relPathToEntry+pathLen-1) == '/') {
+        error = WRONG_ENTRY;
         return NULL;
-    } else {
-        return temp;
     }
+
+    const char *entry = findEntry(stilData, relPathToEntry, pathLen);
+
+    if (entry == NULL) {
+        error = NOT_IN_STIL;
+        return NULL;
+    }
+
+    return getWholeEntry(entry);
 }
 
-//////// PRIVATE
+const char *
+STIL::lookupGlobalComment(const char *relPathToEntry, STILerror &error) const
+{
+    error = NO_STIL_ERROR;
 
-bool
-STIL::determineEOL()
+    if (baseDir == NULL) {
+        error = STIL_OPEN;
+        return NULL;
+    }
+
+    const char *lastSlash = strrchr(relPathToEntry, '/');
+
+    if (lastSlash == NULL) {
+        error = WRONG_DIR;
+        return NULL;
+    }
+
+    const char *entry = findEntry(stilData, relPathToEntry, lastSlash-relPathToEntry+1);
+
+    if (entry == NULL) {
+        error = NOT_IN_STIL;
+        return NULL;
+    }
+
+    return getWholeEntry(entry);
+}
+
+const char *
+STIL::lookupBug(const char *relPathToEntry, STILerror &error) const
 {
-    char line[STIL_MAX_LINE_SIZE+5];
-    int i=0;
+    error = NO_STIL_ERROR;
+
+    if ((baseDir == NULL) || (bugData.text == NULL)) {
+        error = BUG_OPEN;
+        return NULL;
+    }
 
-    CERR_STIL_DEBUG << "detEOL() called" << endl;
+    const char *entry = findEntry(bugData, relPathToEntry, strlen(relPathToEntry));
 
-    if (stilFile.fail()) {
-        CERR_STIL_DEBUG << "detEOL() open failed" << endl;
-        return false;
+    if (entry == NULL) {
+        error = NOT_IN_BUG;
+        return NULL;
     }
 
-    stilFile.seekg(0);
+    return getWholeEntry(entry);
+}
 
-    // Read in the first line from stilFile to determine what the
-    // EOL character is (it can be different from OS to OS).
+//////// PRIVATE
 
-    stilFile.read(line, sizeof(line)-1);
-    line[sizeof(line)-1] = '\0';
+bool
+STIL::loadIndex(const char *fileName, bool isSTILFile, indexedFile &data)
+{
+    struct stat fileStat;
+    struct stat indexStat;
+    string indexName = string(fileName)+INDEX_SUFFIX;
 
-    CERR_STIL_DEBUG << "detEOL() line=" << line << endl;
+    if ((stat(fileName, &fileStat) != 0) || (stat(indexName.c_str(), &indexStat) != 0)) {
+        return false;
+    }
 
-    // Now find out what the EOL char is (or are).
+    size_t imageSize = (size_t) indexStat.st_size;
+    if (imageSize < sizeof(IndexHeader)) {
+        return false;
+    }
 
-    STIL_EOL = '\0';
-    STIL_EOL2 = '\0';
+    FILE *fp = fopen(indexName.c_str(), "rb");
+    if (fp == NULL) {
+        return false;
+    }
 
-    while (line[i] != '\0') {
-        if ((line[i] == 0x0d) || (line[i] == 0x0a)) {
-            if (STIL_EOL == '\0') {
-                STIL_EOL = line[i];
-            } else {
-                if (line[i] != STIL_EOL) {
-                    STIL_EOL2 = line[i];
-                }
-            }
-        }
-        i++;
+    // Check the header before mapping the whole file. The index of
+    // BUGlist.txt depends on the version of STIL.txt.
+
+    IndexHeader header;
+    bool valid = (fread(&header, sizeof(header), 1, fp) == 1) &&
+        (memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0) &&
+        (header.byteOrder == INDEX_BYTE_ORDER) &&
+        (header.bucketCount > 0) &&
+        ((header.bucketCount & (header.bucketCount-1)) == 0) &&
+        (header.fileSize == (uint64_t) fileStat.st_size) &&
+        (header.fileTime == (int64_t) fileStat.st_mtime) &&
+        (isSTILFile || (header.stilVersion == STILVersion)) &&
+        (header.bucketCount <= imageSize/sizeof(indexBucket)) &&
+        (imageSize == sizeof(IndexHeader)+header.bucketCount*sizeof(indexBucket)+header.textLength+1);
+
+    if (!valid) {
+        fclose(fp);
+        CERR_STIL_DEBUG << "loadIndex() no valid index for " << fileName << endl;
+        return false;
     }
 
-    if (STIL_EOL == '\0') {
-        // Something is wrong - no EOL-like char was found.
-        CERR_STIL_DEBUG << "detEOL() no EOL found" << endl;
+#ifdef STIL_USE_MMAP
+    void *image = mmap(NULL, imageSize, PROT_READ, MAP_SHARED, fileno(fp), 0);
+    fclose(fp);
+    if (image == MAP_FAILED) {
+        return false;
+    }
+    data.image = (char *) image;
+    data.imageMapped = true;
+#else
+    data.image = new char [imageSize];
+    rewind(fp);
+    valid = (fread(data.image, imageSize, 1, fp) == 1);
+    fclose(fp);
+    if (!valid) {
+        delete[] data.image;
+        data.image = NULL;
         return false;
     }
+    data.imageMapped = false;
+#endif
+    data.imageSize = imageSize;
 
-    CERR_STIL_DEBUG << "detEOL() EOL1=0x" << hex << (int) STIL_EOL << " EOL2=0x" << hex << (int) STIL_EOL2 << dec << endl;
+    if (data.image[imageSize-1] != '\0') {
+        freeIndexedFile(data);
+        return false;
+    }
+
+    data.buckets = (const indexBucket *) (data.image+sizeof(IndexHeader));
+    data.bucketCount = header.bucketCount;
+    data.text = (const char *) (data.buckets+header.bucketCount);
+    data.textLength = header.textLength;
+
+    if (isSTILFile) {
+        STILVersion = header.stilVersion;
+    }
+
+    CERR_STIL_DEBUG << "loadIndex() loaded index for " << fileName << endl;
 
     return true;
 }
 
-bool
-STIL::getDirs(ifstream& inFile, dirList *dirs, bool isSTILFile)
+STIL::STILerror
+STIL::buildIndex(const char *fileName, bool isSTILFile, indexedFile &data)
 {
-    char line[STIL_MAX_LINE_SIZE];
-    int i=0;
-    size_t j;
-    bool newDir;
-    dirList *prevDir;
+    struct stat fileStat;
+
+    CERR_STIL_DEBUG << "buildIndex() called for " << fileName << endl;
+
+    ifstream inFile(fileName, STILopenFlags);
+
+    if (inFile.fail() || (stat(fileName, &fileStat) != 0) ||
+        ((uint_least64_t) fileStat.st_size >= 0xffffffffU)) {
+        CERR_STIL_DEBUG << "buildIndex() open failed for " << fileName << endl;
+        return STIL_OPEN;
+    }
+
+    size_t fileSize = (size_t) fileStat.st_size;
+    char *text = new char [fileSize+1];
+    inFile.read(text, fileSize);
+
+    if ((size_t) inFile.gcount() != fileSize) {
+        delete[] text;
+        return STIL_OPEN;
+    }
+
+    text[fileSize] = '\0';
+    inFile.close();
 
     if (isSTILFile) {
-        newDir = false;
-    } else {
-        newDir = true;
+
+        // The first line of STIL.txt has to end within the size of a line.
+
+        size_t eolSearchLength = min(fileSize, (size_t) STIL_MAX_LINE_SIZE+4);
+        if ((memchr(text, 0x0d, eolSearchLength) == NULL) &&
+            (memchr(text, 0x0a, eolSearchLength) == NULL)) {
+            CERR_STIL_DEBUG << "buildIndex() no EOL found" << endl;
+            delete[] text;
+            return NO_EOL;
+        }
     }
 
-    prevDir = dirs;
+    char *readPtr = text;
+    char *writePtr = text;
+    char *textEnd = text+fileSize;
+
+    // Split the text into lines. Any of CR, LF, CR+LF and LF+CR ends a line,
+    // which is how the EOL chars were eaten up when reading line by line.
+
+    while (readPtr < textEnd) {
+        char *lineStart = writePtr;
+
+        while ((readPtr < textEnd) && (*readPtr != 0x0d) && (*readPtr != 0x0a)) {
+            *writePtr++ = *readPtr++;
+        }
+
+        if (readPtr < textEnd) {
+            char eol = *readPtr++;
+            if ((readPtr < textEnd) && (*readPtr != eol) &&
+                ((*readPtr == 0x0d) || (*readPtr == 0x0a))) {
+                readPtr++;
+            }
+        }
+
+        // An empty line terminates an entry.
+        if (writePtr == lineStart) {
+            *writePtr++ = '\0';
+        } else {
+            *writePtr++ = '\n';
+        }
+    }
 
-    CERR_STIL_DEBUG << "getDirs() called" << endl;
+    *writePtr = '\0';
+    size_t textLength = writePtr-text;
+    textEnd = writePtr;
 
-    inFile.seekg(0);
+    // Find the sections (subdirs) just like reading the file line by line
+    // would, and extract the version number of STIL.
 
-    while (inFile.good()) {
-        getStilLine(inFile, line);
+    vector<char *> sections;
+    vector<size_t> sectionDirLengths;
+    char *prevDir = NULL;
+    size_t prevDirLength = 0;
+    bool newDir = !isSTILFile;
+    char *line;
+    char *nextLine;
+    size_t lineLength;
 
-        if (!isSTILFile) CERR_STIL_DEBUG << line << '\n';
+    for (line = text; line < textEnd; line = nextLine) {
+        lineLength = strcspn(line, "\n");
+        nextLine = line+lineLength+1;
 
         // Try to extract STIL's version number if it's not done, yet.
 
@@ -748,17 +792,7 @@ STIL::getDirs(ifstream& inFile, dirList *dirs, bool isSTILFile)
                 // Get the version number
                 STILVersion = atof(line+9);
 
-                // Put it into the string, too.
-#ifdef HAVE_SNPRINTF
-                snprintf(line, STIL_MAX_LINE_SIZE-1, "SID Tune Information List (STIL) v%4.2f\n", STILVersion);
-#else
-                sprintf(line, "SID Tune Information List (STIL) v%4.2f\n", STILVersion);
-#endif
-                line[STIL_MAX_LINE_SIZE-1] = '\0';
-                strncat(versionString, line, 2*STIL_MAX_LINE_SIZE-1);
-                versionString[2*STIL_MAX_LINE_SIZE-1] = '\0';
-
-                CERR_STIL_DEBUG << "getDirs() STILVersion=" << STILVersion << endl;
+                CERR_STIL_DEBUG << "buildIndex() STILVersion=" << STILVersion << endl;
 
                 continue;
             }
@@ -774,186 +808,241 @@ STIL::getDirs(ifstream& inFile, dirList *dirs, bool isSTILFile)
         // Is this the start of an entry immediately following a dir separator?
 
         if (newDir && (*line == '/')) {
-
-            // Get the directory only
-            j = strrchr(line,'/')-line+1;
-
-            if (!isSTILFile) {
-                // Compare it to the last stored dirname
-                if (i==0) {
-                    newDir = true;
-                } else if (MYSTRNICMP(prevDir->dirName, line, j) != 0) {
-                    newDir = true;
-                } else {
-                    newDir = false;
+            size_t dirLength = 0;
+            for (size_t i = 0; i < lineLength; i++) {
+                if (line[i] == '/') {
+                    dirLength = i+1;
                 }
             }
 
-            // Store the info
-            if (newDir) {
+            // In BUGlist.txt every change of dir starts a new section.
+            if (isSTILFile || (prevDir == NULL) || (dirLength > prevDirLength) ||
+                (MYSTRNICMP(prevDir, line, dirLength) != 0)) {
+                sections.push_back(line);
+                sectionDirLengths.push_back(dirLength);
+                prevDir = line;
+                prevDirLength = dirLength;
+            }
+
+            newDir = !isSTILFile;
+        }
+    }
 
-                dirs->dirName = new char [j+1];
-                strncpy(dirs->dirName, line, j);
-                *((dirs->dirName)+j) = '\0';
+    // Collect the entries of every section. Only the first section of a dir
+    // is searched, up to the first entry of another dir. Older versions of
+    // STIL may have the tune designation on the first line of an entry
+    // together with the pathname, so the pathname ends at the first blank.
 
-                dirs->position = inFile.tellg()-(streampos)strlen(line)-1L;
+    vector<indexBucket> entries;
+    set<string> dirsSeen;
 
-                CERR_STIL_DEBUG << "getDirs() i=" << i << ", dirName=" << dirs->dirName << ", pos=" << dirs->position <<  endl;
+    for (size_t i = 0; i < sections.size(); i++) {
+        char *dir = sections[i];
+        size_t dirLength = sectionDirLengths[i];
 
-                prevDir = dirs;
+        if (!dirsSeen.insert(toLowerString(dir, dirLength)).second) {
+            continue;
+        }
 
-                // We create the entries one ahead. This way we also assure that
-                // the last entry will always be a NULL (empty) entry.
-                dirs->next = createOneDir();
-                dirs = dirs->next;
+        for (line = dir; line < textEnd; line = nextLine) {
+            lineLength = strcspn(line, "\n");
+            nextLine = line+lineLength+1;
 
-                i++;
+            // Check if it is the start of an entry
+
+            if (*line != '/') {
+                continue;
             }
 
-            if (isSTILFile) {
-                newDir = false;
-            } else {
-                newDir = true;
+            if (MYSTRNICMP(dir, line, dirLength) != 0) {
+                // We are outside the section.
+                break;
             }
-        }
-    }
 
-    if (i == 0) {
-        // No entries found - something is wrong.
-        // NOTE: It's perfectly valid to have a BUGlist.txt file with no
-        // entries in it!
-        CERR_STIL_DEBUG << "getDirs() no dirs found" << endl;
-        return false;
-    }
+            size_t keyLength = lineLength;
+            if (STILVersion <= 2.59) {
+                keyLength = strcspn(line, " \t\n");
+            }
 
-    CERR_STIL_DEBUG << "getDirs() successful" << endl;
+            size_t keyDirLength = 0;
+            for (size_t j = 0; j < keyLength; j++) {
+                if (line[j] == '/') {
+                    keyDirLength = j+1;
+                }
+            }
 
-    return true;
-}
+            if (keyDirLength == dirLength) {
+                indexBucket entry;
+                entry.hash = hashPath(line, keyLength);
+                entry.offset = (uint32_t) (line-text);
+                entry.keyLength = (uint32_t) keyLength;
+                entries.push_back(entry);
+            }
+        }
+    }
 
-bool
-STIL::positionToEntry(const char *entryStr, ifstream& inFile, dirList *dirs)
-{
-    size_t pathLen;
-    size_t entryStrLen;
-    char line[STIL_MAX_LINE_SIZE];
-    int temp;
-    bool foundIt = false;
-    bool globComm = false;
-    char *chrptr;
+    // Put the entries into the hash table. When an entry occurs more than
+    // once, the first one is used.
 
-    CERR_STIL_DEBUG << "pos2Entry() called, entryStr=" << entryStr << endl;
+    uint32_t bucketCount = 1;
+    while (bucketCount < 2*entries.size()) {
+        bucketCount *= 2;
+    }
 
-    inFile.seekg(0);
+    data.imageSize = sizeof(IndexHeader)+bucketCount*sizeof(indexBucket)+textLength+1;
+    data.image = new char [data.imageSize];
+    data.imageMapped = false;
+    memset(data.image, 0, data.imageSize);
 
-    // Get the dirpath.
+    IndexHeader *header = (IndexHeader *) data.image;
+    indexBucket *buckets = (indexBucket *) (data.image+sizeof(IndexHeader));
 
-    chrptr = strrchr((char *)entryStr, '/');
+    for (size_t i = 0; i < entries.size(); i++) {
+        const indexBucket &entry = entries[i];
+        uint32_t index = entry.hash & (bucketCount-1);
 
-    // If no slash was found, something is screwed up in the entryStr.
+        while (buckets[index].keyLength != 0) {
+            const indexBucket &bucket = buckets[index];
+            if ((bucket.hash == entry.hash) && (bucket.keyLength == entry.keyLength) &&
+                (MYSTRNICMP(text+bucket.offset, text+entry.offset, entry.keyLength) == 0)) {
+                break;
+            }
+            index = (index+1) & (bucketCount-1);
+        }
 
-    if (chrptr == NULL) {
-        return false;
+        if (buckets[index].keyLength == 0) {
+            buckets[index] = entry;
+        }
     }
 
-    pathLen = chrptr-entryStr+1;
+    memcpy(header->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header->byteOrder = INDEX_BYTE_ORDER;
+    header->bucketCount = bucketCount;
+    header->textLength = (uint32_t) textLength;
+    header->stilVersion = STILVersion;
+    header->fileSize = (uint64_t) fileStat.st_size;
+    header->fileTime = (int64_t) fileStat.st_mtime;
 
-    // Determine whether a section-global comment is asked for.
+    char *indexText = (char *) (buckets+bucketCount);
+    memcpy(indexText, text, textLength+1);
+    delete[] text;
 
-    entryStrLen = strlen(entryStr);
-    if (pathLen == entryStrLen) {
-        globComm = true;
+    data.buckets = buckets;
+    data.bucketCount = bucketCount;
+    data.text = indexText;
+    data.textLength = textLength;
+
+    CERR_STIL_DEBUG << "buildIndex() indexed " << entries.size() << " entries in " << sections.size() << " sections" << endl;
+
+    if (sections.empty()) {
+        // No entries found - something is wrong.
+        // NOTE: It's perfectly valid to have a BUGlist.txt file with no
+        // entries in it!
+        CERR_STIL_DEBUG << "buildIndex() no dirs found" << endl;
+        return NO_STIL_DIRS;
     }
 
-    // Find it in the table.
+    return NO_STIL_ERROR;
+}
 
-    while (dirs->dirName) {
-        if ((MYSTRNICMP(dirs->dirName, entryStr, pathLen) == 0) &&
-            (strlen(dirs->dirName) == pathLen)) {
-            CERR_STIL_DEBUG << "pos2Entry() found dir, dirName=" << dirs->dirName << endl;
-            foundIt = true;
-            break;
+void
+STIL::saveIndex(const char *fileName, const indexedFile &data)
+{
+    // Write to a temporary file first so that other processes never see a
+    // partially written index. Failures are not fatal, e.g. the directory
+    // of a shared HVSC copy may be read-only.
+
+    string indexName = string(fileName)+INDEX_SUFFIX;
+    char tmpSuffix[32];
+#ifdef HAVE_UNISTD_H
+    sprintf(tmpSuffix, ".%ld", (long) getpid());
+#else
+    strcpy(tmpSuffix, ".tmp");
+#endif
+    string tmpName = indexName+tmpSuffix;
+
+    FILE *fp = fopen(tmpName.c_str(), "wb");
+    if (fp != NULL) {
+        bool ok = (fwrite(data.image, data.imageSize, 1, fp) == 1);
+        ok = (fclose(fp) == 0) && ok;
+        if (!ok || (rename(tmpName.c_str(), indexName.c_str()) != 0)) {
+            remove(tmpName.c_str());
+            CERR_STIL_DEBUG << "saveIndex() could not write " << indexName << endl;
         }
-        dirs = dirs->next;
     }
+}
 
-    if (!foundIt) {
-        // The directory was not found.
-        CERR_STIL_DEBUG << "pos2Entry() did not find the dir" << endl;
-        return false;
-    }
+const char *
+STIL::findEntry(const indexedFile &data, const char *entryStr, size_t entryStrLen) const
+{
+    CERR_STIL_DEBUG << "findEntry() called, entryStr=" << entryStr << endl;
+
+    // If no slash was found, something is screwed up in the entryStr.
 
-    // Jump to the first entry of this section.
-    inFile.seekg(dirs->position);
-    foundIt = false;
+    if ((data.bucketCount == 0) || (memchr(entryStr, '/', entryStrLen) == NULL)) {
+        return NULL;
+    }
 
-    // Now find the desired entry
+    uint32_t hash = hashPath(entryStr, entryStrLen);
+    uint32_t index = hash & (data.bucketCount-1);
 
-    do {
-        getStilLine(inFile, line);
-        if (inFile.eof()) {
+    for (uint32_t probes = 0; probes < data.bucketCount; probes++) {
+        const indexBucket &bucket = data.buckets[index];
+        if (bucket.keyLength == 0) {
             break;
         }
+        if ((bucket.hash == hash) && (bucket.keyLength == entryStrLen) &&
+            (bucket.keyLength <= data.textLength) &&
+            (bucket.offset <= data.textLength-bucket.keyLength) &&
+            (MYSTRNICMP(data.text+bucket.offset, entryStr, entryStrLen) == 0)) {
+            CERR_STIL_DEBUG << "findEntry() entry found" << endl;
+            return data.text+bucket.offset;
+        }
+        index = (index+1) & (data.bucketCount-1);
+    }
 
-        // Check if it is the start of an entry
-
-        if (*line == '/') {
-
-            if (MYSTRNICMP(dirs->dirName, line, pathLen) != 0) {
-                // We are outside the section - get out of the loop,
-                // which will fail the search.
-                break;
-            }
-
-            // Check whether we need to find a section-global comment or
-            // a specific entry.
-
-            if (globComm || (STILVersion > 2.59)) {
-                temp = MYSTRICMP(line, entryStr);
-            } else {
-                // To be compatible with older versions of STIL, which may have
-                // the tune designation on the first line of a STIL entry
-                // together with the pathname.
-                temp = MYSTRNICMP(line, entryStr, entryStrLen);
-            }
+    CERR_STIL_DEBUG << "findEntry() entry not found" << endl;
+    return NULL;
+}
 
-            CERR_STIL_DEBUG << "pos2Entry() line=" << line << endl;
+const char *
+STIL::getWholeEntry(const char *entry)
+{
+    // Position pointer to the first char beyond the file designation.
 
-            if (temp == 0) {
-                // Found it!
-                foundIt = true;
-            }
+    const char *start = strchr(entry, '\n');
+    start++;
 
-        }
-    } while (!foundIt);
+    // Check whether this is a NULL entry or not.
 
-    if (foundIt) {
-        // Reposition the file pointer back to the start of the entry.
-        inFile.seekg(inFile.tellg()-(streampos)strlen(line)-1L);
-        CERR_STIL_DEBUG << "pos2Entry() entry found" << endl;
-        return true;
-    } else {
-        CERR_STIL_DEBUG << "pos2Entry() entry not found" << endl;
-        return false;
+    if (*start == '\0') {
+        return NULL;
     }
+    return start;
 }
 
 void
-STIL::readEntry(ifstream& inFile, char *buffer)
+STIL::freeIndexedFile(indexedFile &data)
 {
-    char line[STIL_MAX_LINE_SIZE];
-
-    do {
-        getStilLine(inFile, line);
-        strcat(buffer, line);
-        if (*line != '\0') {
-            strncat(buffer, "\n", 2);
-        }
-    } while (*line != '\0');
+    if (data.image != NULL) {
+#ifdef STIL_USE_MMAP
+        if (data.imageMapped) {
+            munmap(data.image, data.imageSize);
+        } else
+#endif
+            delete[] data.image;
+    }
+    data.image = NULL;
+    data.imageSize = 0;
+    data.imageMapped = false;
+    data.buckets = NULL;
+    data.bucketCount = 0;
+    data.text = NULL;
+    data.textLength = 0;
 }
 
-bool
-STIL::getField(char *result, char *buffer, int tuneNo, STILField field)
+const char *
+STIL::getField(char *result, const char *buffer, int tuneNo, STILField field)
 {
     CERR_STIL_DEBUG << "getField() called, buffer=" << buffer << ", rest=" << tuneNo << "," << field << endl;
 
@@ -962,18 +1051,18 @@ STIL::getField(char *result, char *buffer, int tuneNo, STILField field)
 
     // Position pointer to the first char beyond the file designation.
 
-    char *start = strchr(buffer, '\n');
+    const char *start = strchr(buffer, '\n');
     start++;
 
     // Check whether this is a NULL entry or not.
 
     if (*start == '\0') {
         CERR_STIL_DEBUG << "getField() null entry" << endl;
-        return false;
+        return NULL;
     }
 
     // Is this a multitune entry?
-    char *firstTuneNo = strstr(start, "(#");
+    const char *firstTuneNo = strstr(start, "(#");
 
     // This is a tune designation only if the previous char was
     // a newline (ie. if the "(#" is on the beginning of a line).
@@ -989,8 +1078,8 @@ STIL::getField(char *result, char *buffer, int tuneNo, STILField field)
 
         // Is the first thing in this STIL entry the COMMENT?
 
-        char *temp = strstr(start, _COMMENT_STR);
-        char *temp2 = NULL;
+        const char *temp = strstr(start, _COMMENT_STR);
+        const char *temp2 = NULL;
 
         // Search for other potential fields beyond the COMMENT.
         if (temp == start) {
@@ -1016,30 +1105,32 @@ STIL::getField(char *result, char *buffer, int tuneNo, STILField field)
 
                 // Simply copy the stuff in.
 
-                strncpy(result, start, STIL_MAX_ENTRY_SIZE-1);
-                result[STIL_MAX_ENTRY_SIZE-1] = '\0';
-                CERR_STIL_DEBUG << "getField() copied to resultbuf" << endl;
-                return true;
+                CERR_STIL_DEBUG << "getField() returning the whole entry" << endl;
+                return start;
             } else if ((tuneNo == 0) && (field == comment)) {
 
                 // Copy just the comment.
 
-                strncpy(result, start, temp2-start);
-                *(result+(temp2-start)) = '\0';
+                size_t length = temp2-start;
+                if (length > STIL_MAX_ENTRY_SIZE-1) {
+                    length = STIL_MAX_ENTRY_SIZE-1;
+                }
+                strncpy(result, start, length);
+                *(result+length) = '\0';
                 CERR_STIL_DEBUG << "getField() copied to just the COMMENT to resultbuf" << endl;
-                return true;
+                return result;
             } else if ((tuneNo == 1) && (temp2 != NULL)) {
 
                // A specific field was asked for.
 
                 CERR_STIL_DEBUG << "getField() copying COMMENT to resultbuf" << endl;
-                return getOneField(result, temp2, temp2+strlen(temp2), field);
+                return getOneField(result, temp2, temp2+strlen(temp2), field) ? result : NULL;
             } else {
 
                 // Anything else is invalid as of v2.00.
 
                 CERR_STIL_DEBUG << "getField() invalid parameter combo: single tune, tuneNo=" << tuneNo << ", field=" << field << endl;
-                return false;
+                return NULL;
             }
         } else {
 
@@ -1051,22 +1142,20 @@ STIL::getField(char *result, char *buffer, int tuneNo, STILField field)
 
                 // The complete entry was asked for. Simply copy the stuff in.
 
-                strncpy(result, start, STIL_MAX_ENTRY_SIZE-1);
-                result[STIL_MAX_ENTRY_SIZE-1] = '\0';
-                CERR_STIL_DEBUG << "getField() copied to resultbuf" << endl;
-                return true;
+                CERR_STIL_DEBUG << "getField() returning the whole entry" << endl;
+                return start;
             } else if (tuneNo == 1) {
 
                // A specific field was asked for.
 
                 CERR_STIL_DEBUG << "getField() copying COMMENT to resultbuf" << endl;
-                return getOneField(result, start, start+strlen(start), field);
+                return getOneField(result, start, start+strlen(start), field) ? result : NULL;
             } else {
 
                 // Anything else is invalid as of v2.00.
 
                 CERR_STIL_DEBUG << "getField() invalid parameter combo: single tune, tuneNo=" << tuneNo << ", field=" << field << endl;
-                return false;
+                return NULL;
             }
         }
     } else {
@@ -1087,10 +1176,8 @@ STIL::getField(char *result, char *buffer, int tuneNo, STILField field)
 
                     // Yes. Simply copy the stuff in.
 
-                    strncpy(result, start, STIL_MAX_ENTRY_SIZE-1);
-                    result[STIL_MAX_ENTRY_SIZE-1] = '\0';
-                    CERR_STIL_DEBUG << "getField() copied all to resultbuf" << endl;
-                    return true;
+                    CERR_STIL_DEBUG << "getField() returning the whole entry" << endl;
+                    return start;
                     break;
 
                 case comment:
@@ -1099,10 +1186,10 @@ STIL::getField(char *result, char *buffer, int tuneNo, STILField field)
 
                     if (firstTuneNo != start) {
                         CERR_STIL_DEBUG << "getField() copying file-global comment to resultbuf" << endl;
-                        return getOneField(result, start, firstTuneNo, comment);
+                        return getOneField(result, start, firstTuneNo, comment) ? result : NULL;
                     } else {
                         CERR_STIL_DEBUG << "getField() no file-global comment" << endl;
-                        return false;
+                        return NULL;
                     }
                     break;
 
@@ -1112,12 +1199,12 @@ STIL::getField(char *result, char *buffer, int tuneNo, STILField field)
                     // asked for tuneNo=0, this is illegal.
 
                     CERR_STIL_DEBUG << "getField() invalid parameter combo: multitune, tuneNo=" << tuneNo << ", field=" << field << endl;
-                    return false;
+                    return NULL;
                     break;
             }
         }
 
-        char *myTuneNo;
+        const char *myTuneNo;
         char tuneNoStr[8];
 
         // Search for the requested tune number.
@@ -1138,7 +1225,7 @@ STIL::getField(char *result, char *buffer, int tuneNo, STILField field)
 
             // Where is the next one?
 
-            char *nextTuneNo = strstr(myTuneNo, "\n(#");
+            const char *nextTuneNo = strstr(myTuneNo, "\n(#");
             if (nextTuneNo == NULL) {
                 // There is no next one - set pointer to end of entry.
                 nextTuneNo = start+strlen(start);
@@ -1150,18 +1237,19 @@ STIL::getField(char *result, char *buffer, int tuneNo, STILField field)
             // Put the desired fields into the result (which may be 'all').
 
             CERR_STIL_DEBUG << "getField() myTuneNo=" << myTuneNo << ", nextTuneNo=" << nextTuneNo << endl;
-            return getOneField(result+strlen(result), myTuneNo, nextTuneNo, field);
+            return getOneField(result+strlen(result), myTuneNo, nextTuneNo, field) ? result : NULL;
         } else {
             CERR_STIL_DEBUG << "getField() nothing found" << endl;
-            return false;
+            return NULL;
         }
     }
 }
 
 bool
-STIL::getOneField(char *result, char *start, char *end, STILField field)
+STIL::getOneField(char *result, const char *start, const char *end, STILField field)
 {
-    char *temp = NULL;
+    const char *temp = NULL;
+    size_t room = STIL_MAX_ENTRY_SIZE-1-strlen(result);
 
     // Sanity checking
 
@@ -1177,7 +1265,7 @@ STIL::getOneField(char *result, char *start, char *end, STILField field)
 
         case all:
 
-            strncat(result, start, end-start);
+            strncat(result, start, min((size_t) (end-start), room));
             return true;
             break;
 
@@ -1222,7 +1310,7 @@ STIL::getOneField(char *result, char *start, char *end, STILField field)
     // Search for the end of this field. This is done by finding
     // where the next field starts.
 
-    char *nextName, *nextAuthor, *nextTitle, *nextArtist, *nextComment, *nextField;
+    const char *nextName, *nextAuthor, *nextTitle, *nextArtist, *nextComment, *nextField;
 
     nextName = strstr(temp+1, _NAME_STR);
     nextAuthor = strstr(temp+1, _AUTHOR_STR);
@@ -1288,77 +1376,8 @@ STIL::getOneField(char *result, char *start, char *end, STILField field)
     // Now nextField points to the last+1 char that should be copied to
     // result. Do that.
 
-    strncat(result, temp, nextField-temp);
+    strncat(result, temp, min((size_t) (nextField-temp), room));
     return true;
 }
 
-void
-STIL::getStilLine(ifstream& infile, char *line)
-{
-    if (STIL_EOL2 != '\0') {
-
-        // If there was a remaining EOL char from the previous read, eat it up.
-
-        char temp = infile.peek();
-
-        if ((temp == 0x0d) || (temp == 0x0a)) {
-            infile.get(temp);
-        }
-    }
-
-    infile.getline(line, STIL_MAX_LINE_SIZE, STIL_EOL);
-}
-
-void
-STIL::deleteDirList(dirList *dirs)
-{
-    dirList *ptr;
-
-    do {
-        ptr = dirs->next;
-        if (dirs->dirName) {
-            delete[] dirs->dirName;
-        }
-        delete dirs;
-        dirs = ptr;
-    } while (ptr);
-}
-
-void
-STIL::copyDirList(dirList *toPtr, dirList *fromPtr)
-{
-    while ((fromPtr != NULL) && (toPtr !=NULL)) {
-        toPtr->position = fromPtr->position;
-
-        if (fromPtr->dirName) {
-            toPtr->dirName = new char [strlen(fromPtr->dirName)+1];
-            strcpy(toPtr->dirName, fromPtr->dirName);
-        } else {
-            toPtr->dirName = NULL;
-        }
-
-        if (fromPtr->next) {
-            toPtr->next = createOneDir();
-        } else {
-            toPtr->next = NULL;
-        }
-
-        fromPtr = fromPtr->next;
-        toPtr = toPtr->next;
-    }
-}
-
-STIL::dirList *
-STIL::createOneDir(void)
-{
-    dirList *ptr;
-
-    ptr = new dirList;
-    ptr->dirName = NULL;
-    ptr->position = 0;
-    ptr->next = NULL;
-
-    return ptr;
-}
-
 #endif // _STIL
@@ -16,8 +16,8 @@
 #ifndef _STIL_H
 #define _STIL_H
 
-#include <fstream>
 #include <cstdlib>     // For atof() and size_t
+#include <stdint.h>
 #include "stilcomm.h"
 
 class STIL {
@@ -161,12 +161,12 @@ class STIL {
         //               (It's kinda dangerous to return a pointer that points
         //               to an internal structure, but I trust you. :)
         //
-        char *getEntry(const char *relPathToEntry, int tuneNo=0, STILField field=all);
+        const char *getEntry(const char *relPathToEntry, int tuneNo=0, STILField field=all);
 
         // Same as above, but with an absolute path given
         // given in your machine's format.
         //
-        char *getAbsEntry(const char *absPathToEntry, int tuneNo=0, STILField field=all);
+        const char *getAbsEntry(const char *absPathToEntry, int tuneNo=0, STILField field=all);
 
         //
         // getGlobalComment()
@@ -186,12 +186,12 @@ class STIL {
         //               (It's kinda dangerous to return a pointer that points
         //               to an internal structure, but I trust you. :)
         //
-        char *getGlobalComment(const char *relPathToEntry);
+        const char *getGlobalComment(const char *relPathToEntry);
 
         // Same as above, but with an absolute path
         // given in your machine's format.
         //
-        char *getAbsGlobalComment(const char *absPathToEntry);
+        const char *getAbsGlobalComment(const char *absPathToEntry);
 
         //
         // getBug()
@@ -217,12 +217,33 @@ class STIL {
         //               (It's kinda dangerous to return a pointer that points
         //               to an internal structure, but I trust you. :)
         //
-        char *getBug(const char *relPathToEntry, int tuneNo=0);
+        const char *getBug(const char *relPathToEntry, int tuneNo=0);
 
         // Same as above, but with an absolute path
         // given in your machine's format.
         //
-        char *getAbsBug(const char *absPathToEntry, int tuneNo=0);
+        const char *getAbsBug(const char *absPathToEntry, int tuneNo=0);
+
+        //
+        // lookupEntry(), lookupGlobalComment(), lookupBug()
+        //
+        // FUNCTION: Same as getEntry() with tuneNo=0 and field=all,
+        //           getGlobalComment() and getBug() with tuneNo=0, but they
+        //           do not change the object, so that several threads may
+        //           look up entries at the same time once setBaseDir() has
+        //           returned.
+        // ARGUMENTS:
+        //      relPathToEntry = relative to the HVSC base dir, starting with
+        //                       a slash
+        //      error          = where to put the error that getError()
+        //                       would return
+        // RETURNS:
+        //      NULL - if there's absolutely no entry for the tune
+        //      char * - pointer into the STIL.txt or BUGlist.txt text
+        //
+        const char *lookupEntry(const char *relPathToEntry, STILerror &error) const;
+        const char *lookupGlobalComment(const char *relPathToEntry, STILerror &error) const;
+        const char *lookupBug(const char *relPathToEntry, STILerror &error) const;
 
         //
         // getError()
@@ -263,6 +284,11 @@ class STIL {
         //
         inline const char *getErrorStr() {return (STIL_ERROR_STR[lastError]);}
 
+        // Same as above, for an error returned by one of the lookup
+        // functions.
+        //
+        static inline const char *getErrorStr(STILerror error) {return (STIL_ERROR_STR[error]);}
+
     private:
 
         // Version number/copyright string
@@ -275,23 +301,29 @@ class STIL {
         char *baseDir;
         size_t baseDirLength;
 
-        // File handles
-        std::ifstream stilFile;
-        std::ifstream bugFile;
-
-        // Linked list of sections (subdirs) for easier positioning.
-        // NOTE: There's always at least one (empty) member on these
-        //  lists! (The pointers will never be NULL.)
-        struct dirList {
-            char *dirName;
-            std::streampos position;
-            struct dirList *next;
-        } *stilDirs, *bugDirs;
-
-        // This tells us what the line delimiter is in STIL.txt.
-        // (It may be two chars!)
-        char STIL_EOL;
-        char STIL_EOL2;
+        // Indexed copy of STIL.txt or BUGlist.txt. The lines are separated
+        // by '\n' whatever the EOL of the file is, and every empty line is
+        // replaced by a '\0'. That makes every entry a C string that starts
+        // with its pathname line, so that entries can be returned without
+        // copying them. The entries are found through an open addressing
+        // hash table keyed on the case-insensitive pathname.
+        // The image holds a header, the hash table and the text. It is
+        // saved next to the text file and mapped into memory by the next
+        // program that needs it, as long as the text file is not changed.
+        struct indexBucket {
+            uint32_t hash;
+            uint32_t offset;     // start of the entry in text
+            uint32_t keyLength;  // length of the pathname, 0 if unused
+        };
+        struct indexedFile {
+            char *image;
+            size_t imageSize;
+            bool imageMapped;
+            const indexBucket *buckets;
+            uint32_t bucketCount;  // power of two, 0 if no entries
+            const char *text;
+            size_t textLength;
+        } stilData, bugData;
 
         // Error number of the last error that happened.
         STILerror lastError;
@@ -301,15 +333,6 @@ class STIL {
 
         ////////////////
 
-        // The last retrieved entry
-        char entrybuf[STIL_MAX_ENTRY_SIZE];
-
-        // The last retrieved section-global comment
-        char globalbuf[STIL_MAX_ENTRY_SIZE];
-
-        // The last retrieved BUGentry
-        char bugbuf[STIL_MAX_ENTRY_SIZE];
-
         // Buffers to hold the resulting strings
         char resultEntry[STIL_MAX_ENTRY_SIZE];
         char resultBug[STIL_MAX_ENTRY_SIZE];
@@ -317,82 +340,116 @@ class STIL {
         ////////////////
 
         //
-        // determineEOL()
+        // loadIndex()
         //
-        // FUNCTION: Determines what the EOL char is (or are) from STIL.txt.
-        //           It is assumed that BUGlist.txt will use the same EOL.
+        // FUNCTION: Loads the saved index of STIL.txt or BUGlist.txt if it
+        //           was created from the current version of the text file.
+        //           For STIL.txt it also restores the STIL version number.
         // ARGUMENTS:
-        //      NONE
+        //      fileName   - the text file
+        //      isSTILFile - is this the STIL or the BUGlist we are loading
+        //      data       - where to put the index
         // RETURNS:
-        //      false - something went wrong
+        //      false - there is no valid index
         //      true  - everything is okay
         //
-        bool determineEOL();
+        bool loadIndex(const char *fileName, bool isSTILFile, indexedFile &data);
 
         //
-        // getDirs()
+        // buildIndex()
         //
-        // FUNCTION: Populates the given dirList array with the directories
-        //           obtained from 'inFile' for faster positioning within
-        //           'inFile'.
+        // FUNCTION: Reads STIL.txt or BUGlist.txt, finds the sections
+        //           (subdirs) in it and indexes all entries within them, so
+        //           that they are found exactly as by scanning the section
+        //           of a requested entry. For STIL.txt it also extracts the
+        //           STIL version number.
         // ARGUMENTS:
-        //      inFile - where to read the directories from
-        //      dirs   - the dirList array that should be populated with the
-        //               directory list
-        //      isSTILFile - is this the STIL or the BUGlist we are parsing
+        //      fileName   - the text file
+        //      isSTILFile - is this the STIL or the BUGlist we are indexing
+        //      data       - where to put the index
         // RETURNS:
-        //      false - No entries were found or otherwise failed to process
-        //              inFile
-        //      true  - everything is okay
+        //      NO_STIL_ERROR - everything is okay
+        //      STIL_OPEN     - the file could not be read
+        //      NO_EOL        - no EOL char was found on the first line
+        //      NO_STIL_DIRS  - no entries were found, 'data' holds the
+        //                      empty index
         //
-        bool getDirs(std::ifstream& inFile, dirList *dirs, bool isSTILFile);
+        STILerror buildIndex(const char *fileName, bool isSTILFile, indexedFile &data);
 
         //
-        // positionToEntry()
+        // saveIndex()
         //
-        // FUNCTION: Positions the file pointer to the given entry in 'inFile'
-        //           using the 'dirs' dirList for faster positioning.
+        // FUNCTION: Saves the index of a text file for loadIndex().
+        //           Failures are ignored, the index is only a cache.
         // ARGUMENTS:
-        //      entryStr - the entry to position to
-        //      inFile   - position the file pointer in this file
-        //      dirs     - the list of dirs in inFile for easier positioning
+        //      fileName - the text file
+        //      data     - the index
         // RETURNS:
-        //      true - if successful
-        //      false - otherwise
-        bool positionToEntry(const char *entryStr, std::ifstream& inFile, dirList *dirs);
+        //      NONE
+        //
+        void saveIndex(const char *fileName, const indexedFile &data);
 
         //
-        // readEntry()
+        // findEntry()
         //
-        // FUNCTION: Reads the entry from 'inFile' into 'buffer'. 'inFile' should
-        //           already be positioned to the entry to be read.
+        // FUNCTION: Looks up an entry or a section-global comment.
         // ARGUMENTS:
-        //      inFile   - filehandle of file to read from
-        //      entryStr - the entry needed to be read
-        //      buffer   - where to put the result to
+        //      data        - the indexed file to search
+        //      entryStr    - pathname of the entry, ending with a slash for
+        //                    a section-global comment
+        //      entryStrLen - length of the pathname, so that the dir of a
+        //                    longer pathname can be looked up in place
+        // RETURNS:
+        //      NULL   - the entry was not found
+        //      char * - the entry, starting with its pathname line
+        //
+        const char *findEntry(const indexedFile &data, const char *entryStr, size_t entryStrLen) const;
+
+        //
+        // freeIndexedFile()
+        //
+        // FUNCTION: Frees the memory of an indexed file and empties it.
+        // ARGUMENTS:
+        //      data - the indexed file
         // RETURNS:
         //      NONE
-        void readEntry(std::ifstream& inFile, char *buffer);
+        //
+        void freeIndexedFile(indexedFile &data);
+
+        //
+        // getWholeEntry()
+        //
+        // FUNCTION: Skips the pathname line of an entry found by
+        //           findEntry(), which is what getField() returns for
+        //           tuneNo=0 and field=all.
+        // ARGUMENTS:
+        //      entry - the entry, starting with its pathname line
+        // RETURNS:
+        //      NULL   - if this is a NULL entry
+        //      char * - the fields of the entry
+        //
+        static const char *getWholeEntry(const char *entry);
 
         //
         // getField()
         //
         // FUNCTION: Given a STIL formatted entry in 'buffer', a tune number,
         //           and a field designation, it returns the requested
-        //           STIL field into 'result'.
-        //           If field=all, it also puts the file-global comment (if it exists)
-        //           as the first field into 'result'.
+        //           STIL field. When the field is a contiguous part of
+        //           'buffer' that ends with the entry, a pointer into
+        //           'buffer' is returned, otherwise the field is copied into
+        //           'result'.
         // ARGUMENTS:
-        //      result - where to put the resulting string to (if any)
+        //      result - where to put the resulting string to (if needed)
         //      buffer - pointer to the first char of what to search for
         //               the field. Should be a buffer in standard STIL
         //               format.
         //      tuneNo - song number within the song (default=0)
         //      field  - which field to retrieve (default=all).
         // RETURNS:
-        //      false - if nothing was put into 'result'
-        //      true  - 'result' has the resulting field
-        bool getField(char *result, char *buffer, int tuneNo=0, STILField field=all);
+        //      NULL   - if nothing was found
+        //      char * - the resulting field
+        const char *getField(char *result, const char *buffer, int tuneNo=0, STILField field=all);
 
         //
         // getOneField()
@@ -409,60 +466,7 @@ class STIL {
         // RETURNS:
         //      false - if nothing was put into 'result'
         //      true  - 'result' has the resulting field
-        bool getOneField(char *result, char *start, char *end, STILField field);
-
-        //
-        // getStilLine()
-        //
-        // FUNCTION: Extracts one line from 'infile' to 'line[]'. The end of
-        //           the line is marked by endOfLineChar. Also eats up
-        //           additional EOL-like chars.
-        // ARGUMENTS:
-        //      infile - filehandle (streampos should already be positioned
-        //               to the start of the desired line)
-        //      line   - char array to put the line into
-        // RETURNS:
-        //      NONE
-        void getStilLine(std::ifstream& infile, char *line);
-
-        //
-        // deleteDirList()
-        //
-        // FUNCTION: Deletes *all* of the linked list of dirnames. Assumes that
-        //           there is at least one element on the linked list!
-        // ARGUMENTS:
-        //      dirs - pointer to the head of the linked list to be deleted.
-        // RETURNS:
-        //      NONE (Maybe it should return a bool for error-checking purposes?)
-        //
-        void deleteDirList(dirList *dirs);
-
-        //
-        // copyDirList()
-        //
-        // FUNCTION: Copies the linked list of dirnames from one linked list
-        //           to another. It creates new dirlist entries in the
-        //           destination list as needed. Assumes that there is at least
-        //           one element on the source *and* destination linked lists!
-        // ARGUMENTS:
-        //      toPtr - pointer to the head of the destination linked list
-        //      fromPtr - pointer to the head of the source linked list
-        // RETURNS:
-        //      NONE (Maybe it should return a bool for error-checking purposes?)
-        //
-        void copyDirList(dirList *toPtr, dirList *fromPtr);
-
-        //
-        // createOneDir()
-        //
-        // FUNCTION: Creates a new dirlist entry (allocates memory for it), and
-        //           returns a pointer to this new entry.
-        // ARGUMENTS:
-        //      NONE
-        // RETURNS:
-        //      dirList * - pointer to the newly created entry
-        //
-        inline dirList *createOneDir(void);
+        bool getOneField(char *result, const char *start, const char *end, STILField field);
 };
 
 #endif // _STIL_H
@@ -286,6 +286,13 @@ bool SidTune::placeSidTuneInC64mem(uint_least8_t* c64buf)
     return ( status && c64buf!=0 );
 }
 
+const uint_least8_t* SidTune::getC64Data() const
+{
+    if ( !status )
+        return 0;
+    return cache.get()+fileOffset;
+}
+
 bool SidTune::loadFile(const char* fileName, Buffer_sidtt<const uint_least8_t>& bufferRef)
 {
     Buffer_sidtt<const uint_least8_t> fileBuf;
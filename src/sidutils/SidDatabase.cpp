@@ -17,10 +17,24 @@
  ***************************************************************************/
 
 #include <ctype.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "config.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+#include <sys/mman.h>
+#define SIDDATABASE_USE_MMAP
+#endif
+
 #include "SidDatabase.h"
 #include "MD5/MD5.h"
 
@@ -31,6 +45,75 @@ const char *SidDatabase::ERR_MEM_ALLOC               = "SID DATABASE ERROR: Memo
 const char *SidDatabase::ERR_UNABLE_TO_LOAD_DATABASE = "SID DATABASE ERROR: Unable to load the songlength database.";
 
 
+// Layout of the song length index file. All values are stored in the
+// byte order of the machine that created the file, an index created on a
+// machine with a different byte order is rebuilt.
+static const char  INDEX_MAGIC[8]   = { 'S', 'L', 'D', 'B', 'I', 'D', 'X', '1' };
+static const char *INDEX_SUFFIX     = ".idx";
+static const uint32_t INDEX_BYTE_ORDER = 0x01020304;
+static const uint32_t INDEX_EMPTY   = 0xffffffff;  // first of unused bucket
+static const int   TIMESTAMP_LENGTH = 10;          // includes terminator
+
+struct IndexHeader
+{
+    char     magic[8];
+    uint32_t byteOrder;
+    uint32_t bucketCount;   // power of two
+    uint32_t lengthCount;
+    uint32_t reserved;
+    uint64_t dbSize;        // size of the database file
+    int64_t  dbTime;        // modification time of the database file
+};
+
+struct IndexBucket
+{
+    uint8_t  md5[16];
+    uint32_t first;         // index of the first song length
+    uint32_t count;         // number of valid song lengths
+};
+
+
+static int hexValue (char ch)
+{
+    if ((ch >= '0') && (ch <= '9'))
+        return ch - '0';
+    if ((ch >= 'a') && (ch <= 'f'))
+        return ch - 'a' + 10;
+    if ((ch >= 'A') && (ch <= 'F'))
+        return ch - 'A' + 10;
+    return -1;
+}
+
+// Convert a 32 digit hexadecimal MD5 string to binary.
+static bool parseMD5 (const char *str, size_t len, uint8_t md5[16])
+{
+    if (len != 32)
+        return false;
+    for (int i = 0; i < 16; i++)
+    {
+        int hi = hexValue (str[2 * i]);
+        int lo = hexValue (str[2 * i + 1]);
+        if ((hi < 0) || (lo < 0))
+            return false;
+        md5[i] = (uint8_t) ((hi << 4) | lo);
+    }
+    return true;
+}
+
+// The MD5 fingerprint is evenly distributed, so any part of it can be used
+// as hash value.
+static uint32_t hashMD5 (const uint8_t md5[16])
+{
+    return ((uint32_t) md5[0] << 24) | ((uint32_t) md5[1] << 16)
+         | ((uint32_t) md5[2] << 8) | (uint32_t) md5[3];
+}
+
+static bool isSpace (char ch)
+{
+    return (ch == ' ') || (ch == '\t') || (ch == '\r');
+}
+
+
 SidDatabase::~SidDatabase ()
 {
     close ();
@@ -90,11 +173,253 @@ uint_least8_t SidDatabase::timesFound (char *str)
 }
 
 
+bool SidDatabase::loadIndex (const char *indexName, uint_least64_t dbSize,
+                             int_least64_t dbTime)
+{
+    struct stat st;
+    if (stat (indexName, &st) != 0)
+        return false;
+    size_t size = (size_t) st.st_size;
+    if (size < sizeof (IndexHeader))
+        return false;
+
+    FILE *fp = fopen (indexName, "rb");
+    if (!fp)
+        return false;
+
+    // Check the header before mapping the whole file
+    IndexHeader header;
+    bool valid = (fread (&header, sizeof (header), 1, fp) == 1)
+        && (memcmp (header.magic, INDEX_MAGIC, sizeof (INDEX_MAGIC)) == 0)
+        && (header.byteOrder == INDEX_BYTE_ORDER)
+        && (header.bucketCount > 0)
+        && ((header.bucketCount & (header.bucketCount - 1)) == 0)
+        && (header.dbSize == dbSize) && (header.dbTime == dbTime)
+        && (size == sizeof (IndexHeader)
+                    + header.bucketCount * sizeof (IndexBucket)
+                    + header.lengthCount * sizeof (uint16_t));
+    if (!valid)
+    {
+        fclose (fp);
+        return false;
+    }
+
+#ifdef SIDDATABASE_USE_MMAP
+    void *data = mmap (NULL, size, PROT_READ, MAP_SHARED, fileno (fp), 0);
+    fclose (fp);
+    if (data == MAP_FAILED)
+        return false;
+    index       = (uint8_t *) data;
+    indexMapped = true;
+#else
+    index = new uint8_t[size];
+    rewind (fp);
+    valid = (fread (index, size, 1, fp) == 1);
+    fclose (fp);
+    if (!valid)
+    {
+        delete[] index;
+        index = 0;
+        return false;
+    }
+    indexMapped = false;
+#endif
+    indexSize = size;
+    return true;
+}
+
+
+bool SidDatabase::buildIndex (const char *filename, uint_least64_t dbSize,
+                              int_least64_t dbTime)
+{
+    FILE *fp = fopen (filename, "rb");
+    if (!fp)
+        return false;
+    char *text = new char[dbSize + 1];
+    bool ok = (dbSize == 0) || (fread (text, dbSize, 1, fp) == 1);
+    fclose (fp);
+    if (!ok)
+    {
+        delete[] text;
+        return false;
+    }
+    text[dbSize] = '\0';
+
+    // Count the entries and song lengths to size the tables. Every MD5 key
+    // needs at least 34 characters, so this never underestimates.
+    uint32_t keyCount    = 0;
+    uint32_t lengthCount = 0;
+    for (const char *p = text; *p; p++)
+    {
+        if (*p == '=')
+            keyCount++;
+        else if (*p == ' ')
+            lengthCount++;
+    }
+    lengthCount += keyCount;
+
+    uint32_t bucketCount = 16;
+    while (bucketCount < keyCount * 2)
+        bucketCount <<= 1;
+
+    size_t size = sizeof (IndexHeader) + bucketCount * sizeof (IndexBucket)
+                + lengthCount * sizeof (uint16_t);
+    index       = new uint8_t[size];
+    indexSize   = size;
+    indexMapped = false;
+    memset (index, 0, size);
+
+    IndexHeader *header  = (IndexHeader *) index;
+    IndexBucket *buckets = (IndexBucket *) (index + sizeof (IndexHeader));
+    uint16_t    *lengths = (uint16_t *) (buckets + bucketCount);
+    for (uint32_t i = 0; i < bucketCount; i++)
+        buckets[i].first = INDEX_EMPTY;
+
+    // Parse the [Database] section: lines of the form md5=time time ...
+    // The times are validated as they would be read back one by one, the
+    // list of an entry ends at the first time stamp that is invalid.
+    uint32_t used     = 0;
+    bool     database = false;
+    char    *line     = text;
+    while (*line)
+    {
+        char *next = line + strcspn (line, "\n");
+        if (*next)
+            *next++ = '\0';
+        while (isSpace (*line))
+            line++;
+
+        char *end = line + strlen (line);
+        while ((end > line) && isSpace (end[-1]))
+            *--end = '\0';
+
+        if (*line == '[')
+        {
+            char *close = strchr (line, ']');
+            database = (close != NULL) && (close - line - 1 == 8)
+                && (strncasecmp (line + 1, "Database", 8) == 0);
+        }
+        else if (database && *line && (*line != ';'))
+        {
+            char *value = strchr (line, '=');
+            uint8_t md5[16];
+            if (value)
+            {
+                char *key_end = value++;
+                while ((key_end > line) && isSpace (key_end[-1]))
+                    key_end--;
+                while (isSpace (*value))
+                    value++;
+
+                if (parseMD5 (line, key_end - line, md5))
+                {
+                    uint32_t slot = hashMD5 (md5) & (bucketCount - 1);
+                    while ((buckets[slot].first != INDEX_EMPTY)
+                           && (memcmp (buckets[slot].md5, md5, 16) != 0))
+                    {
+                        slot = (slot + 1) & (bucketCount - 1);
+                    }
+
+                    // The last entry of a duplicated key is used
+                    IndexBucket &bucket = buckets[slot];
+                    memcpy (bucket.md5, md5, 16);
+                    bucket.first = used;
+                    bucket.count = 0;
+
+                    char *token = value;
+                    while (*token)
+                    {
+                        size_t len = strcspn (token, " ");
+                        char timeStamp[TIMESTAMP_LENGTH];
+                        size_t copy = (len < sizeof (timeStamp))
+                            ? len : sizeof (timeStamp) - 1;
+                        memcpy (timeStamp, token, copy);
+                        timeStamp[copy] = '\0';
+                        if (timesFound (timeStamp) != 1)
+                            break;
+
+                        // Lengths beyond 18 hours are clipped
+                        int_least32_t seconds = parseTimeStamp (timeStamp);
+                        lengths[used++] = (uint16_t)
+                            ((seconds > 0xffff) ? 0xffff : seconds);
+                        bucket.count++;
+
+                        token += len;
+                        while (*token == ' ')
+                            token++;
+                    }
+                }
+            }
+        }
+        line = next;
+    }
+    delete[] text;
+
+    memcpy (header->magic, INDEX_MAGIC, sizeof (INDEX_MAGIC));
+    header->byteOrder   = INDEX_BYTE_ORDER;
+    header->bucketCount = bucketCount;
+    header->lengthCount = used;
+    header->dbSize      = dbSize;
+    header->dbTime      = dbTime;
+
+    // Drop the unused part of the estimated length table
+    indexSize = sizeof (IndexHeader) + bucketCount * sizeof (IndexBucket)
+              + used * sizeof (uint16_t);
+    return true;
+}
+
+
+void SidDatabase::saveIndex (const char *indexName)
+{
+    // Write to a temporary file first so that other processes never see a
+    // partially written index. Failures are not fatal, e.g. the directory
+    // of a shared HVSC copy may be read-only.
+    char *tmpName = new char[strlen (indexName) + 32];
+#ifdef HAVE_UNISTD_H
+    sprintf (tmpName, "%s.%ld", indexName, (long) getpid ());
+#else
+    sprintf (tmpName, "%s.tmp", indexName);
+#endif
+
+    FILE *fp = fopen (tmpName, "wb");
+    if (fp)
+    {
+        bool ok = (fwrite (index, indexSize, 1, fp) == 1);
+        ok = (fclose (fp) == 0) && ok;
+        if (!ok || (rename (tmpName, indexName) != 0))
+            remove (tmpName);
+    }
+    delete[] tmpName;
+}
+
+
 int SidDatabase::open (const char *filename)
 {
     close ();
-    database = ini_open (filename, "r", ";");
-    if (!database)
+
+    struct stat st;
+    if ((stat (filename, &st) != 0) || !S_ISREG (st.st_mode))
+    {
+        errorString = ERR_UNABLE_TO_LOAD_DATABASE;
+        return -1;
+    }
+
+    char *indexName = new char[strlen (filename) + strlen (INDEX_SUFFIX) + 1];
+    strcpy (indexName, filename);
+    strcat (indexName, INDEX_SUFFIX);
+
+    const uint_least64_t dbSize = (uint_least64_t) st.st_size;
+    const int_least64_t  dbTime = (int_least64_t) st.st_mtime;
+    bool ok = loadIndex (indexName, dbSize, dbTime);
+    if (!ok)
+    {
+        ok = buildIndex (filename, dbSize, dbTime);
+        if (ok)
+            saveIndex (indexName);
+    }
+    delete[] indexName;
+
+    if (!ok)
     {
         errorString = ERR_UNABLE_TO_LOAD_DATABASE;
         return -1;
@@ -105,8 +430,18 @@ int SidDatabase::open (const char *filename)
 
 void SidDatabase::close ()
 {
-    if (database)
-        ini_close (database);
+    if (index)
+    {
+#ifdef SIDDATABASE_USE_MMAP
+        if (indexMapped)
+            munmap (index, indexSize);
+        else
+#endif
+            delete[] index;
+    }
+    index       = 0;
+    indexSize   = 0;
+    indexMapped = false;
 }
 
 int_least32_t SidDatabase::length (SidTuneMod &tune)
@@ -122,50 +457,77 @@ int_least32_t SidDatabase::length (SidTuneMod &tune)
     return length  (md5, song);
 }
 
-int_least32_t SidDatabase::length (const char *md5, uint_least16_t song)
+// Returns the song lengths of an MD5 fingerprint or NULL when not found.
+const uint16_t *SidDatabase::findEntry (const char *md5,
+                                        uint32_t &count) const
 {
-    int_least32_t  time = 0;
+    uint8_t key[16];
+    if (!parseMD5 (md5, strlen (md5), key))
+        return NULL;
 
-    if (!database)
+    const IndexHeader *header  = (const IndexHeader *) index;
+    const IndexBucket *buckets =
+        (const IndexBucket *) (index + sizeof (IndexHeader));
+    const uint16_t    *lengths =
+        (const uint16_t *) (buckets + header->bucketCount);
+
+    const uint32_t mask = header->bucketCount - 1;
+    uint32_t slot = hashMD5 (key) & mask;
+    for (uint32_t probes = 0; probes <= mask; probes++)
     {
-        errorString = ERR_NO_DATABASE_LOADED;
-        return -1;
+        const IndexBucket &bucket = buckets[slot];
+        if (bucket.first == INDEX_EMPTY)
+            break;
+        if (memcmp (bucket.md5, key, 16) == 0)
+        {
+            if (bucket.first + bucket.count > header->lengthCount)
+                break;
+            count = bucket.count;
+            return lengths + bucket.first;
+        }
+        slot = (slot + 1) & mask;
     }
 
-    // Now set up array access
-    if (ini_listDelims  (database, " ") == -1)
+    return NULL;
+}
+
+int_least32_t SidDatabase::length (const char *md5, uint_least16_t song)
+{
+    if (!index)
     {
-        errorString = ERR_MEM_ALLOC;
+        errorString = ERR_NO_DATABASE_LOADED;
         return -1;
     }
 
-    // Read Time (and check times before hand)
-    (void) ini_locateHeading (database, "Database");
-    (void) ini_locateKey     (database, md5);
-    // If length return is -1 then no entry found in database
-    if ((song > 0) && (ini_dataLength (database) != -1))
-    {
-        char timeStamp[10];
-
-        for (uint_least16_t i = 0; i < song; i++)
-        {
-            if (ini_readString (database, timeStamp, sizeof (timeStamp)) == -1)
-            {   // No time found
-                errorString = ERR_DATABASE_CORRUPT;
-                return -1;
-            }
+    uint32_t count = 0;
+    const uint16_t *times = findEntry (md5, count);
+    // If no entry found in database the length is 0
+    if (!times || (song == 0))
+        return 0;
+    if (song > count)
+    {   // No time found
+        errorString = ERR_DATABASE_CORRUPT;
+        return -1;
+    }
+    return times[song - 1];
+}
 
-            // Validate Time
-            if (timesFound (timeStamp) != 1)
-            {
-                errorString = ERR_DATABASE_CORRUPT;
-                return -1;
-            }
-        }
+int SidDatabase::lengths (const char *md5, int_least32_t *lengths,
+                          uint_least16_t songs) const
+{
+    if (!index)
+        return -1;
 
-        // Parse timestamp
-        time = parseTimeStamp (timeStamp);
+    uint32_t count = 0;
+    const uint16_t *times = findEntry (md5, count);
+    for (uint_least16_t i = 0; i < songs; i++)
+    {
+        if (!times)
+            lengths[i] = 0;
+        else if (i < count)
+            lengths[i] = times[i];
+        else // No time found, the database is corrupt
+            lengths[i] = -1;
     }
-
-    return time;
+    return 0;
 }